@@ -762,6 +762,20 @@ function _updateDeviceConfigUI(config) {
                 apiKeyField.value = config.api_key_display;
             }
         }
+        if (config.refresh_minutes !== undefined) {
+            const refreshField = document.getElementById('refreshMinutes');
+            // 0 means automatic, shown as the empty placeholder
+            if (refreshField && !refreshField.value && config.refresh_minutes > 0) {
+                refreshField.value = config.refresh_minutes;
+            }
+        }
+        if (config.dashboard_id !== undefined) {
+            const dashboardField = document.getElementById('dashboardId');
+            // 0 means no dashboard, shown as the empty placeholder
+            if (dashboardField && !dashboardField.value && config.dashboard_id > 0) {
+                dashboardField.value = config.dashboard_id;
+            }
+        }
         if (config.region !== undefined) {
             // Handle region - set radio button or dropdown depending on UI
             const regionRadios = document.querySelectorAll('input[name="region"]');
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "ui/UICallback.h"
+
+/**
+ * @brief Type-erased base for requests carried on an Event
+ *
+ * Lets EventQueue move and merge requests without knowing their result type.
+ */
+class AsyncRequestBase : public std::enable_shared_from_this<AsyncRequestBase> {
+public:
+    virtual ~AsyncRequestBase() = default;
+
+    /**
+     * @brief Stop the callback from running; safe from any task
+     */
+    void cancel() { _cancelled = true; }
+
+    /**
+     * @brief Check whether the requester has gone away
+     */
+    bool isCancelled() const { return _cancelled; }
+
+    /**
+     * @brief Take over an identical request that was merged into this one
+     *
+     * The merged request receives the same result when this one completes.
+     * Both requests must have the same result type, which holds because
+     * EventQueue only merges events of the same type.
+     *
+     * @param other Request whose event was replaced by this one's
+     */
+    void adopt(std::shared_ptr<AsyncRequestBase> other) {
+        if (other && other.get() != this) {
+            _followers.push_back(std::move(other));
+        }
+    }
+
+    /**
+     * @brief Answer with success=false because no handler will complete this
+     *
+     * Used when the request's event was dropped. Ignored if the request was
+     * already answered.
+     */
+    void abandon() {
+        if (!_answered.exchange(true)) {
+            park(shared_from_this());
+        }
+    }
+
+    /**
+     * @brief Deliver success=false to requests that couldn't be dispatched
+     *
+     * Called on every pass of the LVGL task's UI queue. Parked requests need no
+     * room in that queue, so a requester always hears back even if it was full.
+     */
+    static void deliverParked() {
+        std::vector<std::shared_ptr<AsyncRequestBase>> parked;
+        {
+            std::lock_guard<std::mutex> lock(_parkedMutex);
+            if (_parked.empty()) {
+                return;
+            }
+            parked.swap(_parked);
+        }
+        for (auto& request : parked) {
+            request->fail();
+        }
+    }
+
+protected:
+    /**
+     * @brief Run the callbacks with success=false; LVGL task only
+     */
+    virtual void fail() = 0;
+
+    static void park(std::shared_ptr<AsyncRequestBase> request) {
+        std::lock_guard<std::mutex> lock(_parkedMutex);
+        _parked.push_back(std::move(request));
+    }
+
+    std::atomic<bool> _cancelled{false};
+    std::atomic<bool> _answered{false};
+    std::vector<std::shared_ptr<AsyncRequestBase>> _followers;
+
+private:
+    inline static std::mutex _parkedMutex;
+    inline static std::vector<std::shared_ptr<AsyncRequestBase>> _parked;
+};
+
+/**
+ * @brief A single request with a typed result, answered on the LVGL task
+ *
+ * The requester supplies the callback when it publishes the request; the
+ * handler calls complete() once with the typed result. The callback is
+ * delivered through globalUIDispatch, so it runs on the LVGL task and may
+ * touch the requester's LVGL objects directly. A cancelled request's callback
+ * never runs. Cards are deleted on the LVGL task too, so cancel() from a
+ * card's destructor can't race with delivery.
+ *
+ * @tparam Result Result payload type, e.g. WeatherData
+ */
+template <typename Result>
+class AsyncRequest : public AsyncRequestBase {
+public:
+    using Callback = std::function<void(bool success, const Result& result)>;
+
+    explicit AsyncRequest(Callback callback) : _callback(std::move(callback)) {}
+
+    /**
+     * @brief Deliver the result to this request and any merged followers
+     *
+     * Waits briefly for room in the UI queue. If the result still can't be
+     * dispatched, the request is answered with success=false instead, so
+     * neither the requester nor its followers wait forever.
+     *
+     * @param success Whether the handler produced a usable result
+     * @param result Typed result; moved to the LVGL task, not copied per follower
+     */
+    void complete(bool success, Result result) {
+        if (_answered.exchange(true)) {
+            return;
+        }
+
+        auto self = std::static_pointer_cast<AsyncRequest<Result>>(shared_from_this());
+        auto shared = std::make_shared<Result>(std::move(result));
+        for (int attempt = 0; attempt < DISPATCH_ATTEMPTS; attempt++) {
+            if (attempt > 0) {
+                vTaskDelay(pdMS_TO_TICKS(DISPATCH_RETRY_MS));
+            }
+            if (globalUIDispatch && globalUIDispatch([self, success, shared]() {
+                    self->deliver(success, *shared);
+                }, false)) {
+                return;
+            }
+        }
+
+        Serial.println("[AsyncRequest] UI queue unavailable, answering with failure");
+        park(self);
+    }
+
+protected:
+    void fail() override {
+        deliver(false, Result());
+    }
+
+private:
+    static constexpr int DISPATCH_ATTEMPTS = 5;
+    static constexpr uint32_t DISPATCH_RETRY_MS = 20;
+
+
+    void deliver(bool success, const Result& result) {
+        if (!_cancelled && _callback) {
+            _callback(success, result);
+        }
+        for (auto& follower : _followers) {
+            std::static_pointer_cast<AsyncRequest<Result>>(follower)->deliver(success, result);
+        }
+    }
+
+    Callback _callback;
+};
+
+/**
+ * @brief RAII owner of an outstanding request
+ *
+ * Held by the requester as a member. Destroying the handle, or replacing it
+ * with a newer request, cancels the old request so its callback never runs
+ * against a deleted or superseded requester.
+ */
+class AsyncRequestHandle {
+public:
+    AsyncRequestHandle() = default;
+    explicit AsyncRequestHandle(std::shared_ptr<AsyncRequestBase> request) : _request(std::move(request)) {}
+    ~AsyncRequestHandle() { cancel(); }
+
+    AsyncRequestHandle(AsyncRequestHandle&& other) noexcept = default;
+    AsyncRequestHandle& operator=(AsyncRequestHandle&& other) noexcept {
+        if (this != &other) {
+            cancel();
+            _request = std::move(other._request);
+        }
+        return *this;
+    }
+
+    AsyncRequestHandle(const AsyncRequestHandle&) = delete;
+    AsyncRequestHandle& operator=(const AsyncRequestHandle&) = delete;
+
+    /**
+     * @brief Cancel the outstanding request, if any
+     */
+    void cancel() {
+        if (_request) {
+            _request->cancel();
+            _request.reset();
+        }
+    }
+
+private:
+    std::shared_ptr<AsyncRequestBase> _request;
+};
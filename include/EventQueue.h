@@ -4,11 +4,17 @@
 #include <functional>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <deque>
 #include <memory>
+#include <utility>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
-#include "posthog/parsers/InsightParser.h"
+#include <ArduinoJson.h>
+#include "posthog/InsightSnapshot.h"
+#include "AsyncRequest.h"
 
 /**
  * @brief Event types in the system
@@ -26,36 +32,116 @@ enum class EventType {
     OTA_PROCESS_END,
     CARD_CONFIG_CHANGED,
     CARD_TITLE_UPDATED,
-    TIME_SYNC_REQUEST,
-    TIME_SYNC_COMPLETE,
-    WEATHER_REQUEST,
-    WEATHER_DATA_RECEIVED,
-    NOW_PLAYING_REQUEST,
-    NOW_PLAYING_DATA_RECEIVED
+    TIME_SYNC_REQUEST,      ///< Carries an AsyncRequest<bool>
+    WEATHER_REQUEST,        ///< Carries an AsyncRequest<WeatherData>
+    NOW_PLAYING_REQUEST,    ///< Carries an AsyncRequest<NowPlayingData>
+    EVENT_TYPE_COUNT    ///< Number of event types; not a real event
+};
+
+/**
+ * @brief Convert an EventType to a short name for logs and stats
+ */
+const char* eventTypeToString(EventType type);
+
+/**
+ * @brief Dispatch lanes of the event queue
+ */
+enum class EventLane {
+    CONTROL,    ///< Connectivity, config and user input; always dispatched first
+    BULK,       ///< Data payloads and network requests
+    LANE_COUNT  ///< Number of lanes; not a real lane
+};
+
+/**
+ * @brief Number of enqueue-to-dispatch latency histogram buckets
+ * 
+ * Bucket upper bounds are 1, 2, 5, 10, 20, 50, 100, 200 and 500ms; the last
+ * bucket counts everything slower.
+ */
+constexpr size_t EVENT_LATENCY_BUCKETS = 10;
+
+/**
+ * @brief Short label for a latency histogram bucket, e.g. "lt_5ms"
+ */
+const char* eventLatencyBucketLabel(size_t bucket);
+
+/**
+ * @brief Per-lane depth and latency metrics kept by EventQueue
+ */
+struct EventLaneStats {
+    size_t capacity;        ///< Slots reserved for the lane
+    uint32_t depth;         ///< Events currently waiting
+    uint32_t highWater;     ///< Most events ever waiting at once
+    uint32_t dispatched;    ///< Events dispatched since boot
+    uint32_t avgLatencyUs;  ///< Mean enqueue-to-dispatch latency
+    uint32_t maxLatencyUs;  ///< Worst enqueue-to-dispatch latency
+    uint32_t latencyHistogram[EVENT_LATENCY_BUCKETS]; ///< Dispatch counts per latency bucket
+};
+
+/**
+ * @brief How a subscriber's callback is run
+ */
+enum class DispatchMode {
+    INLINE,     ///< On the event task; must return quickly
+    BLOCKING    ///< On a worker task; may do network I/O or large parses
+};
+
+/**
+ * @brief Execution time figures for one subscriber
+ */
+struct EventSubscriberStats {
+    String name;            ///< Event type and key, e.g. "INSIGHT_DATA_RECEIVED:abc123"
+    bool blocking;          ///< Runs on the worker pool
+    uint32_t calls;         ///< Completed callback invocations
+    uint32_t avgUs;         ///< Mean callback execution time
+    uint32_t maxUs;         ///< Worst callback execution time
+    uint32_t dropped;       ///< Jobs discarded because its worker was backed up
+};
+
+/**
+ * @brief Per-type publish counters kept by EventQueue
+ */
+struct EventTypeStats {
+    uint32_t published;  ///< Events accepted into the queue
+    uint32_t merged;     ///< Events folded into an already pending event with the same key
+    uint32_t dropped;    ///< Events rejected because the queue was full
 };
 
 /**
  * @brief Represents an event in the system
+ * 
+ * Events are move-only: they own heap-backed Strings and a shared snapshot, so
+ * copying one is never cheap and byte-copying one is never safe. Publish with
+ * std::move() and the payload is handed to the queue without duplication.
  */
 struct Event {
     EventType type;                         // Type of event
     String insightId;                       // ID of the insight related to the event
-    std::shared_ptr<InsightParser> parser;  // Optional parsed insight data
+    std::shared_ptr<const InsightSnapshot> snapshot; // Insight data extracted from the response
     String jsonData;                        // Raw JSON data for insights
     String title;                           // Title/name for card title updates
     String cardId;                          // Generic card identifier
     String data;                            // Generic data payload
     bool success;                           // Success/failure flag
+    std::shared_ptr<AsyncRequestBase> request; // Optional typed request to complete
     
     Event() : success(false) {}
     
-    Event(EventType t, const String& id) : type(t), insightId(id), parser(nullptr), success(false) {}
+    Event(EventType t, const String& id) : type(t), insightId(id), snapshot(nullptr), success(false) {}
     
-    Event(EventType t, const String& id, std::shared_ptr<InsightParser> p)
-        : type(t), insightId(id), parser(p), success(false) {}
+    Event(EventType t, const String& id, std::shared_ptr<const InsightSnapshot> s)
+        : type(t), insightId(id), snapshot(std::move(s)), success(false) {}
         
     Event(EventType t, const String& id, const String& json)
-        : type(t), insightId(id), parser(nullptr), jsonData(json), success(false) {}
+        : type(t), insightId(id), snapshot(nullptr), jsonData(json), success(false) {}
+    
+    Event(EventType t, const String& id, String&& json)
+        : type(t), insightId(id), snapshot(nullptr), jsonData(std::move(json)), success(false) {}
+    
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+    Event(Event&&) = default;
+    Event& operator=(Event&&) = default;
         
     // Constructor for title update events
     static Event createTitleUpdateEvent(const String& id, const String& title_text) {
@@ -75,6 +161,25 @@ struct Event {
         e.success = is_success;
         return e;
     }
+    
+    /**
+     * @brief Typed view of the request carried by this event
+     * 
+     * @tparam Result Result type the publisher asked for
+     * @return The request, or nullptr if the event carries none
+     */
+    template <typename Result>
+    std::shared_ptr<AsyncRequest<Result>> requestAs() const {
+        return std::static_pointer_cast<AsyncRequest<Result>>(request);
+    }
+    
+    /**
+     * @brief Key used to route this event to keyed subscribers
+     * @return insightId when set, otherwise cardId
+     */
+    const String& routingKey() const {
+        return insightId.length() > 0 ? insightId : cardId;
+    }
 };
 
 /**
@@ -82,23 +187,200 @@ struct Event {
  */
 using EventCallback = std::function<void(const Event&)>;
 
+class EventQueue;
+
+/**
+ * @brief RAII handle for an EventQueue subscription
+ * 
+ * The subscription stays active for as long as the handle lives. Destroying or
+ * resetting the handle unsubscribes, and if the callback is currently running
+ * on the event task it waits for it to return, so an owner that holds its
+ * handle as a member can never be called back after its destructor starts.
+ */
+class EventSubscription {
+public:
+    EventSubscription() = default;
+    ~EventSubscription() { reset(); }
+    
+    EventSubscription(EventSubscription&& other) noexcept
+        : _queue(other._queue), _id(other._id) {
+        other._queue = nullptr;
+        other._id = 0;
+    }
+    
+    EventSubscription& operator=(EventSubscription&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _queue = other._queue;
+            _id = other._id;
+            other._queue = nullptr;
+            other._id = 0;
+        }
+        return *this;
+    }
+    
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+    
+    /**
+     * @brief Unsubscribe now; safe to call more than once
+     */
+    void reset();
+    
+    /**
+     * @brief Check whether this handle still owns a subscription
+     */
+    bool isActive() const { return _queue != nullptr; }
+
+private:
+    friend class EventQueue;
+    EventSubscription(EventQueue* queue, uint32_t id) : _queue(queue), _id(id) {}
+    
+    EventQueue* _queue = nullptr;
+    uint32_t _id = 0;
+};
+
 /**
  * @brief Thread-safe event queue for handling system events
+ * 
+ * Events live in fixed slot pools allocated once at construction. Publishing
+ * moves the event into a free slot and only the slot pointer travels through a
+ * FreeRTOS queue, so no C++ object is ever memcpy'd. The processing task owns
+ * the slot until dispatch completes, then resets it and returns it to its pool.
+ * 
+ * There are two lanes, each with its own pool and queue: CONTROL for
+ * connectivity, config and input events, and BULK for data payloads and
+ * network requests. The processing task always empties CONTROL before taking
+ * the next BULK event, and a flood of insight payloads can't use up the slots
+ * that a WiFi or config change needs.
+ * 
+ * Subscribers are routed by EventType and, optionally, by the event's routing
+ * key (insight ID or card ID). Dispatch only visits the wildcard subscribers of
+ * the event's type plus the subscribers registered for its key, so its cost
+ * does not grow with unrelated cards or with how often cards are rebuilt.
+ * 
+ * Request- and state-style events are coalesced by (type, routing key): while
+ * one is still pending, publishing another replaces its payload in place
+ * instead of taking a second slot. Repeated button presses or polling bursts
+ * therefore cost one dispatch and can't crowd other events out of the pool.
+ * 
+ * Subscribers that do network I/O or large parses subscribe with
+ * DispatchMode::BLOCKING. Their callbacks run on a small worker pool pinned to
+ * core 0, so the event task never waits on them. Each subscriber always lands
+ * on the same worker, which keeps its events in order. A slot stays alive
+ * until its last worker finishes with it. When a worker falls behind, its jobs
+ * are parked in order instead of stalling the event task; past a fixed limit
+ * they are dropped and counted against the subscriber.
  */
 class EventQueue {
 private:
-    QueueHandle_t eventQueue;
-    SemaphoreHandle_t callbackMutex;
-    std::vector<EventCallback> eventCallbacks;
+    struct Subscriber {
+        uint32_t id;
+        EventType type;
+        std::string key;            ///< Empty for type-wide subscribers
+        EventCallback callback;
+        DispatchMode mode;
+        bool active;
+        volatile uint16_t running;  ///< Invocations in progress
+        uint32_t calls;
+        uint64_t totalUs;
+        uint32_t maxUs;
+        uint32_t dropped;           ///< Worker jobs discarded while parked jobs were full
+    };
+    using SubscriberPtr = std::shared_ptr<Subscriber>;
+    
+    struct Route {
+        std::vector<SubscriberPtr> any;                                  ///< Type-wide subscribers
+        std::unordered_map<std::string, std::vector<SubscriberPtr>> byKey; ///< Keyed subscribers
+    };
+    
+    struct Lane;
+    
+    struct Slot {
+        Event event;
+        uint32_t enqueuedUs;        ///< micros() when the slot was first queued
+        std::atomic<uint8_t> refs;  ///< Event task plus outstanding worker jobs
+        Lane* lane;                 ///< Lane whose pool owns this slot
+    };
+    
+    struct WorkItem {
+        Slot* slot;
+        SubscriberPtr subscriber;
+    };
+    
+    struct Worker {
+        EventQueue* owner;
+        QueueHandle_t queue;            ///< WorkItem* ready to run; nullptr stops the worker
+        std::deque<WorkItem*> parked;   ///< Jobs waiting for room in queue, in order
+        TaskHandle_t task;
+    };
+    
+    struct Lane {
+        QueueHandle_t queue;        ///< Pending Slot* in FIFO order
+        QueueHandle_t freeSlots;    ///< Slot* available for publishing
+        Slot* pool;                 ///< Backing storage for the lane's slots
+        size_t size;                ///< Number of slots in pool
+        uint32_t highWater;
+        uint32_t dispatched;
+        uint64_t totalLatencyUs;
+        uint32_t maxLatencyUs;
+        uint32_t latencyHistogram[EVENT_LATENCY_BUCKETS];
+    };
+    
+    Lane lanes[static_cast<size_t>(EventLane::LANE_COUNT)];
+    SemaphoreHandle_t callbackMutex;  ///< Guards routes, subscribers and their counters
+    Route routes[static_cast<size_t>(EventType::EVENT_TYPE_COUNT)];
+    std::unordered_map<uint32_t, SubscriberPtr> subscribers; ///< All live subscribers by ID
+    std::vector<SubscriberPtr> dispatchScratch;  ///< Reused by the event task only
+    uint32_t nextSubscriberId;
+    
+    static constexpr uint32_t DRAIN_BUDGET_US = 20000;  ///< Max time per batch before yielding
+    static constexpr size_t WORKER_COUNT = 2;
+    static constexpr size_t WORKER_QUEUE_SIZE = 16;
+    static constexpr size_t WORKER_PARK_LIMIT = 32;  ///< Parked jobs per worker before dropping
+    Worker workers[WORKER_COUNT];
+    SemaphoreHandle_t parkMutex;     ///< Guards each worker's parked jobs
+    SemaphoreHandle_t taskExited;    ///< Given by the event task and each worker as they exit
+    
+    SemaphoreHandle_t pendingMutex;  ///< Guards pending, typeStats and lane metrics
+    std::unordered_map<std::string, Slot*> pending[static_cast<size_t>(EventType::EVENT_TYPE_COUNT)]; ///< Queued coalescable events by key
+    EventTypeStats typeStats[static_cast<size_t>(EventType::EVENT_TYPE_COUNT)];
+    
+    static bool isCoalescable(EventType type);
+    static std::string coalesceKey(const Event& event);
+    void releasePending(Slot* slot);
+    bool takeNextSlot(Slot*& slot);
+    void recordDispatch(Lane& lane, uint32_t latencyUs);
+    void releaseSlot(Slot* slot);
+    
+    friend class EventSubscription;
+    EventSubscription addSubscriber(EventType type, const String& key, EventCallback callback, DispatchMode mode);
+    void unsubscribe(uint32_t id);
+    void dispatch(Slot* slot);
+    void invoke(Subscriber& subscriber, const Event& event);
+    bool enqueueWork(Worker& worker, WorkItem* item, bool force);
+    void refillWorker(Worker& worker);
     
     static void eventProcessingTask(void* parameter);
+    static void workerTask(void* parameter);
     TaskHandle_t taskHandle;
     bool isRunning;
     
 public:
-    EventQueue(size_t queueSize = 10);
+    /**
+     * @brief Create the queue and its lane pools
+     * 
+     * @param controlSize Slots for CONTROL lane events
+     * @param bulkSize Slots for BULK lane events
+     */
+    EventQueue(size_t controlSize = 8, size_t bulkSize = 12);
     ~EventQueue();
     
+    /**
+     * @brief Lane an event type is dispatched on
+     */
+    static EventLane laneFor(EventType type);
+    
     /**
      * @brief Publish an event to the queue
      * 
@@ -110,35 +392,46 @@ public:
     bool publishEvent(EventType eventType, const String& insightId);
     
     /**
-     * @brief Publish an event with parsed insight data
+     * @brief Publish an event with insight data
      * 
      * @param eventType Type of the event
      * @param insightId ID of the insight related to the event
-     * @param parser Shared pointer to parsed insight data
+     * @param snapshot Data extracted from the response, or nullptr if it wasn't a renderable insight
      * @return true if the event was successfully queued
      * @return false if the queue is full
      */
-    bool publishEvent(EventType eventType, const String& insightId, std::shared_ptr<InsightParser> parser);
+    bool publishEvent(EventType eventType, const String& insightId, std::shared_ptr<const InsightSnapshot> snapshot);
     
     /**
      * @brief Publish an event with raw JSON data
      * 
      * @param eventType Type of the event
      * @param insightId ID of the insight related to the event
-     * @param jsonData Raw JSON data string
+     * @param jsonData Raw JSON data string (copied)
      * @return true if the event was successfully queued
      * @return false if the queue is full
      */
     bool publishEvent(EventType eventType, const String& insightId, const String& jsonData);
     
+    /**
+     * @brief Publish an event with raw JSON data, taking ownership of the buffer
+     * 
+     * @param eventType Type of the event
+     * @param insightId ID of the insight related to the event
+     * @param jsonData Raw JSON data string (moved, never copied)
+     * @return true if the event was successfully queued
+     * @return false if the queue is full
+     */
+    bool publishEvent(EventType eventType, const String& insightId, String&& jsonData);
+    
     /**
      * @brief Alternative method to publish a pre-constructed Event
      * 
-     * @param event The event to publish
+     * @param event The event to publish; moved into a pool slot
      * @return true if the event was successfully queued
      * @return false if the queue is full
      */
-    bool publishEvent(const Event& event);
+    bool publishEvent(Event&& event);
     
     /**
      * @brief Publish method alias for publishing events
@@ -146,14 +439,94 @@ public:
      * @param event The event to publish
      * @return true if the event was successfully queued
      */
-    bool publish(const Event& event) { return publishEvent(event); }
+    bool publish(Event&& event) { return publishEvent(std::move(event)); }
+    
+    /**
+     * @brief Snapshot the publish counters for one event type
+     * 
+     * @param type Event type to query
+     * @return Published, merged and dropped counts since boot
+     */
+    EventTypeStats getTypeStats(EventType type);
     
     /**
-     * @brief Subscribe to events
+     * @brief Snapshot the depth and latency metrics of one lane
      * 
-     * @param callback Function to call when an event is processed
+     * @param lane Lane to query
+     * @return Capacity, current depth, high-water mark and latency figures
      */
-    void subscribe(EventCallback callback);
+    EventLaneStats getLaneStats(EventLane lane);
+    
+    /**
+     * @brief Publish a request whose typed result goes back only to the caller
+     * 
+     * The request travels as an ordinary event of the given type, so lanes,
+     * coalescing and worker dispatch apply. The handler answers by calling
+     * complete() on Event::requestAs<Result>(). The callback runs on the LVGL
+     * task, or runs right away with success == false if the queue is full.
+     * Identical pending requests (same type, card ID and payload) share one
+     * execution and each receives the result.
+     * 
+     * @tparam Result Result type, e.g. WeatherData
+     * @param type Request event type
+     * @param cardId Requesting card's ID
+     * @param payload Request parameters (city, username, timezone...)
+     * @param callback Receives the result
+     * @return Handle that cancels the request when destroyed or replaced
+     */
+    template <typename Result>
+    AsyncRequestHandle request(EventType type, const String& cardId, const String& payload,
+                               typename AsyncRequest<Result>::Callback callback) {
+        auto request = std::make_shared<AsyncRequest<Result>>(std::move(callback));
+        Event event = Event::createCardEvent(type, cardId, payload);
+        event.request = request;
+        if (!publishEvent(std::move(event))) {
+            request->complete(false, Result());
+        }
+        return AsyncRequestHandle(request);
+    }
+    
+    /**
+     * @brief Snapshot execution time figures for every live subscriber
+     */
+    std::vector<EventSubscriberStats> getSubscriberStats();
+    
+    /**
+     * @brief Write lane, per-type and per-subscriber telemetry as JSON
+     * 
+     * @param out Object to fill; used for the "event_bus" section of /api/status
+     */
+    void writeStats(JsonObject out);
+    
+    /**
+     * @brief Print a human-readable telemetry dump
+     * 
+     * @param out Destination, typically Serial
+     */
+    void printStats(Print& out);
+    
+    /**
+     * @brief Subscribe to every event of one type
+     * 
+     * @param type Event type to receive
+     * @param callback Function to call when a matching event is processed
+     * @param mode INLINE for quick handlers, BLOCKING for I/O-bound ones
+     * @return Handle that unsubscribes when destroyed
+     */
+    EventSubscription subscribe(EventType type, EventCallback callback,
+                                DispatchMode mode = DispatchMode::INLINE);
+    
+    /**
+     * @brief Subscribe to events of one type for a single insight or card
+     * 
+     * @param type Event type to receive
+     * @param key Insight ID or card ID compared against Event::routingKey()
+     * @param callback Function to call when a matching event is processed
+     * @param mode INLINE for quick handlers, BLOCKING for I/O-bound ones
+     * @return Handle that unsubscribes when destroyed
+     */
+    EventSubscription subscribe(EventType type, const String& key, EventCallback callback,
+                                DispatchMode mode = DispatchMode::INLINE);
     
     /**
      * @brief Start the event processing task
@@ -161,7 +534,10 @@ public:
     void begin();
     
     /**
-     * @brief Stop the event processing task
+     * @brief Stop the event processing task and workers
+     * 
+     * Waits for the event task and each worker to finish what they are
+     * running, so no subscriber is mid-callback when this returns.
      */
     void end();
 }; 
\ No newline at end of file
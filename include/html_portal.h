@@ -1144,6 +1144,20 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "                apiKeyField.value = config.api_key_display;\n"
 "            }\n"
 "        }\n"
+"        if (config.refresh_minutes !== undefined) {\n"
+"            const refreshField = document.getElementById('refreshMinutes');\n"
+"            // 0 means automatic, shown as the empty placeholder\n"
+"            if (refreshField && !refreshField.value && config.refresh_minutes > 0) {\n"
+"                refreshField.value = config.refresh_minutes;\n"
+"            }\n"
+"        }\n"
+"        if (config.dashboard_id !== undefined) {\n"
+"            const dashboardField = document.getElementById('dashboardId');\n"
+"            // 0 means no dashboard, shown as the empty placeholder\n"
+"            if (dashboardField && !dashboardField.value && config.dashboard_id > 0) {\n"
+"                dashboardField.value = config.dashboard_id;\n"
+"            }\n"
+"        }\n"
 "        if (config.region !== undefined) {\n"
 "            // Handle region - set radio button or dropdown depending on UI\n"
 "            const regionRadios = document.querySelectorAll('input[name=\"region\"]');\n"
@@ -1422,6 +1436,18 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "                    <input type=\"text\" name=\"apiKey\" id=\"apiKey\">\n"
 "                    <p class=\"tip\">Create a <a href=\"https://app.posthog.com/settings/user-api-keys\" target=\"_blank\">new API key in your project settings</a>. Give it read access to insights.</p>\n"
 "                </div>\n"
+"\n"
+"                <div class=\"form-group\">\n"
+"                    <label for=\"refreshMinutes\">Refresh interval (minutes)</label>\n"
+"                    <input type=\"number\" name=\"refreshMinutes\" id=\"refreshMinutes\" min=\"1\" max=\"1440\" placeholder=\"Automatic\">\n"
+"                    <p class=\"tip\">Leave blank to let DeskHog decide. Insights refresh every 5 to 60 minutes depending on how often their data changes. The card on screen always refreshes at least every 2 minutes.</p>\n"
+"                </div>\n"
+"                \n"
+"                <div class=\"form-group\">\n"
+"                    <label for=\"dashboardId\">Dashboard ID (optional)</label>\n"
+"                    <input type=\"number\" name=\"dashboardId\" id=\"dashboardId\" min=\"1\" placeholder=\"None\">\n"
+"                    <p class=\"tip\">If your insights are on one dashboard, enter the numeral at the end of its URL. DeskHog then fetches all of them in a single request.</p>\n"
+"                </div>\n"
 "                \n"
 "                <div class=\"button-container\">\n"
 "                    <button type=\"submit\">Save API configuration</button>\n"
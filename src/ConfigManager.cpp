@@ -190,6 +190,34 @@ void ConfigManager::clearApiKey() {
     SystemController::setApiState(ApiState::API_AWAITING_CONFIG);
 }
 
+void ConfigManager::setInsightRefreshMinutes(uint16_t minutes) {
+    _preferences.putUShort(_refreshMinutesKey, minutes);
+    
+    // Commit changes
+    commit();
+}
+
+uint16_t ConfigManager::getInsightRefreshMinutes() {
+    if (!_preferences.isKey(_refreshMinutesKey)) {
+        return 0;
+    }
+    return _preferences.getUShort(_refreshMinutesKey);
+}
+
+void ConfigManager::setDashboardId(int dashboardId) {
+    _preferences.putInt(_dashboardIdKey, dashboardId);
+    
+    // Commit changes
+    commit();
+}
+
+int ConfigManager::getDashboardId() {
+    if (!_preferences.isKey(_dashboardIdKey)) {
+        return NO_DASHBOARD_ID;
+    }
+    return _preferences.getInt(_dashboardIdKey);
+}
+
 std::vector<CardConfig> ConfigManager::getCardConfigs() {
     std::vector<CardConfig> configs;
     
@@ -23,6 +23,7 @@
 class ConfigManager {
 public:
     static const int NO_TEAM_ID = -1;  // Sentinel value for no team ID
+    static const int NO_DASHBOARD_ID = 0;  // Sentinel value for no dashboard to batch fetch from
 
     /**
      * @brief Default constructor
@@ -126,6 +127,30 @@ public:
      */
     void clearApiKey();
 
+    /**
+     * @brief Store the insight refresh interval
+     * @param minutes Interval in minutes, or 0 to let the device decide
+     */
+    void setInsightRefreshMinutes(uint16_t minutes);
+
+    /**
+     * @brief Retrieve the insight refresh interval
+     * @return Interval in minutes, or 0 if refreshes are scheduled adaptively
+     */
+    uint16_t getInsightRefreshMinutes();
+
+    /**
+     * @brief Store the dashboard whose insights are fetched in one request
+     * @param dashboardId PostHog dashboard ID, or NO_DASHBOARD_ID to fetch each insight on its own
+     */
+    void setDashboardId(int dashboardId);
+
+    /**
+     * @brief Retrieve the dashboard whose insights are fetched in one request
+     * @return The dashboard ID or NO_DASHBOARD_ID if not set
+     */
+    int getDashboardId();
+
 
     /**
      * @brief Get all configured cards from persistent storage
@@ -180,6 +205,8 @@ private:
     const char* _teamIdKey = "team_id";           ///< Key for stored team ID
     const char* _apiKeyKey = "api_key";           ///< Key for stored API key
     const char* _regionKey = "region";           ///< Key for stored region
+    const char* _refreshMinutesKey = "refresh_min"; ///< Key for stored insight refresh interval
+    const char* _dashboardIdKey = "dashboard_id";  ///< Key for stored batch fetch dashboard
 
 
     // Storage size limits
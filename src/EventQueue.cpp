@@ -1,11 +1,43 @@
 #include "EventQueue.h"
 
-EventQueue::EventQueue(size_t queueSize) : isRunning(false), taskHandle(nullptr) {
-    // Create the event queue
-    eventQueue = xQueueCreate(queueSize, sizeof(Event));
+EventQueue::EventQueue(size_t controlSize, size_t bulkSize)
+    : nextSubscriberId(1), taskHandle(nullptr), isRunning(false) {
+    // Allocate each lane's slot pool once; only slot pointers travel through the queues
+    size_t sizes[] = { controlSize, bulkSize };
+    for (size_t i = 0; i < static_cast<size_t>(EventLane::LANE_COUNT); i++) {
+        Lane& lane = lanes[i];
+        lane.size = sizes[i];
+        lane.pool = new Slot[lane.size];
+        lane.queue = xQueueCreate(lane.size, sizeof(Slot*));
+        lane.freeSlots = xQueueCreate(lane.size, sizeof(Slot*));
+        for (size_t j = 0; j < lane.size; j++) {
+            Slot* slot = &lane.pool[j];
+            slot->refs = 0;
+            slot->lane = &lane;
+            xQueueSend(lane.freeSlots, &slot, 0);
+        }
+        lane.highWater = 0;
+        lane.dispatched = 0;
+        lane.totalLatencyUs = 0;
+        lane.maxLatencyUs = 0;
+        memset(lane.latencyHistogram, 0, sizeof(lane.latencyHistogram));
+    }
+    
+    // Worker queues are created up front; the workers themselves start in begin()
+    for (Worker& worker : workers) {
+        worker.owner = this;
+        worker.queue = xQueueCreate(WORKER_QUEUE_SIZE, sizeof(WorkItem*));
+        worker.task = nullptr;
+    }
+    parkMutex = xSemaphoreCreateMutex();
+    taskExited = xSemaphoreCreateCounting(WORKER_COUNT + 1, 0);
     
     // Create mutex for callback access
     callbackMutex = xSemaphoreCreateMutex();
+    
+    // Create mutex for the coalescing index and counters
+    pendingMutex = xSemaphoreCreateMutex();
+    memset(typeStats, 0, sizeof(typeStats));
 }
 
 EventQueue::~EventQueue() {
@@ -13,25 +45,163 @@ EventQueue::~EventQueue() {
     end();
     
     // Clean up resources
-    if (eventQueue) {
-        vQueueDelete(eventQueue);
-        eventQueue = nullptr;
+    for (Lane& lane : lanes) {
+        if (lane.queue) {
+            vQueueDelete(lane.queue);
+            lane.queue = nullptr;
+        }
+        if (lane.freeSlots) {
+            vQueueDelete(lane.freeSlots);
+            lane.freeSlots = nullptr;
+        }
+        delete[] lane.pool;
+        lane.pool = nullptr;
+    }
+    
+    for (Worker& worker : workers) {
+        if (worker.queue) {
+            vQueueDelete(worker.queue);
+            worker.queue = nullptr;
+        }
+    }
+    
+    if (parkMutex) {
+        vSemaphoreDelete(parkMutex);
+        parkMutex = nullptr;
+    }
+    
+    if (taskExited) {
+        vSemaphoreDelete(taskExited);
+        taskExited = nullptr;
     }
     
     if (callbackMutex) {
         vSemaphoreDelete(callbackMutex);
         callbackMutex = nullptr;
     }
+    
+    if (pendingMutex) {
+        vSemaphoreDelete(pendingMutex);
+        pendingMutex = nullptr;
+    }
+}
+
+const char* eventTypeToString(EventType type) {
+    switch (type) {
+        case EventType::INSIGHT_DATA_RECEIVED:     return "INSIGHT_DATA_RECEIVED";
+        case EventType::INSIGHT_FORCE_REFRESH:     return "INSIGHT_FORCE_REFRESH";
+        case EventType::WIFI_CREDENTIALS_FOUND:    return "WIFI_CREDENTIALS_FOUND";
+        case EventType::NEED_WIFI_CREDENTIALS:     return "NEED_WIFI_CREDENTIALS";
+        case EventType::WIFI_CONNECTING:           return "WIFI_CONNECTING";
+        case EventType::WIFI_CONNECTED:            return "WIFI_CONNECTED";
+        case EventType::WIFI_CONNECTION_FAILED:    return "WIFI_CONNECTION_FAILED";
+        case EventType::WIFI_AP_STARTED:           return "WIFI_AP_STARTED";
+        case EventType::OTA_PROCESS_START:         return "OTA_PROCESS_START";
+        case EventType::OTA_PROCESS_END:           return "OTA_PROCESS_END";
+        case EventType::CARD_CONFIG_CHANGED:       return "CARD_CONFIG_CHANGED";
+        case EventType::CARD_TITLE_UPDATED:        return "CARD_TITLE_UPDATED";
+        case EventType::TIME_SYNC_REQUEST:         return "TIME_SYNC_REQUEST";
+        case EventType::WEATHER_REQUEST:           return "WEATHER_REQUEST";
+        case EventType::NOW_PLAYING_REQUEST:       return "NOW_PLAYING_REQUEST";
+        default:                                   return "UNKNOWN";
+    }
+}
+
+static const uint32_t LATENCY_BUCKET_UPPER_US[EVENT_LATENCY_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000
+};
+
+static const char* const LATENCY_BUCKET_LABELS[EVENT_LATENCY_BUCKETS] = {
+    "lt_1ms", "lt_2ms", "lt_5ms", "lt_10ms", "lt_20ms",
+    "lt_50ms", "lt_100ms", "lt_200ms", "lt_500ms", "ge_500ms"
+};
+
+static const char* const LANE_NAMES[static_cast<size_t>(EventLane::LANE_COUNT)] = {
+    "control", "bulk"
+};
+
+const char* eventLatencyBucketLabel(size_t bucket) {
+    return bucket < EVENT_LATENCY_BUCKETS ? LATENCY_BUCKET_LABELS[bucket] : "unknown";
+}
+
+bool EventQueue::isCoalescable(EventType type) {
+    // Only events where the latest one fully supersedes earlier ones. WiFi and
+    // OTA transitions are a sequence, so every one of them must be delivered.
+    switch (type) {
+        case EventType::INSIGHT_DATA_RECEIVED:
+        case EventType::INSIGHT_FORCE_REFRESH:
+        case EventType::CARD_CONFIG_CHANGED:
+        case EventType::CARD_TITLE_UPDATED:
+        case EventType::TIME_SYNC_REQUEST:
+        case EventType::WEATHER_REQUEST:
+        case EventType::NOW_PLAYING_REQUEST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string EventQueue::coalesceKey(const Event& event) {
+    // Requests with different parameters (two cities, two usernames) must
+    // each run, so the payload is part of the key
+    std::string key = event.routingKey().c_str();
+    if (event.data.length() > 0) {
+        key += '|';
+        key += event.data.c_str();
+    }
+    return key;
+}
+
+EventLane EventQueue::laneFor(EventType type) {
+    // Anything that parses payloads, saves config or goes to the network is
+    // bulk; state changes and user input must not wait behind it
+    switch (type) {
+        case EventType::INSIGHT_DATA_RECEIVED:
+        case EventType::CARD_TITLE_UPDATED:
+        case EventType::TIME_SYNC_REQUEST:
+        case EventType::WEATHER_REQUEST:
+        case EventType::NOW_PLAYING_REQUEST:
+            return EventLane::BULK;
+        default:
+            return EventLane::CONTROL;
+    }
+}
+
+EventLaneStats EventQueue::getLaneStats(EventLane lane) {
+    EventLaneStats stats = {};
+    size_t laneIndex = static_cast<size_t>(lane);
+    if (laneIndex < static_cast<size_t>(EventLane::LANE_COUNT) &&
+        xSemaphoreTake(pendingMutex, portMAX_DELAY) == pdTRUE) {
+        const Lane& l = lanes[laneIndex];
+        stats.capacity = l.size;
+        stats.depth = uxQueueMessagesWaiting(l.queue);
+        stats.highWater = l.highWater;
+        stats.dispatched = l.dispatched;
+        stats.avgLatencyUs = l.dispatched ? (uint32_t)(l.totalLatencyUs / l.dispatched) : 0;
+        stats.maxLatencyUs = l.maxLatencyUs;
+        memcpy(stats.latencyHistogram, l.latencyHistogram, sizeof(stats.latencyHistogram));
+        xSemaphoreGive(pendingMutex);
+    }
+    return stats;
+}
+
+EventTypeStats EventQueue::getTypeStats(EventType type) {
+    EventTypeStats stats = {};
+    size_t typeIndex = static_cast<size_t>(type);
+    if (typeIndex < static_cast<size_t>(EventType::EVENT_TYPE_COUNT) &&
+        xSemaphoreTake(pendingMutex, portMAX_DELAY) == pdTRUE) {
+        stats = typeStats[typeIndex];
+        xSemaphoreGive(pendingMutex);
+    }
+    return stats;
 }
 
 bool EventQueue::publishEvent(EventType eventType, const String& insightId) {
-    Event event(eventType, insightId);
-    return publishEvent(event);
+    return publishEvent(Event(eventType, insightId));
 }
 
-bool EventQueue::publishEvent(EventType eventType, const String& insightId, std::shared_ptr<InsightParser> parser) {
-    Event event(eventType, insightId, parser);
-    return publishEvent(event);
+bool EventQueue::publishEvent(EventType eventType, const String& insightId, std::shared_ptr<const InsightSnapshot> snapshot) {
+    return publishEvent(Event(eventType, insightId, std::move(snapshot)));
 }
 
 bool EventQueue::publishEvent(EventType eventType, const String& insightId, const String& jsonData) {
@@ -40,34 +210,485 @@ bool EventQueue::publishEvent(EventType eventType, const String& insightId, cons
         Serial.printf("Large JSON detected (%u bytes), handling via event\n", jsonData.length());
     }
     
-    Event event(eventType, insightId, jsonData);
-    return publishEvent(event);
+    return publishEvent(Event(eventType, insightId, jsonData));
 }
 
-bool EventQueue::publishEvent(const Event& event) {
-    // Add the event to the queue
-    if (xQueueSend(eventQueue, &event, 0) == pdPASS) {
+bool EventQueue::publishEvent(EventType eventType, const String& insightId, String&& jsonData) {
+    if (jsonData.length() > 8192) { // 8KB threshold
+        Serial.printf("Large JSON detected (%u bytes), handing buffer to event\n", jsonData.length());
+    }
+    
+    return publishEvent(Event(eventType, insightId, std::move(jsonData)));
+}
+
+bool EventQueue::publishEvent(Event&& event) {
+    size_t typeIndex = static_cast<size_t>(event.type);
+    if (typeIndex >= static_cast<size_t>(EventType::EVENT_TYPE_COUNT)) {
+        return false;
+    }
+    
+    // Held across the slot hand-off so the consumer can't dispatch a slot
+    // that is still being registered in the pending index
+    if (xSemaphoreTake(pendingMutex, portMAX_DELAY) != pdTRUE) {
+        return false;
+    }
+    
+    // Fold into a pending event with the same (type, key) if there is one;
+    // the slot keeps its place in line and its original enqueue time
+    bool coalesce = isCoalescable(event.type);
+    std::string key;
+    if (coalesce) {
+        key = coalesceKey(event);
+        auto it = pending[typeIndex].find(key);
+        if (it != pending[typeIndex].end()) {
+            // A replaced request still gets its answer, from the newer one
+            Event& queued = it->second->event;
+            if (queued.request && event.request) {
+                event.request->adopt(std::move(queued.request));
+            } else if (queued.request) {
+                event.request = std::move(queued.request);
+            }
+            queued = std::move(event);
+            typeStats[typeIndex].merged++;
+            xSemaphoreGive(pendingMutex);
+            return true;
+        }
+    }
+    
+    // Claim a slot from the event's lane; if none is free that lane is full
+    Lane& lane = lanes[static_cast<size_t>(laneFor(event.type))];
+    Slot* slot = nullptr;
+    if (xQueueReceive(lane.freeSlots, &slot, 0) != pdPASS) {
+        uint32_t dropped = ++typeStats[typeIndex].dropped;
+        xSemaphoreGive(pendingMutex);
+        Serial.printf("[EventQueue] Queue full, dropped %s (%u dropped so far)\n",
+                      eventTypeToString(event.type), dropped);
+        return false;
+    }
+    
+    // Move the payload into the slot and hand the pointer to the processing task
+    slot->event = std::move(event);
+    slot->enqueuedUs = micros();
+    if (coalesce) {
+        pending[typeIndex][key] = slot;
+    }
+    if (xQueueSend(lane.queue, &slot, 0) == pdPASS) {
+        typeStats[typeIndex].published++;
+        uint32_t depth = uxQueueMessagesWaiting(lane.queue);
+        if (depth > lane.highWater) {
+            lane.highWater = depth;
+        }
+        xSemaphoreGive(pendingMutex);
+        
+        // Wake the processing task; the notification count means a wake-up
+        // sent while it is busy is not lost
+        if (taskHandle != nullptr) {
+            xTaskNotifyGive(taskHandle);
+        }
         return true;
     }
+    
+    // Should not happen since the lane queue matches its pool size, but never leak a slot
+    if (coalesce) {
+        pending[typeIndex].erase(key);
+    }
+    typeStats[typeIndex].dropped++;
+    xSemaphoreGive(pendingMutex);
+    slot->event = Event();
+    xQueueSend(lane.freeSlots, &slot, 0);
+    return false;
+}
+
+void EventQueue::releasePending(Slot* slot) {
+    // Once removed from the index no publisher can touch the slot, so dispatch
+    // sees a stable event; anything published from here on queues anew
+    if (!isCoalescable(slot->event.type)) {
+        return;
+    }
+    if (xSemaphoreTake(pendingMutex, portMAX_DELAY) == pdTRUE) {
+        auto& index = pending[static_cast<size_t>(slot->event.type)];
+        auto it = index.find(coalesceKey(slot->event));
+        if (it != index.end() && it->second == slot) {
+            index.erase(it);
+        }
+        xSemaphoreGive(pendingMutex);
+    }
+}
+
+bool EventQueue::takeNextSlot(Slot*& slot) {
+    // Lanes are checked in priority order, so CONTROL is drained before the
+    // next BULK event is taken
+    for (Lane& lane : lanes) {
+        if (xQueueReceive(lane.queue, &slot, 0) == pdPASS) {
+            return true;
+        }
+    }
     return false;
 }
 
-void EventQueue::subscribe(EventCallback callback) {
-    // Protect access to the callbacks vector
-    if (xSemaphoreTake(callbackMutex, portMAX_DELAY) == pdTRUE) {
-        eventCallbacks.push_back(callback);
-        xSemaphoreGive(callbackMutex);
+void EventQueue::recordDispatch(Lane& lane, uint32_t latencyUs) {
+    if (xSemaphoreTake(pendingMutex, portMAX_DELAY) == pdTRUE) {
+        lane.dispatched++;
+        lane.totalLatencyUs += latencyUs;
+        if (latencyUs > lane.maxLatencyUs) {
+            lane.maxLatencyUs = latencyUs;
+        }
+        size_t bucket = 0;
+        while (bucket < EVENT_LATENCY_BUCKETS - 1 && latencyUs >= LATENCY_BUCKET_UPPER_US[bucket]) {
+            bucket++;
+        }
+        lane.latencyHistogram[bucket]++;
+        xSemaphoreGive(pendingMutex);
+    }
+}
+
+void EventQueue::releaseSlot(Slot* slot) {
+    // The last holder resets the payload and returns the slot to its lane
+    if (--slot->refs == 0) {
+        slot->event = Event();
+        xQueueSend(slot->lane->freeSlots, &slot, 0);
+    }
+}
+
+EventSubscription EventQueue::subscribe(EventType type, EventCallback callback, DispatchMode mode) {
+    return addSubscriber(type, "", std::move(callback), mode);
+}
+
+EventSubscription EventQueue::subscribe(EventType type, const String& key, EventCallback callback, DispatchMode mode) {
+    return addSubscriber(type, key, std::move(callback), mode);
+}
+
+EventSubscription EventQueue::addSubscriber(EventType type, const String& key, EventCallback callback, DispatchMode mode) {
+    size_t typeIndex = static_cast<size_t>(type);
+    if (typeIndex >= static_cast<size_t>(EventType::EVENT_TYPE_COUNT) || !callback) {
+        return EventSubscription();
+    }
+    
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->type = type;
+    subscriber->key = key.c_str();
+    subscriber->callback = std::move(callback);
+    subscriber->mode = mode;
+    subscriber->active = true;
+    subscriber->running = 0;
+    subscriber->calls = 0;
+    subscriber->totalUs = 0;
+    subscriber->maxUs = 0;
+    subscriber->dropped = 0;
+    
+    if (xSemaphoreTake(callbackMutex, portMAX_DELAY) != pdTRUE) {
+        return EventSubscription();
+    }
+    
+    subscriber->id = nextSubscriberId++;
+    if (nextSubscriberId == 0) {
+        nextSubscriberId = 1;  // 0 means "no subscriber"
+    }
+    
+    Route& route = routes[typeIndex];
+    if (subscriber->key.empty()) {
+        route.any.push_back(subscriber);
+    } else {
+        route.byKey[subscriber->key].push_back(subscriber);
+    }
+    subscribers[subscriber->id] = subscriber;
+    uint32_t id = subscriber->id;
+    
+    xSemaphoreGive(callbackMutex);
+    return EventSubscription(this, id);
+}
+
+// Subscriber whose callback the current task is executing, so an unsubscribe
+// from inside that callback doesn't wait on itself
+static thread_local uint32_t currentSubscriberId = 0;
+
+void EventQueue::unsubscribe(uint32_t id) {
+    if (xSemaphoreTake(callbackMutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    
+    SubscriberPtr subscriber;
+    auto it = subscribers.find(id);
+    if (it != subscribers.end()) {
+        subscriber = it->second;
+        subscriber->active = false;
+        subscribers.erase(it);
+        
+        // Swap-remove from the owning route list
+        Route& route = routes[static_cast<size_t>(subscriber->type)];
+        std::vector<SubscriberPtr>* list = &route.any;
+        auto keyed = route.byKey.end();
+        if (!subscriber->key.empty()) {
+            keyed = route.byKey.find(subscriber->key);
+            list = keyed != route.byKey.end() ? &keyed->second : nullptr;
+        }
+        if (list) {
+            for (size_t i = 0; i < list->size(); i++) {
+                if ((*list)[i] == subscriber) {
+                    (*list)[i] = std::move(list->back());
+                    list->pop_back();
+                    break;
+                }
+            }
+            if (keyed != route.byKey.end() && keyed->second.empty()) {
+                route.byKey.erase(keyed);
+            }
+        }
+    }
+    
+    xSemaphoreGive(callbackMutex);
+    
+    // If the callback is mid-flight on the event task or a worker, wait for it
+    // to return so the owner can be destroyed safely
+    if (subscriber && currentSubscriberId != id) {
+        while (subscriber->running > 0) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+std::vector<EventSubscriberStats> EventQueue::getSubscriberStats() {
+    std::vector<EventSubscriberStats> result;
+    if (xSemaphoreTake(callbackMutex, portMAX_DELAY) != pdTRUE) {
+        return result;
+    }
+    result.reserve(subscribers.size());
+    for (const auto& entry : subscribers) {
+        const Subscriber& subscriber = *entry.second;
+        EventSubscriberStats stats;
+        stats.name = eventTypeToString(subscriber.type);
+        if (!subscriber.key.empty()) {
+            stats.name += ":";
+            stats.name += subscriber.key.c_str();
+        }
+        stats.blocking = subscriber.mode == DispatchMode::BLOCKING;
+        stats.calls = subscriber.calls;
+        stats.avgUs = subscriber.calls ? (uint32_t)(subscriber.totalUs / subscriber.calls) : 0;
+        stats.maxUs = subscriber.maxUs;
+        stats.dropped = subscriber.dropped;
+        result.push_back(stats);
     }
+    xSemaphoreGive(callbackMutex);
+    return result;
+}
+
+void EventQueue::writeStats(JsonObject out) {
+    JsonArray lanesArr = out.createNestedArray("lanes");
+    for (size_t i = 0; i < static_cast<size_t>(EventLane::LANE_COUNT); i++) {
+        EventLaneStats stats = getLaneStats(static_cast<EventLane>(i));
+        JsonObject laneObj = lanesArr.createNestedObject();
+        laneObj["name"] = LANE_NAMES[i];
+        laneObj["capacity"] = stats.capacity;
+        laneObj["depth"] = stats.depth;
+        laneObj["high_water"] = stats.highWater;
+        laneObj["dispatched"] = stats.dispatched;
+        laneObj["avg_latency_us"] = stats.avgLatencyUs;
+        laneObj["max_latency_us"] = stats.maxLatencyUs;
+        JsonObject histObj = laneObj.createNestedObject("latency_histogram");
+        for (size_t b = 0; b < EVENT_LATENCY_BUCKETS; b++) {
+            histObj[LATENCY_BUCKET_LABELS[b]] = stats.latencyHistogram[b];
+        }
+    }
+    
+    // Only types that have seen traffic, to keep the payload small
+    JsonArray typesArr = out.createNestedArray("types");
+    for (size_t i = 0; i < static_cast<size_t>(EventType::EVENT_TYPE_COUNT); i++) {
+        EventType type = static_cast<EventType>(i);
+        EventTypeStats stats = getTypeStats(type);
+        if (stats.published == 0 && stats.merged == 0 && stats.dropped == 0) {
+            continue;
+        }
+        JsonObject typeObj = typesArr.createNestedObject();
+        typeObj["type"] = eventTypeToString(type);
+        typeObj["published"] = stats.published;
+        typeObj["merged"] = stats.merged;
+        typeObj["dropped"] = stats.dropped;
+    }
+    
+    JsonArray subsArr = out.createNestedArray("subscribers");
+    for (const auto& stats : getSubscriberStats()) {
+        JsonObject subObj = subsArr.createNestedObject();
+        subObj["name"] = stats.name;
+        subObj["blocking"] = stats.blocking;
+        subObj["calls"] = stats.calls;
+        subObj["avg_us"] = stats.avgUs;
+        subObj["max_us"] = stats.maxUs;
+        subObj["dropped"] = stats.dropped;
+    }
+}
+
+void EventQueue::printStats(Print& out) {
+    out.println("=== Event bus ===");
+    for (size_t i = 0; i < static_cast<size_t>(EventLane::LANE_COUNT); i++) {
+        EventLaneStats stats = getLaneStats(static_cast<EventLane>(i));
+        out.printf("Lane %-7s depth %u/%u (high water %u), dispatched %u, latency avg %uus max %uus\n",
+                   LANE_NAMES[i], stats.depth, (unsigned)stats.capacity, stats.highWater,
+                   stats.dispatched, stats.avgLatencyUs, stats.maxLatencyUs);
+        out.print("  latency:");
+        for (size_t b = 0; b < EVENT_LATENCY_BUCKETS; b++) {
+            out.printf(" %s=%u", LATENCY_BUCKET_LABELS[b], stats.latencyHistogram[b]);
+        }
+        out.println();
+    }
+    
+    out.println("Types (published / merged / dropped):");
+    for (size_t i = 0; i < static_cast<size_t>(EventType::EVENT_TYPE_COUNT); i++) {
+        EventType type = static_cast<EventType>(i);
+        EventTypeStats stats = getTypeStats(type);
+        if (stats.published == 0 && stats.merged == 0 && stats.dropped == 0) {
+            continue;
+        }
+        out.printf("  %-26s %6u %6u %6u\n", eventTypeToString(type),
+                   stats.published, stats.merged, stats.dropped);
+    }
+    
+    out.println("Subscribers (calls / avg us / max us / dropped):");
+    for (const auto& stats : getSubscriberStats()) {
+        out.printf("  %-40s %s %6u %8u %8u %6u\n", stats.name.c_str(), stats.blocking ? "B" : "I",
+                   stats.calls, stats.avgUs, stats.maxUs, stats.dropped);
+    }
+}
+
+void EventQueue::invoke(Subscriber& subscriber, const Event& event) {
+    // Claim the subscriber under the lock so an unsubscribe either happens
+    // before we run (and we skip) or waits for us to finish
+    xSemaphoreTake(callbackMutex, portMAX_DELAY);
+    bool active = subscriber.active;
+    if (active) {
+        subscriber.running++;
+    }
+    xSemaphoreGive(callbackMutex);
+    if (!active) {
+        return;
+    }
+    
+    uint32_t outerSubscriberId = currentSubscriberId;
+    currentSubscriberId = subscriber.id;
+    uint32_t startUs = micros();
+    subscriber.callback(event);
+    uint32_t elapsedUs = micros() - startUs;
+    currentSubscriberId = outerSubscriberId;
+    
+    xSemaphoreTake(callbackMutex, portMAX_DELAY);
+    subscriber.calls++;
+    subscriber.totalUs += elapsedUs;
+    if (elapsedUs > subscriber.maxUs) {
+        subscriber.maxUs = elapsedUs;
+    }
+    subscriber.running--;
+    xSemaphoreGive(callbackMutex);
+    
+    if (subscriber.mode == DispatchMode::INLINE && elapsedUs > 50000) {
+        Serial.printf("[EventQueue] Inline handler for %s took %u ms; consider DispatchMode::BLOCKING\n",
+                      eventTypeToString(subscriber.type), elapsedUs / 1000);
+    }
+}
+
+void EventQueue::dispatch(Slot* slot) {
+    const Event& event = slot->event;
+    size_t typeIndex = static_cast<size_t>(event.type);
+    if (typeIndex >= static_cast<size_t>(EventType::EVENT_TYPE_COUNT)) {
+        return;
+    }
+    
+    // Snapshot the matching subscribers so callbacks run without the lock held;
+    // a callback may publish, subscribe or unsubscribe freely.
+    dispatchScratch.clear();
+    if (xSemaphoreTake(callbackMutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    const Route& route = routes[typeIndex];
+    dispatchScratch.insert(dispatchScratch.end(), route.any.begin(), route.any.end());
+    const String& key = event.routingKey();
+    if (key.length() > 0 && !route.byKey.empty()) {
+        auto keyed = route.byKey.find(std::string(key.c_str()));
+        if (keyed != route.byKey.end()) {
+            dispatchScratch.insert(dispatchScratch.end(), keyed->second.begin(), keyed->second.end());
+        }
+    }
+    xSemaphoreGive(callbackMutex);
+    
+    for (const auto& subscriber : dispatchScratch) {
+        if (subscriber->mode == DispatchMode::INLINE) {
+            invoke(*subscriber, event);
+            continue;
+        }
+        
+        // Hand blocking subscribers to their worker; the job holds a slot
+        // reference so the event outlives this dispatch. A subscriber always
+        // maps to the same worker, keeping its events in order. The event
+        // task never waits on a backed-up worker: the job is parked, or
+        // dropped and counted once too many are parked.
+        WorkItem* item = new WorkItem{slot, subscriber};
+        slot->refs++;
+        if (!enqueueWork(workers[subscriber->id % WORKER_COUNT], item, false)) {
+            slot->refs--;
+            delete item;
+            xSemaphoreTake(callbackMutex, portMAX_DELAY);
+            uint32_t dropped = ++subscriber->dropped;
+            xSemaphoreGive(callbackMutex);
+            Serial.printf("[EventQueue] Worker backed up, dropped %s for a blocking subscriber (%u dropped so far)\n",
+                          eventTypeToString(event.type), dropped);
+            // The handler will never see this request; answer it so the requester isn't left waiting
+            if (event.request) {
+                event.request->abandon();
+            }
+        }
+    }
+    dispatchScratch.clear();
+}
+
+bool EventQueue::enqueueWork(Worker& worker, WorkItem* item, bool force) {
+    bool accepted = true;
+    xSemaphoreTake(parkMutex, portMAX_DELAY);
+    // Parked jobs go first so the worker's jobs stay in order
+    if (!worker.parked.empty() || xQueueSend(worker.queue, &item, 0) != pdPASS) {
+        if (force || worker.parked.size() < WORKER_PARK_LIMIT) {
+            worker.parked.push_back(item);
+        } else {
+            accepted = false;
+        }
+    }
+    xSemaphoreGive(parkMutex);
+    return accepted;
+}
+
+void EventQueue::refillWorker(Worker& worker) {
+    xSemaphoreTake(parkMutex, portMAX_DELAY);
+    while (!worker.parked.empty()) {
+        WorkItem* item = worker.parked.front();
+        if (xQueueSend(worker.queue, &item, 0) != pdPASS) {
+            break;
+        }
+        worker.parked.pop_front();
+    }
+    xSemaphoreGive(parkMutex);
 }
 
 void EventQueue::begin() {
     if (!isRunning) {
         isRunning = true;
+        
+        // Workers run blocking handlers; pinned to core 0 with the network stack
+        for (size_t i = 0; i < WORKER_COUNT; i++) {
+            char name[20];
+            snprintf(name, sizeof(name), "EventWorker%u", (unsigned)i);
+            xTaskCreatePinnedToCore(
+                workerTask,
+                name,
+                12288,          // HTTPS requests and JSON parses run here
+                &workers[i],
+                tskIDLE_PRIORITY + 1,
+                &workers[i].task,
+                0
+            );
+        }
+        
         // Create a task to process events
         xTaskCreate(
             eventProcessingTask,
             "EventQueueTask",
-            16384,           // Stack size increased for network operations
+            8192,           // Only inline handlers run here
             this,           // Task parameter
             tskIDLE_PRIORITY + 1,  // Priority (adjust as needed)
             &taskHandle     // Task handle
@@ -79,35 +700,102 @@ void EventQueue::end() {
     if (isRunning && taskHandle != nullptr) {
         isRunning = false;
         
-        // Wait a bit for any pending tasks
-        vTaskDelay(pdMS_TO_TICKS(100));
-        
-        // Delete the task
-        vTaskDelete(taskHandle);
+        // Wake the event task so it sees isRunning, then wait for it to exit
+        xTaskNotifyGive(taskHandle);
+        xSemaphoreTake(taskExited, portMAX_DELAY);
         taskHandle = nullptr;
+        
+        // Queue a stop behind each worker's outstanding jobs and wait for the
+        // worker to reach it, so none is deleted while it holds a subscriber
+        for (Worker& worker : workers) {
+            if (worker.task != nullptr) {
+                enqueueWork(worker, nullptr, true);
+                xSemaphoreTake(taskExited, portMAX_DELAY);
+                worker.task = nullptr;
+            }
+        }
     }
 }
 
 void EventQueue::eventProcessingTask(void* parameter) {
     EventQueue* self = static_cast<EventQueue*>(parameter);
-    Event event;
+    Slot* slot = nullptr;
+    bool drained = false;  // Drain first: events published before begin() sent no notification
     
     // Process events in a loop
     while (self->isRunning) {
-        // Wait for an event (block until an event arrives)
-        if (xQueueReceive(self->eventQueue, &event, pdMS_TO_TICKS(100)) == pdPASS) {
-            // Process the event by calling all registered callbacks
-            if (xSemaphoreTake(self->callbackMutex, portMAX_DELAY) == pdTRUE) {
-                for (const auto& callback : self->eventCallbacks) {
-                    callback(event);
-                }
-                xSemaphoreGive(self->callbackMutex);
+        // Sleep until a publish notifies us. There is no timeout, so an idle
+        // bus never wakes the CPU and light sleep can kick in
+        if (drained) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        
+        // Drain everything pending, highest-priority lane first, up to the budget
+        uint32_t batchStartUs = micros();
+        drained = false;
+        while (self->isRunning) {
+            if (!self->takeNextSlot(slot)) {
+                drained = true;
+                break;
             }
+            
+            // Detach from the coalescing index, then deliver to routed subscribers
+            slot->refs = 1;
+            self->releasePending(slot);
+            self->recordDispatch(*slot->lane, micros() - slot->enqueuedUs);
+            self->dispatch(slot);
+            
+            // Drop the event task's reference; workers may still hold the slot
+            self->releaseSlot(slot);
+            
+            if (micros() - batchStartUs >= DRAIN_BUDGET_US) {
+                break;
+            }
+        }
+        
+        // Over budget with events left: give lower-priority tasks a tick,
+        // then carry on without waiting for another notification
+        if (!drained) {
+            vTaskDelay(1);
         }
-        // Small delay to prevent CPU hogging
-        vTaskDelay(1);
     }
     
-    // Task cleanup
+    // Let end() know we're done, then clean up
+    xSemaphoreGive(self->taskExited);
     vTaskDelete(NULL);
-} 
\ No newline at end of file
+}
+
+void EventQueue::workerTask(void* parameter) {
+    Worker* worker = static_cast<Worker*>(parameter);
+    EventQueue* self = worker->owner;
+    WorkItem* item = nullptr;
+    
+    while (true) {
+        if (xQueueReceive(worker->queue, &item, portMAX_DELAY) != pdPASS) {
+            continue;
+        }
+        
+        // A place just opened up; move parked jobs in behind the queued ones
+        self->refillWorker(*worker);
+        
+        // A null job is end() asking us to stop, queued behind everything else
+        if (!item) {
+            break;
+        }
+        self->invoke(*item->subscriber, item->slot->event);
+        self->releaseSlot(item->slot);
+        delete item;
+    }
+    
+    xSemaphoreGive(self->taskExited);
+    vTaskDelete(NULL);
+}
+
+void EventSubscription::reset() {
+    if (_queue) {
+        EventQueue* queue = _queue;
+        _queue = nullptr;
+        queue->unsubscribe(_id);
+        _id = 0;
+    }
+}
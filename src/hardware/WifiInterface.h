@@ -97,6 +97,7 @@ private:
     
     // Event queue reference
     EventQueue* _eventQueue = nullptr;
+    std::vector<EventSubscription> _subscriptions;
 
     // WiFi state
     WiFiState _state;
@@ -28,6 +28,7 @@
 #include "ui/InsightCard.h"
 #include "hardware/Input.h"
 #include "posthog/PostHogClient.h"
+#include "posthog/SnapshotStore.h"
 #include "weather/WeatherClient.h"
 #include "Style.h"
 #include "esp_heap_caps.h" // For PSRAM management
@@ -63,6 +64,8 @@ WiFiInterface* wifiInterface;
 CaptivePortal* captivePortal;
 CardController* cardController; // Replace individual card objects with controller
 PostHogClient* posthogClient;
+SnapshotFlash* snapshotFlash;
+SnapshotStore* snapshotStore;
 WeatherClient* weatherClient;
 EventQueue* eventQueue; // Add global EventQueue
 NeoPixelController* neoPixelController;  // Renamed from neoPixelManager
@@ -174,6 +177,28 @@ void lvglHandlerTask(void* parameter) {
     }
 }
 
+// Serial console: type "events" to dump event bus telemetry
+void serialCommandTaskFunction(void* parameter) {
+    String line;
+    while (1) {
+        while (Serial.available()) {
+            char c = Serial.read();
+            if (c == '\n' || c == '\r') {
+                line.trim();
+                if (line == "events") {
+                    eventQueue->printStats(Serial);
+                } else if (line.length() > 0) {
+                    Serial.printf("Unknown command '%s' (try: events)\n", line.c_str());
+                }
+                line = "";
+            } else if (line.length() < 32) {
+                line += c;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+}
+
 // NeoPixel update task
 void neoPixelTaskFunction(void* parameter) {
     while (1) {
@@ -243,7 +268,7 @@ void setup() {
     Style::init();
     
     // Initialize event queue first
-    eventQueue = new EventQueue(20); // Create queue with capacity for 20 events
+    eventQueue = new EventQueue(8, 16); // 8 control-lane slots, 16 bulk-lane slots
     eventQueue->begin(); // Start event processing
     
     // Initialize NeoPixel controller
@@ -254,8 +279,14 @@ void setup() {
     configManager = new ConfigManager(*eventQueue);
     configManager->begin();
     
-    // Initialize PostHog client with event queue
-    posthogClient = new PostHogClient(*configManager, *eventQueue);
+    // Map the stored insight snapshots so cards can show them at once
+    snapshotFlash = new SnapshotFlash();
+    snapshotStore = new SnapshotStore(*snapshotFlash);
+    snapshotStore->begin();
+    
+    // Initialize PostHog client with event queue; it keeps the store up to date
+    posthogClient = new PostHogClient(*configManager, *eventQueue, *snapshotStore);
+    posthogClient->begin();
     
     // Initialize Weather client
     weatherClient = new WeatherClient();
@@ -289,6 +320,7 @@ void setup() {
         *configManager,
         *wifiInterface,
         *posthogClient,
+        *snapshotStore,
         *weatherClient,
         *eventQueue
     );
@@ -300,7 +332,7 @@ void setup() {
     otaManager = new OtaManager(CURRENT_FIRMWARE_VERSION, "PostHog", "DeskHog");
     
     // Initialize captive portal
-    captivePortal = new CaptivePortal(*configManager, *wifiInterface, *eventQueue, *otaManager, *cardController);
+    captivePortal = new CaptivePortal(*configManager, *wifiInterface, *eventQueue, *otaManager, *cardController, *posthogClient);
     captivePortal->begin();
     
     // Create task for WiFi operations
@@ -369,6 +401,17 @@ void setup() {
         0
     );
     
+    // Create task for serial console commands
+    xTaskCreatePinnedToCore(
+        serialCommandTaskFunction,
+        "serialCmdTask",
+        3072,
+        NULL,
+        1,
+        NULL,
+        0
+    );
+    
     // Check if we have WiFi credentials and publish the appropriate event
     configManager->checkWiFiCredentialsAndPublish();
 
@@ -0,0 +1,83 @@
+#include "GzipStream.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+std::atomic<uint32_t> responseCount(0);
+std::atomic<uint32_t> compressedBytes(0);
+std::atomic<uint32_t> inflatedBytes(0);
+}
+
+GzipStream::GzipStream(Stream& source)
+    : _source(source)
+    , _inflater([&source](uint8_t* buffer, size_t length) {
+          return source.readBytes(reinterpret_cast<char*>(buffer), length);
+      })
+    , _bufferPos(0)
+    , _bufferLen(0) {
+}
+
+GzipStream::~GzipStream() {
+    responseCount++;
+    compressedBytes += _inflater.bytesIn();
+    inflatedBytes += _inflater.bytesOut();
+}
+
+bool GzipStream::fillBuffer() {
+    if (_bufferPos < _bufferLen) {
+        return true;
+    }
+    _bufferPos = 0;
+    _bufferLen = _inflater.read(_buffer, BUFFER_SIZE);
+    return _bufferLen > 0;
+}
+
+int GzipStream::available() {
+    if (_bufferPos < _bufferLen) {
+        return _bufferLen - _bufferPos;
+    }
+    // More may come until the stream ends
+    return _inflater.finished() || _inflater.failed() ? 0 : 1;
+}
+
+int GzipStream::read() {
+    if (!fillBuffer()) {
+        return -1;
+    }
+    return _buffer[_bufferPos++];
+}
+
+int GzipStream::peek() {
+    if (!fillBuffer()) {
+        return -1;
+    }
+    return _buffer[_bufferPos];
+}
+
+size_t GzipStream::readBytes(char* buffer, size_t length) {
+    size_t total = 0;
+    // Hand over what's buffered, then inflate straight into the caller's buffer
+    if (_bufferPos < _bufferLen) {
+        total = std::min(length, _bufferLen - _bufferPos);
+        memcpy(buffer, _buffer + _bufferPos, total);
+        _bufferPos += total;
+    }
+    if (total < length) {
+        total += _inflater.read(reinterpret_cast<uint8_t*>(buffer) + total, length - total);
+    }
+    return total;
+}
+
+bool GzipStream::isGzip(String content_encoding) {
+    content_encoding.toLowerCase();
+    return content_encoding.indexOf("gzip") >= 0;
+}
+
+void GzipStream::writeStats(JsonObject out) {
+    uint32_t compressed = compressedBytes;
+    uint32_t inflated = inflatedBytes;
+    out["gzip_responses"] = static_cast<uint32_t>(responseCount);
+    out["compressed_bytes"] = compressed;
+    out["inflated_bytes"] = inflated;
+    out["bytes_saved"] = inflated > compressed ? inflated - compressed : 0;
+}
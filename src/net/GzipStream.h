@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "Inflater.h"
+
+/**
+ * @class GzipStream
+ * @brief Read-only Stream that inflates a gzip response body as it's read
+ *
+ * Sits between an HttpBodyStream and the JSON deserializer, so a
+ * compressed response is parsed straight off the socket like a plain one.
+ * Every instance adds its compressed and inflated byte counts to
+ * process-wide totals, reported by writeStats().
+ */
+class GzipStream : public Stream {
+public:
+    /**
+     * @brief Wrap a compressed body
+     * @param source Body with Content-Encoding: gzip, e.g. an HttpBodyStream
+     */
+    explicit GzipStream(Stream& source);
+    ~GzipStream() override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    using Stream::readBytes;
+    size_t readBytes(char* buffer, size_t length) override;
+    size_t write(uint8_t) override { return 0; }
+
+    /**
+     * @brief Check if the body was malformed, cut short or failed its CRC
+     */
+    bool failed() const { return _inflater.failed(); }
+
+    /**
+     * @brief Compressed bytes consumed so far
+     */
+    size_t bytesIn() const { return _inflater.bytesIn(); }
+
+    /**
+     * @brief Inflated bytes produced so far
+     */
+    size_t bytesOut() const { return _inflater.bytesOut(); }
+
+    /**
+     * @brief Check a Content-Encoding header for gzip
+     */
+    static bool isGzip(String content_encoding);
+
+    /**
+     * @brief Report compressed responses and the bytes they saved
+     */
+    static void writeStats(JsonObject out);
+
+private:
+    static constexpr size_t BUFFER_SIZE = 256;
+
+    bool fillBuffer();
+
+    Stream& _source;
+    Inflater _inflater;
+    uint8_t _buffer[BUFFER_SIZE];
+    size_t _bufferPos;
+    size_t _bufferLen;
+};
@@ -0,0 +1,215 @@
+#include "HttpBodyStream.h"
+#include <algorithm>
+
+HttpBodyStream::HttpBodyStream(Client& client, bool chunked, int contentLength, uint32_t timeoutMs)
+    : _client(client)
+    , _chunked(chunked)
+    , _remaining(chunked ? 0 : contentLength)
+    , _done(false)
+    , _truncated(false)
+    , _timeoutMs(timeoutMs)
+    , _bytesRead(0)
+    , _bufferPos(0)
+    , _bufferLen(0) {
+    // A chunked body starts with a chunk header; a zero-length body is already over
+    if (!_chunked && contentLength == 0) {
+        _done = true;
+    }
+    setTimeout(timeoutMs);
+}
+
+bool HttpBodyStream::fillBuffer() {
+    if (_bufferPos < _bufferLen) {
+        return true;
+    }
+
+    unsigned long start = millis();
+    while (true) {
+        int avail = _client.available();
+        if (avail > 0) {
+            size_t want = std::min(static_cast<size_t>(avail), BUFFER_SIZE);
+            // Never pull bytes past a known body length off a kept-alive socket
+            if (!_chunked && _remaining >= 0) {
+                want = std::min(want, static_cast<size_t>(_remaining));
+            }
+            int n = _client.read(_buffer, want);
+            if (n > 0) {
+                _bufferPos = 0;
+                _bufferLen = n;
+                return true;
+            }
+        }
+
+        if (!_client.connected() && _client.available() <= 0) {
+            // Closing the socket only ends a body that had no length
+            _truncated = _chunked || _remaining >= 0;
+            return false;
+        }
+        if (millis() - start >= _timeoutMs) {
+            Serial.printf("[HttpBodyStream] No data for %lu ms, giving up\n", static_cast<unsigned long>(_timeoutMs));
+            _truncated = true;
+            return false;
+        }
+        delay(1);
+    }
+}
+
+int HttpBodyStream::readRaw() {
+    if (!fillBuffer()) {
+        return -1;
+    }
+    return _buffer[_bufferPos++];
+}
+
+bool HttpBodyStream::nextChunk() {
+    // Skip the CRLF that closes the previous chunk's data
+    int c;
+    do {
+        c = readRaw();
+    } while (c == '\r' || c == '\n');
+
+    uint32_t size = 0;
+    bool sawDigit = false;
+    while (c >= 0 && c != '\r' && c != '\n' && c != ';') {
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else if (c == ' ' || c == '\t') {
+            c = readRaw();
+            continue;
+        } else {
+            break;
+        }
+        size = (size << 4) | digit;
+        sawDigit = true;
+        c = readRaw();
+    }
+
+    if (c >= 0 && !sawDigit) {
+        Serial.println("[HttpBodyStream] Malformed chunk header");
+        _truncated = true;
+        _done = true;
+        return false;
+    }
+
+    // Skip chunk extensions up to the end of the header line
+    while (c >= 0 && c != '\n') {
+        c = readRaw();
+    }
+    if (c < 0) {
+        _done = true;
+        return false;
+    }
+
+    if (size == 0) {
+        // Last chunk: consume optional trailers up to the blank line
+        size_t lineLength = 0;
+        while ((c = readRaw()) >= 0) {
+            if (c == '\n') {
+                if (lineLength == 0) {
+                    break;
+                }
+                lineLength = 0;
+            } else if (c != '\r') {
+                lineLength++;
+            }
+        }
+        _done = true;
+        return false;
+    }
+
+    _remaining = size;
+    return true;
+}
+
+bool HttpBodyStream::atBodyEnd() {
+    if (_done) {
+        return true;
+    }
+    if (_remaining != 0) {
+        return false;
+    }
+    if (_chunked) {
+        return !nextChunk();
+    }
+    _done = true;
+    return true;
+}
+
+int HttpBodyStream::available() {
+    if (_done) {
+        return 0;
+    }
+    int avail = static_cast<int>(_bufferLen - _bufferPos) + _client.available();
+    // Chunk framing makes this an upper bound for chunked bodies
+    if (_remaining >= 0 && !_chunked) {
+        avail = std::min(avail, static_cast<int>(_remaining));
+    }
+    return avail;
+}
+
+int HttpBodyStream::read() {
+    if (atBodyEnd()) {
+        return -1;
+    }
+    int c = readRaw();
+    if (c < 0) {
+        _done = true;
+        return -1;
+    }
+    if (_remaining > 0) {
+        _remaining--;
+    }
+    _bytesRead++;
+    return c;
+}
+
+int HttpBodyStream::peek() {
+    if (atBodyEnd() || !fillBuffer()) {
+        return -1;
+    }
+    return _buffer[_bufferPos];
+}
+
+size_t HttpBodyStream::readBytes(char* buffer, size_t length) {
+    size_t total = 0;
+    while (total < length && !atBodyEnd()) {
+        if (!fillBuffer()) {
+            _done = true;
+            break;
+        }
+        size_t take = std::min(length - total, _bufferLen - _bufferPos);
+        if (_remaining >= 0) {
+            take = std::min(take, static_cast<size_t>(_remaining));
+        }
+        memcpy(buffer + total, _buffer + _bufferPos, take);
+        _bufferPos += take;
+        if (_remaining > 0) {
+            _remaining -= take;
+        }
+        total += take;
+    }
+    _bytesRead += total;
+    return total;
+}
+
+void HttpBodyStream::finish() {
+    // Without a length or chunking the server closes the socket to end the
+    // body, so there is nothing to resynchronise
+    if (!_chunked && _remaining < 0) {
+        return;
+    }
+    while (!atBodyEnd()) {
+        if (!fillBuffer()) {
+            _done = true;
+            break;
+        }
+        size_t take = std::min(_bufferLen - _bufferPos, static_cast<size_t>(_remaining));
+        _bufferPos += take;
+        _remaining -= take;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+/**
+ * @class HttpBodyStream
+ * @brief Read-only Stream over an HTTP response body still on the socket
+ *
+ * HTTPClient::getStreamPtr() hands back the raw connection, which still
+ * carries chunked transfer framing and may hold the next response on a
+ * kept-alive connection. This wrapper strips the chunk headers, stops at the
+ * end of the body, and reads the socket in blocks so ArduinoJson can parse
+ * straight from the network without buffering the payload in a String.
+ */
+class HttpBodyStream : public Stream {
+public:
+    /**
+     * @brief Wrap the body of a response whose headers have been read
+     *
+     * @param client Connection returned by HTTPClient::getStreamPtr()
+     * @param chunked True if the response used Transfer-Encoding: chunked
+     * @param contentLength Body length from the headers, or -1 if unknown
+     * @param timeoutMs Longest wait for the next byte before giving up
+     */
+    HttpBodyStream(Client& client, bool chunked, int contentLength, uint32_t timeoutMs = 5000);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    using Stream::readBytes;
+    size_t readBytes(char* buffer, size_t length) override;
+    size_t write(uint8_t) override { return 0; }
+
+    /**
+     * @brief Consume whatever is left of the body
+     *
+     * Call after parsing so a kept-alive connection starts the next response
+     * on a clean boundary.
+     */
+    void finish();
+
+    /**
+     * @brief Check if the body ended early because the socket stalled or closed
+     */
+    bool truncated() const { return _truncated; }
+
+    /**
+     * @brief Body bytes handed to the reader so far
+     */
+    size_t bytesRead() const { return _bytesRead; }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 512;
+
+    bool fillBuffer();
+    int readRaw();
+    bool nextChunk();
+    bool atBodyEnd();
+
+    Client& _client;
+    bool _chunked;
+    int32_t _remaining;        ///< Bytes left in the current chunk or body; -1 if unbounded
+    bool _done;
+    bool _truncated;
+    uint32_t _timeoutMs;
+    size_t _bytesRead;
+
+    uint8_t _buffer[BUFFER_SIZE];
+    size_t _bufferPos;
+    size_t _bufferLen;
+};
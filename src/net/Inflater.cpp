@@ -0,0 +1,425 @@
+#include "Inflater.h"
+#include <stdio.h>
+#include <string.h>
+#include "../posthog/parsers/ParserArena.h"
+
+namespace {
+constexpr size_t WINDOW_MASK = Inflater::WINDOW_SIZE - 1;
+
+// Base values and extra bits of length symbols 257..285 and distance symbols 0..29
+const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order code length code lengths are sent in
+const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 a nibble at a time, so the table stays small
+const uint32_t CRC_TABLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+}
+
+Inflater::Inflater(Source source, bool gzip)
+    : _source(std::move(source))
+    , _gzip(gzip)
+    , _state(gzip ? State::HEADER : State::BLOCK_HEADER)
+    , _lastBlock(false)
+    , _inputPos(0)
+    , _inputLen(0)
+    , _inputEnded(false)
+    , _bitBuffer(0)
+    , _bitCount(0)
+    , _window(static_cast<uint8_t*>(ParserArena::instance().acquire(WINDOW_SIZE)))
+    , _windowPos(0)
+    , _storedRemaining(0)
+    , _matchLength(0)
+    , _matchDistance(0)
+    , _crc(0xFFFFFFFF)
+    , _bytesIn(0)
+    , _bytesOut(0) {
+    if (!_window) {
+        fail("no memory for window");
+    }
+}
+
+Inflater::~Inflater() {
+    // Kept by the arena for the next response instead of going back to the heap
+    ParserArena::instance().release(_window);
+}
+
+void Inflater::fail(const char* reason) {
+    if (_state != State::FAILED) {
+        printf("[Inflater] %s after %zu bytes in\n", reason, _bytesIn);
+    }
+    _state = State::FAILED;
+}
+
+int Inflater::nextByte() {
+    if (_inputPos == _inputLen) {
+        if (_inputEnded) {
+            return -1;
+        }
+        _inputLen = _source(_input, INPUT_SIZE);
+        _inputPos = 0;
+        if (_inputLen == 0) {
+            _inputEnded = true;
+            return -1;
+        }
+    }
+    _bytesIn++;
+    return _input[_inputPos++];
+}
+
+uint32_t Inflater::bits(uint8_t count) {
+    while (_bitCount < count) {
+        int value = nextByte();
+        if (value < 0) {
+            fail("input ended early");
+            return 0;
+        }
+        _bitBuffer |= static_cast<uint32_t>(value) << _bitCount;
+        _bitCount += 8;
+    }
+    uint32_t result = _bitBuffer & ((1UL << count) - 1);
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return result;
+}
+
+void Inflater::alignToByte() {
+    // bits() never holds a whole unread byte, so this drops only padding
+    _bitBuffer = 0;
+    _bitCount = 0;
+}
+
+int Inflater::decode(const Huffman& code) {
+    // Canonical codes of one length are consecutive, so walk the lengths
+    // and check whether the code read so far falls in this length's range
+    int value = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length < 16; length++) {
+        value |= bits(1);
+        if (_state == State::FAILED) {
+            return -1;
+        }
+        int count = code.count[length];
+        if (value - count < first) {
+            return code.symbol[index + (value - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        value <<= 1;
+    }
+    return -1;
+}
+
+bool Inflater::build(Huffman& code, const uint8_t* lengths, size_t count) {
+    memset(code.count, 0, sizeof(code.count));
+    for (size_t i = 0; i < count; i++) {
+        code.count[lengths[i]]++;
+    }
+    if (code.count[0] == count) {
+        return true;  // No codes; only valid if never used
+    }
+
+    // Over-subscribed lengths can't form a prefix code
+    int left = 1;
+    for (int length = 1; length < 16; length++) {
+        left <<= 1;
+        left -= code.count[length];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int length = 1; length < 15; length++) {
+        offsets[length + 1] = offsets[length] + code.count[length];
+    }
+    for (size_t symbol = 0; symbol < count; symbol++) {
+        if (lengths[symbol] != 0) {
+            code.symbol[offsets[lengths[symbol]]++] = symbol;
+        }
+    }
+    return true;
+}
+
+bool Inflater::readGzipHeader() {
+    uint8_t header[10];
+    for (size_t i = 0; i < sizeof(header); i++) {
+        int value = nextByte();
+        if (value < 0) {
+            return false;
+        }
+        header[i] = value;
+    }
+    if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8) {
+        return false;
+    }
+
+    uint8_t flags = header[3];
+    if (flags & 0x04) {  // FEXTRA
+        int low = nextByte();
+        int high = nextByte();
+        if (low < 0 || high < 0) {
+            return false;
+        }
+        for (int skip = low | (high << 8); skip > 0; skip--) {
+            if (nextByte() < 0) {
+                return false;
+            }
+        }
+    }
+    for (uint8_t field : {0x08, 0x10}) {  // FNAME, FCOMMENT: zero-terminated
+        if (flags & field) {
+            int value;
+            do {
+                value = nextByte();
+            } while (value > 0);
+            if (value < 0) {
+                return false;
+            }
+        }
+    }
+    if (flags & 0x02) {  // FHCRC
+        if (nextByte() < 0 || nextByte() < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Inflater::buildFixedTables() {
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    build(_lengthCode, lengths, 288);
+    memset(lengths, 5, 30);
+    build(_distanceCode, lengths, 30);
+}
+
+bool Inflater::readDynamicTables() {
+    size_t length_count = bits(5) + 257;
+    size_t distance_count = bits(5) + 1;
+    size_t code_length_count = bits(4) + 4;
+    if (_state == State::FAILED || length_count > 286 || distance_count > 30) {
+        return false;
+    }
+
+    uint8_t lengths[286 + 30] = {0};
+    for (size_t i = 0; i < code_length_count; i++) {
+        lengths[CODE_LENGTH_ORDER[i]] = bits(3);
+    }
+    // The code length code borrows the distance table until it's needed
+    if (!build(_distanceCode, lengths, 19)) {
+        return false;
+    }
+
+    memset(lengths, 0, 19);
+    size_t index = 0;
+    while (index < length_count + distance_count) {
+        int symbol = decode(_distanceCode);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+        uint8_t repeat_value = 0;
+        size_t repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            repeat_value = lengths[index - 1];
+            repeat = 3 + bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + bits(3);
+        } else {
+            repeat = 11 + bits(7);
+        }
+        if (index + repeat > length_count + distance_count) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = repeat_value;
+        }
+    }
+
+    // A block without an end-of-block code could never finish
+    if (lengths[256] == 0) {
+        return false;
+    }
+    return build(_lengthCode, lengths, length_count) &&
+           build(_distanceCode, lengths + length_count, distance_count) &&
+           _state != State::FAILED;
+}
+
+bool Inflater::readBlockHeader() {
+    _lastBlock = bits(1);
+    uint32_t type = bits(2);
+    if (_state == State::FAILED) {
+        return false;
+    }
+
+    switch (type) {
+        case 0: {
+            alignToByte();
+            int bytes[4];
+            for (int& value : bytes) {
+                value = nextByte();
+                if (value < 0) {
+                    return false;
+                }
+            }
+            uint16_t length = bytes[0] | (bytes[1] << 8);
+            uint16_t complement = bytes[2] | (bytes[3] << 8);
+            if (length != static_cast<uint16_t>(~complement)) {
+                return false;
+            }
+            _storedRemaining = length;
+            _state = State::STORED;
+            return true;
+        }
+        case 1:
+            buildFixedTables();
+            _state = State::HUFFMAN;
+            return true;
+        case 2:
+            if (!readDynamicTables()) {
+                return false;
+            }
+            _state = State::HUFFMAN;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Inflater::readTrailer() {
+    alignToByte();
+    uint32_t fields[2] = {0, 0};
+    for (uint32_t& field : fields) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int value = nextByte();
+            if (value < 0) {
+                return false;
+            }
+            field |= static_cast<uint32_t>(value) << shift;
+        }
+    }
+    return fields[0] == (_crc ^ 0xFFFFFFFF) && fields[1] == static_cast<uint32_t>(_bytesOut);
+}
+
+void Inflater::emit(uint8_t value, uint8_t* out, size_t& produced) {
+    out[produced++] = value;
+    _window[_windowPos] = value;
+    _windowPos = (_windowPos + 1) & WINDOW_MASK;
+    _crc ^= value;
+    _crc = (_crc >> 4) ^ CRC_TABLE[_crc & 15];
+    _crc = (_crc >> 4) ^ CRC_TABLE[_crc & 15];
+    _bytesOut++;
+}
+
+size_t Inflater::read(uint8_t* out, size_t length) {
+    size_t produced = 0;
+    while (produced < length) {
+        switch (_state) {
+            case State::HEADER:
+                if (!readGzipHeader()) {
+                    fail("not a gzip stream");
+                    break;
+                }
+                _state = State::BLOCK_HEADER;
+                break;
+
+            case State::BLOCK_HEADER:
+                if (_lastBlock) {
+                    _state = State::TRAILER;
+                } else if (!readBlockHeader()) {
+                    fail("malformed block header");
+                }
+                break;
+
+            case State::STORED:
+                while (_storedRemaining > 0 && produced < length) {
+                    int value = nextByte();
+                    if (value < 0) {
+                        fail("stored block cut short");
+                        return produced;
+                    }
+                    emit(value, out, produced);
+                    _storedRemaining--;
+                }
+                if (_storedRemaining == 0) {
+                    _state = State::BLOCK_HEADER;
+                }
+                break;
+
+            case State::HUFFMAN: {
+                while (_matchLength > 0 && produced < length) {
+                    emit(_window[(_windowPos - _matchDistance) & WINDOW_MASK], out, produced);
+                    _matchLength--;
+                }
+                if (produced == length) {
+                    break;
+                }
+
+                int symbol = decode(_lengthCode);
+                if (symbol < 0) {
+                    fail("bad literal/length code");
+                } else if (symbol < 256) {
+                    emit(symbol, out, produced);
+                } else if (symbol == 256) {
+                    _state = State::BLOCK_HEADER;
+                } else if (symbol - 257 >= 29) {
+                    fail("bad length symbol");
+                } else {
+                    symbol -= 257;
+                    uint16_t match_length = LENGTH_BASE[symbol] + bits(LENGTH_EXTRA[symbol]);
+                    int distance_symbol = decode(_distanceCode);
+                    if (distance_symbol < 0 || distance_symbol >= 30) {
+                        fail("bad distance code");
+                        break;
+                    }
+                    uint32_t distance = DISTANCE_BASE[distance_symbol] + bits(DISTANCE_EXTRA[distance_symbol]);
+                    if (distance > _bytesOut) {
+                        fail("distance before start of stream");
+                        break;
+                    }
+                    _matchLength = match_length;
+                    _matchDistance = distance;
+                }
+                break;
+            }
+
+            case State::TRAILER:
+                if (_gzip && !readTrailer()) {
+                    fail("gzip trailer mismatch");
+                } else {
+                    _state = State::DONE;
+                }
+                break;
+
+            case State::DONE:
+            case State::FAILED:
+                return produced;
+        }
+    }
+    return produced;
+}
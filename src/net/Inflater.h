@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+/**
+ * @class Inflater
+ * @brief Streaming gzip/deflate decoder with a fixed 32 KB window
+ *
+ * Decodes as the caller reads, pulling compressed input through a source
+ * callback, so neither the compressed nor the inflated body is ever held
+ * whole. Memory use is the window deflate requires (WINDOW_SIZE, leased
+ * from ParserArena so responses reuse the same few windows), a small input
+ * buffer and the Huffman tables.
+ *
+ * Checks the gzip trailer: a CRC or length mismatch fails the stream.
+ *
+ * Has no Arduino dependencies, so it builds and can be tested on host.
+ */
+class Inflater {
+public:
+    static constexpr size_t WINDOW_SIZE = 32768;  ///< Largest back-reference deflate allows
+    static constexpr size_t INPUT_SIZE = 256;     ///< Compressed bytes pulled per source call
+
+    /**
+     * @brief Reads up to length compressed bytes into buffer
+     * @return Bytes read; 0 at the end of the input
+     */
+    using Source = std::function<size_t(uint8_t* buffer, size_t length)>;
+
+    /**
+     * @brief Constructor
+     * @param source Where compressed bytes come from
+     * @param gzip true for a gzip member, false for a raw deflate stream
+     */
+    Inflater(Source source, bool gzip = true);
+    ~Inflater();
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    /**
+     * @brief Inflate up to length bytes
+     * @return Bytes written to out; less than length only at the end or on an error
+     */
+    size_t read(uint8_t* out, size_t length);
+
+    /**
+     * @brief Check if the whole stream, including its trailer, was decoded
+     */
+    bool finished() const { return _state == State::DONE; }
+
+    /**
+     * @brief Check if the input was malformed, cut short or failed its CRC
+     */
+    bool failed() const { return _state == State::FAILED; }
+
+    /**
+     * @brief Compressed bytes consumed so far
+     */
+    size_t bytesIn() const { return _bytesIn; }
+
+    /**
+     * @brief Inflated bytes produced so far
+     */
+    size_t bytesOut() const { return _bytesOut; }
+
+private:
+    enum class State : uint8_t { HEADER, BLOCK_HEADER, STORED, HUFFMAN, TRAILER, DONE, FAILED };
+
+    // Canonical Huffman code: number of codes per length, then symbols by code
+    struct Huffman {
+        uint16_t count[16];
+        uint16_t symbol[288];
+    };
+
+    int nextByte();
+    uint32_t bits(uint8_t count);
+    void alignToByte();
+    int decode(const Huffman& code);
+    bool build(Huffman& code, const uint8_t* lengths, size_t count);
+    bool readGzipHeader();
+    bool readBlockHeader();
+    bool readDynamicTables();
+    void buildFixedTables();
+    bool readTrailer();
+    void emit(uint8_t value, uint8_t* out, size_t& produced);
+    void fail(const char* reason);
+
+    Source _source;
+    bool _gzip;
+    State _state;
+    bool _lastBlock;
+
+    uint8_t _input[INPUT_SIZE];
+    size_t _inputPos;
+    size_t _inputLen;
+    bool _inputEnded;
+
+    uint32_t _bitBuffer;
+    uint8_t _bitCount;
+
+    uint8_t* _window;
+    size_t _windowPos;
+    uint32_t _storedRemaining;
+    uint16_t _matchLength;       ///< Bytes of the current back-reference still to copy
+    uint16_t _matchDistance;
+
+    Huffman _lengthCode;
+    Huffman _distanceCode;
+
+    uint32_t _crc;
+    size_t _bytesIn;
+    size_t _bytesOut;
+};
@@ -0,0 +1,421 @@
+#include "SecureClient.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <lwip/sockets.h>
+#include "esp_crt_bundle.h"
+#include "esp_random.h"
+
+namespace {
+// Last session and handshake stats of one host
+struct HostEntry {
+    mbedtls_ssl_session session;
+    bool has_session = false;
+    uint32_t full = 0;
+    uint32_t resumed = 0;
+    uint32_t failed = 0;
+    uint32_t full_ms = 0;
+    uint32_t resumed_ms = 0;
+
+    HostEntry() { mbedtls_ssl_session_init(&session); }
+    ~HostEntry() { mbedtls_ssl_session_free(&session); }
+};
+
+// Shared by every SecureClient, so a client made per request still resumes
+std::mutex cacheMutex;
+std::map<String, std::unique_ptr<HostEntry>> hostEntries;
+
+HostEntry& entryFor(const String& host) {
+    auto& entry = hostEntries[host];
+    if (!entry) {
+        entry.reset(new HostEntry());
+    }
+    return *entry;
+}
+
+int randomCallback(void*, unsigned char* out, size_t len) {
+    esp_fill_random(out, len);
+    return 0;
+}
+
+std::vector<unsigned char> sessionId(const mbedtls_ssl_session& session) {
+    const unsigned char* id = mbedtls_ssl_session_get_id(&session);
+    return std::vector<unsigned char>(id, id + mbedtls_ssl_session_get_id_len(&session));
+}
+
+// Serialised session, ticket included; empty if it can't be saved
+std::vector<unsigned char> sessionBytes(const mbedtls_ssl_session& session) {
+    size_t len = 0;
+    mbedtls_ssl_session_save(&session, nullptr, 0, &len);
+    std::vector<unsigned char> out(len);
+    if (len == 0 || mbedtls_ssl_session_save(&session, out.data(), out.size(), &len) != 0) {
+        out.clear();
+    }
+    return out;
+}
+}
+
+SecureClient::SecureClient()
+    : _confReady(false)
+    , _tlsActive(false)
+    , _resumed(false)
+    , _peeked(-1)
+    , _timeoutMs(DEFAULT_HANDSHAKE_TIMEOUT)
+    , _hasCaCert(false) {
+    mbedtls_ssl_init(&_ssl);
+    mbedtls_ssl_config_init(&_conf);
+    mbedtls_x509_crt_init(&_caCert);
+}
+
+SecureClient::~SecureClient() {
+    stop();
+    mbedtls_ssl_free(&_ssl);
+    mbedtls_ssl_config_free(&_conf);
+    mbedtls_x509_crt_free(&_caCert);
+}
+
+bool SecureClient::setCACert(const char* pem) {
+    stop();
+    mbedtls_x509_crt_free(&_caCert);
+    mbedtls_x509_crt_init(&_caCert);
+    _hasCaCert = false;
+
+    // The config holds the trust anchors, so build it again on the next connect
+    mbedtls_ssl_config_free(&_conf);
+    mbedtls_ssl_config_init(&_conf);
+    _confReady = false;
+
+    if (!pem) {
+        return true;
+    }
+    int ret = mbedtls_x509_crt_parse(&_caCert, reinterpret_cast<const unsigned char*>(pem), strlen(pem) + 1);
+    if (ret != 0) {
+        Serial.printf("[SecureClient] CA certificate rejected: -0x%04x\n", -ret);
+        return false;
+    }
+    _hasCaCert = true;
+    return true;
+}
+
+int SecureClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, _timeoutMs);
+}
+
+int SecureClient::connect(IPAddress ip, uint16_t port, int32_t timeout_ms) {
+    stop();
+    if (!WiFiClient::connect(ip, port, timeout_ms)) {
+        return 0;
+    }
+    return startTls(ip.toString().c_str()) ? 1 : 0;
+}
+
+int SecureClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, _timeoutMs);
+}
+
+int SecureClient::connect(const char* host, uint16_t port, int32_t timeout_ms) {
+    stop();
+    if (!WiFiClient::connect(host, port, timeout_ms)) {
+        return 0;
+    }
+    return startTls(host) ? 1 : 0;
+}
+
+bool SecureClient::startTls(const char* host) {
+    if (!_confReady) {
+        int ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT,
+                                              MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+        if (ret != 0) {
+            Serial.printf("[SecureClient] TLS config failed: -0x%04x\n", -ret);
+            WiFiClient::stop();
+            return false;
+        }
+        mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        if (_hasCaCert) {
+            mbedtls_ssl_conf_ca_chain(&_conf, &_caCert, nullptr);
+        } else {
+            esp_crt_bundle_attach(&_conf);
+        }
+        mbedtls_ssl_conf_rng(&_conf, randomCallback, nullptr);
+        mbedtls_ssl_conf_max_tls_version(&_conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        _confReady = true;
+    }
+    mbedtls_ssl_conf_read_timeout(&_conf, _timeoutMs);
+
+    int ret = mbedtls_ssl_setup(&_ssl, &_conf);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&_ssl, host);
+    }
+    if (ret != 0) {
+        Serial.printf("[SecureClient] TLS setup for %s failed: -0x%04x\n", host, -ret);
+        closeTls();
+        WiFiClient::stop();
+        return false;
+    }
+    mbedtls_ssl_set_bio(&_ssl, this, sendCallback, nullptr, recvCallback);
+
+    bool offered = false;
+    std::vector<unsigned char> offered_id;
+    std::vector<unsigned char> offered_bytes;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        HostEntry& entry = entryFor(host);
+        if (entry.has_session && mbedtls_ssl_set_session(&_ssl, &entry.session) == 0) {
+            offered = true;
+            offered_id = sessionId(entry.session);
+            if (offered_id.empty()) {
+                offered_bytes = sessionBytes(entry.session);
+            }
+        }
+    }
+
+    unsigned long start = millis();
+    while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            break;
+        }
+        uint32_t waited = millis() - start;
+        if (waited >= _timeoutMs) {
+            ret = MBEDTLS_ERR_SSL_TIMEOUT;
+            break;
+        }
+        waitForSocket(ret == MBEDTLS_ERR_SSL_WANT_WRITE, _timeoutMs - waited);
+    }
+    uint32_t elapsed = millis() - start;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    HostEntry& entry = entryFor(host);
+    if (ret != 0) {
+        entry.failed++;
+        uint32_t flags = mbedtls_ssl_get_verify_result(&_ssl);
+        Serial.printf("[SecureClient] Handshake with %s failed: -0x%04x, verify flags 0x%x\n",
+                      host, -ret, (unsigned)flags);
+        // The server may have forgotten the session; start over next time
+        if (offered) {
+            mbedtls_ssl_session_free(&entry.session);
+            mbedtls_ssl_session_init(&entry.session);
+            entry.has_session = false;
+        }
+        closeTls();
+        WiFiClient::stop();
+        return false;
+    }
+
+    // Keep the newest session; the server may have issued a new ticket
+    mbedtls_ssl_session_free(&entry.session);
+    mbedtls_ssl_session_init(&entry.session);
+    entry.has_session = mbedtls_ssl_get_session(&_ssl, &entry.session) == 0;
+
+    // mbedtls has no public "was this resumed" flag. A server resuming by
+    // session ID echoes the offered ID. One resuming by ticket hands back the
+    // offered session unchanged, unless it renews the ticket, which then
+    // counts as a full handshake.
+    _tlsActive = true;
+    if (offered && entry.has_session) {
+        _resumed = offered_id.empty() ? sessionBytes(entry.session) == offered_bytes
+                                      : sessionId(entry.session) == offered_id;
+    }
+    if (_resumed) {
+        entry.resumed++;
+        entry.resumed_ms += elapsed;
+    } else {
+        entry.full++;
+        entry.full_ms += elapsed;
+    }
+
+    Serial.printf("[SecureClient] %s handshake with %s in %lu ms\n",
+                  _resumed ? "Resumed" : "Full", host, (unsigned long)elapsed);
+    return true;
+}
+
+void SecureClient::closeTls() {
+    if (_tlsActive) {
+        mbedtls_ssl_close_notify(&_ssl);
+    }
+    // Freeing and re-initialising leaves the context ready for the next setup
+    mbedtls_ssl_free(&_ssl);
+    mbedtls_ssl_init(&_ssl);
+    _tlsActive = false;
+    _resumed = false;
+    _peeked = -1;
+}
+
+bool SecureClient::waitForSocket(bool writable, uint32_t timeout_ms) {
+    int sock = WiFiClient::fd();
+    if (sock < 0) {
+        return false;
+    }
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(sock, &set);
+    timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    return select(sock + 1, writable ? nullptr : &set, writable ? &set : nullptr, nullptr, &tv) > 0;
+}
+
+int SecureClient::sendCallback(void* ctx, const unsigned char* buf, size_t len) {
+    SecureClient* self = static_cast<SecureClient*>(ctx);
+    size_t sent = self->WiFiClient::write(buf, len);
+    if (sent > 0) {
+        return static_cast<int>(sent);
+    }
+    return self->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_CONN_RESET;
+}
+
+int SecureClient::recvCallback(void* ctx, unsigned char* buf, size_t len, uint32_t timeout_ms) {
+    SecureClient* self = static_cast<SecureClient*>(ctx);
+    unsigned long start = millis();
+    while (true) {
+        int ready = self->WiFiClient::available();
+        if (ready > 0) {
+            return self->WiFiClient::read(buf, std::min(len, static_cast<size_t>(ready)));
+        }
+        if (!self->WiFiClient::connected()) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+        uint32_t waited = millis() - start;
+        if (timeout_ms > 0 && waited >= timeout_ms) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        // Sleep until data arrives instead of polling; without a timeout,
+        // wake now and then to notice a dropped connection
+        uint32_t wait_ms = timeout_ms > 0 ? timeout_ms - waited : DEFAULT_HANDSHAKE_TIMEOUT;
+        if (!self->waitForSocket(false, wait_ms) && self->WiFiClient::fd() < 0) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+    }
+}
+
+size_t SecureClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t SecureClient::write(const uint8_t* buf, size_t size) {
+    if (!_tlsActive) {
+        return 0;
+    }
+    size_t sent = 0;
+    unsigned long start = millis();
+    while (sent < size) {
+        int ret = mbedtls_ssl_write(&_ssl, buf + sent, size - sent);
+        uint32_t waited = millis() - start;
+        if (ret > 0) {
+            sent += ret;
+        } else if ((ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) &&
+                   waited < _timeoutMs) {
+            waitForSocket(ret == MBEDTLS_ERR_SSL_WANT_WRITE, _timeoutMs - waited);
+        } else {
+            Serial.printf("[SecureClient] Write failed: -0x%04x\n", -ret);
+            closeTls();
+            break;
+        }
+    }
+    return sent;
+}
+
+int SecureClient::available() {
+    if (!_tlsActive) {
+        return _peeked >= 0 ? 1 : 0;
+    }
+    size_t buffered = mbedtls_ssl_get_bytes_avail(&_ssl);
+    if (buffered == 0 && WiFiClient::available() > 0) {
+        // Decrypt the next record without consuming any of it
+        int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            closeTls();
+            return 0;
+        }
+        buffered = mbedtls_ssl_get_bytes_avail(&_ssl);
+    }
+    return static_cast<int>(buffered) + (_peeked >= 0 ? 1 : 0);
+}
+
+int SecureClient::read() {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int SecureClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t offset = 0;
+    if (_peeked >= 0) {
+        buf[offset++] = static_cast<uint8_t>(_peeked);
+        _peeked = -1;
+        if (offset == size) {
+            return 1;
+        }
+    }
+    if (!_tlsActive || available() == 0) {
+        return offset > 0 ? static_cast<int>(offset) : -1;
+    }
+    int ret = mbedtls_ssl_read(&_ssl, buf + offset, size - offset);
+    if (ret > 0) {
+        return static_cast<int>(offset) + ret;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // Close notify, or a broken connection
+        closeTls();
+    }
+    return offset > 0 ? static_cast<int>(offset) : -1;
+}
+
+int SecureClient::peek() {
+    if (_peeked < 0) {
+        fillPeek();
+    }
+    return _peeked;
+}
+
+void SecureClient::fillPeek() {
+    uint8_t data;
+    if (_tlsActive && available() > 0 && mbedtls_ssl_read(&_ssl, &data, 1) == 1) {
+        _peeked = data;
+    }
+}
+
+void SecureClient::flush() {
+    // Records go out as they're written; WiFiClient::flush() would discard
+    // unread ciphertext
+}
+
+void SecureClient::stop() {
+    closeTls();
+    WiFiClient::stop();
+}
+
+uint8_t SecureClient::connected() {
+    if (!_tlsActive) {
+        return _peeked >= 0;
+    }
+    return WiFiClient::connected() || mbedtls_ssl_get_bytes_avail(&_ssl) > 0 || _peeked >= 0;
+}
+
+void SecureClient::clearSessions() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto& [host, entry] : hostEntries) {
+        mbedtls_ssl_session_free(&entry->session);
+        mbedtls_ssl_session_init(&entry->session);
+        entry->has_session = false;
+    }
+}
+
+void SecureClient::writeStats(JsonObject out) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (const auto& [host, entry] : hostEntries) {
+        JsonObject hostObj = out.createNestedObject(host);
+        hostObj["full_handshakes"] = entry->full;
+        hostObj["resumed_handshakes"] = entry->resumed;
+        hostObj["failed_handshakes"] = entry->failed;
+        hostObj["avg_full_ms"] = entry->full ? entry->full_ms / entry->full : 0;
+        hostObj["avg_resumed_ms"] = entry->resumed ? entry->resumed_ms / entry->resumed : 0;
+        hostObj["session_cached"] = entry->has_session;
+    }
+}
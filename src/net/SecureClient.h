@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <ArduinoJson.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+/**
+ * @class SecureClient
+ * @brief Verified TLS client that resumes sessions across reconnects
+ *
+ * Drop-in replacement for WiFiClientSecure with HTTPClient: TLS runs over
+ * the plain WiFiClient socket this class derives from. Differences:
+ * - Server certificates are checked against the CA bundle built into
+ *   ESP-IDF, or against one CA set with setCACert(), instead of
+ *   setInsecure()
+ * - The session of the last handshake with each host is kept in a cache
+ *   shared by every SecureClient, and offered on the next connection to
+ *   that host; the server then skips the key exchange and certificate
+ *   chain (session ID or session ticket resumption)
+ * - Every handshake is counted and timed per host, full and resumed
+ *   separately, so the saving shows in writeStats()
+ *
+ * Limited to TLS 1.2, where both resumption methods work without a
+ * round trip after the handshake.
+ *
+ * One instance per task; the session cache and stats are thread-safe.
+ */
+class SecureClient : public WiFiClient {
+public:
+    static constexpr uint32_t DEFAULT_HANDSHAKE_TIMEOUT = 10000;  ///< ms for the handshake and for each record
+
+    SecureClient();
+    ~SecureClient() override;
+
+    SecureClient(const SecureClient&) = delete;
+    SecureClient& operator=(const SecureClient&) = delete;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout_ms) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout_ms) override;
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+
+    /**
+     * @brief Longest wait for the handshake, and for each record after it
+     */
+    void setHandshakeTimeout(uint32_t timeout_ms) { _timeoutMs = timeout_ms; }
+
+    /**
+     * @brief Trust only this CA instead of the built-in bundle
+     *
+     * Meant for a local test server with its own CA. Closes any open
+     * connection; the next connect() uses the new trust anchor.
+     *
+     * @param pem CA certificate in PEM form, or nullptr to go back to the bundle
+     * @return false if the certificate couldn't be parsed
+     */
+    bool setCACert(const char* pem);
+
+    /**
+     * @brief Check if the current connection resumed a cached session
+     */
+    bool resumed() const { return _resumed; }
+
+    /**
+     * @brief Drop the cached session of every host
+     *
+     * The next connection to each host does a full handshake.
+     */
+    static void clearSessions();
+
+    /**
+     * @brief Report handshake counts and times per host
+     * @param out Object to fill, one member per host
+     */
+    static void writeStats(JsonObject out);
+
+private:
+    bool startTls(const char* host);
+    void closeTls();
+    void fillPeek();
+    bool waitForSocket(bool writable, uint32_t timeout_ms);
+
+    static int sendCallback(void* ctx, const unsigned char* buf, size_t len);
+    static int recvCallback(void* ctx, unsigned char* buf, size_t len, uint32_t timeout_ms);
+
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _conf;
+    bool _confReady;        ///< _conf is set up; it's reused by every connection
+    bool _tlsActive;        ///< Handshake done and not closed since
+    bool _resumed;
+    int _peeked;            ///< Byte read ahead by peek(), or -1
+    uint32_t _timeoutMs;
+    mbedtls_x509_crt _caCert;  ///< Trust anchor set by setCACert()
+    bool _hasCaCert;
+};
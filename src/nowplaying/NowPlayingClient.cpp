@@ -4,6 +4,8 @@ const char* NowPlayingClient::API_KEY = "acf2b63ef5ed315b1f94439b8fcc68e4";
 const char* NowPlayingClient::BASE_URL = "https://ws.audioscrobbler.com/2.0/";
 
 NowPlayingClient::NowPlayingClient(const String& username) : _username(username) {
+    static const char* header_keys[] = {"Transfer-Encoding", "Content-Encoding"};
+    _http.collectHeaders(header_keys, sizeof(header_keys) / sizeof(header_keys[0]));
 }
 
 bool NowPlayingClient::isReady() const {
@@ -19,8 +21,9 @@ bool NowPlayingClient::fetchNowPlayingData(NowPlayingData& data) {
     String url = buildLastFmUrl();
     Serial.printf("Fetching now playing from: %s\n", url.c_str());
     
-    _http.begin(url);
+    _http.begin(_client, url);
     _http.setTimeout(10000); // 10 second timeout
+    _http.addHeader("Accept-Encoding", "gzip");
     
     int httpCode = _http.GET();
     
@@ -30,12 +33,20 @@ bool NowPlayingClient::fetchNowPlayingData(NowPlayingData& data) {
         return false;
     }
     
-    String response = _http.getString();
-    _http.end();
-    
-    // Parse JSON response
+    // Parse JSON response straight off the socket, inflating if compressed
+    String transfer_encoding = _http.header("Transfer-Encoding");
+    transfer_encoding.toLowerCase();
+    HttpBodyStream body(*_http.getStreamPtr(), transfer_encoding.indexOf("chunked") >= 0, _http.getSize());
     DynamicJsonDocument doc(4096);
-    DeserializationError error = deserializeJson(doc, response);
+    DeserializationError error;
+    if (GzipStream::isGzip(_http.header("Content-Encoding"))) {
+        GzipStream inflated(body);
+        error = deserializeJson(doc, inflated);
+    } else {
+        error = deserializeJson(doc, body);
+    }
+    body.finish();
+    _http.end();
     
     if (error) {
         Serial.printf("JSON parsing failed: %s\n", error.c_str());
@@ -4,6 +4,9 @@
 #include <HTTPClient.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "../net/SecureClient.h"
+#include "../net/HttpBodyStream.h"
+#include "../net/GzipStream.h"
 
 struct NowPlayingData {
     String title;
@@ -28,6 +31,7 @@ private:
     static const char* BASE_URL;
     String _username;
     
+    SecureClient _client;
     HTTPClient _http;
     
     String buildLastFmUrl() const;
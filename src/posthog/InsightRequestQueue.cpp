@@ -0,0 +1,131 @@
+#include "InsightRequestQueue.h"
+#include <algorithm>
+
+namespace {
+// Wrap-safe "a is at or after b" for millis() values
+bool reached(unsigned long now, unsigned long deadline) {
+    return static_cast<long>(now - deadline) >= 0;
+}
+}
+
+void InsightRequestQueue::merge(QueuedRequest& into, const QueuedRequest& from) {
+    into.force_refresh = into.force_refresh || from.force_refresh;
+    // A card asking for data needs it published even if it didn't change
+    into.is_refresh = into.is_refresh && from.is_refresh;
+    into.retry_count = std::min(into.retry_count, from.retry_count);
+    into.solo = into.solo || from.solo;
+    // A calculation already started serves the merged request too
+    if (into.query_id.length() == 0) {
+        into.query_id = from.query_id;
+        into.poll_count = from.poll_count;
+    }
+    // Keep the later backoff; the host it waits for is the same
+    if (reached(from.not_before, into.not_before)) {
+        into.not_before = from.not_before;
+    }
+}
+
+bool InsightRequestQueue::push(const QueuedRequest& request) {
+    auto flying = _inFlight.find(request.insight_id);
+    if (flying != _inFlight.end() && (!request.force_refresh || flying->second.force_refresh)) {
+        // The answer on its way serves this request too
+        flying->second.is_refresh = flying->second.is_refresh && request.is_refresh;
+        return false;
+    }
+
+    auto pending = _pending.find(request.insight_id);
+    if (pending != _pending.end()) {
+        merge(pending->second, request);
+        return false;
+    }
+
+    _pending[request.insight_id] = request;
+    _order.push_back(request.insight_id);
+    return true;
+}
+
+bool InsightRequestQueue::isReady(const QueuedRequest& request, unsigned long now) const {
+    return reached(now, request.not_before) && _inFlight.count(request.insight_id) == 0;
+}
+
+bool InsightRequestQueue::hasReady(unsigned long now) const {
+    for (const String& id : _order) {
+        if (isReady(_pending.at(id), now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InsightRequestQueue::takeNext(unsigned long now, QueuedRequest& request) {
+    for (auto it = _order.begin(); it != _order.end(); ++it) {
+        auto pending = _pending.find(*it);
+        if (!isReady(pending->second, now)) {
+            continue;
+        }
+        request = pending->second;
+        _inFlight[*it] = request;
+        _pending.erase(pending);
+        _order.erase(it);
+        return true;
+    }
+    return false;
+}
+
+std::vector<QueuedRequest> InsightRequestQueue::ready(unsigned long now) const {
+    std::vector<QueuedRequest> requests;
+    for (const String& id : _order) {
+        const QueuedRequest& request = _pending.at(id);
+        if (isReady(request, now)) {
+            requests.push_back(request);
+        }
+    }
+    return requests;
+}
+
+bool InsightRequestQueue::take(const String& insight_id, unsigned long now, QueuedRequest& request) {
+    auto pending = _pending.find(insight_id);
+    if (pending == _pending.end() || !isReady(pending->second, now)) {
+        return false;
+    }
+    request = pending->second;
+    _inFlight[insight_id] = request;
+    _pending.erase(pending);
+    _order.erase(std::find(_order.begin(), _order.end(), insight_id));
+    return true;
+}
+
+bool InsightRequestQueue::finish(const String& insight_id, QueuedRequest& request) {
+    auto it = _inFlight.find(insight_id);
+    if (it == _inFlight.end()) {
+        return false;
+    }
+    request = it->second;
+    _inFlight.erase(it);
+    return true;
+}
+
+size_t InsightRequestQueue::waiting(unsigned long now) const {
+    size_t count = 0;
+    for (const auto& [id, request] : _pending) {
+        if (!reached(now, request.not_before)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t InsightRequestQueue::polling() const {
+    size_t count = 0;
+    for (const auto& [id, request] : _pending) {
+        if (request.query_id.length() > 0) {
+            count++;
+        }
+    }
+    for (const auto& [id, request] : _inFlight) {
+        if (request.query_id.length() > 0) {
+            count++;
+        }
+    }
+    return count;
+}
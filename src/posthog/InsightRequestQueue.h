@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+/**
+ * @struct QueuedRequest
+ * @brief Tracks a queued insight request
+ */
+struct QueuedRequest {
+    String insight_id;        ///< ID of insight to fetch
+    uint8_t retry_count;      ///< Number of retry attempts
+    bool force_refresh;       ///< Force recalculation instead of cache
+    bool is_refresh;          ///< Background refresh; skipped if the insight is unchanged
+    unsigned long not_before; ///< millis() when the request may go out; later after a failure
+    String query_id;          ///< Async calculation to poll instead of fetching the insight, or empty
+    uint8_t poll_count = 0;   ///< Status polls of query_id so far
+    bool solo = false;        ///< Fetch on its own, never as part of a dashboard batch
+};
+
+/**
+ * @class InsightRequestQueue
+ * @brief FIFO of insight requests with at most one entry per insight
+ *
+ * Each insight has at most one pending and at most one in-flight request:
+ * - A request for an insight that is already pending is merged into that
+ *   entry, keeping its place in line. A force refresh upgrades it.
+ * - A request for an insight that is in flight is merged into the in-flight
+ *   one, unless it asks for a force refresh the in-flight one isn't doing.
+ *   Then it waits in the queue until the in-flight request finishes.
+ *
+ * Failed requests, and requests polling an async calculation, are pushed
+ * back with a not_before time and are skipped until it passes.
+ *
+ * Not thread-safe; PostHogClient guards it with its queue mutex.
+ */
+class InsightRequestQueue {
+public:
+    /**
+     * @brief Queue a request, or merge it into one already queued or in flight
+     * @param request Request to add
+     * @return true if it was added as a new entry, false if merged
+     */
+    bool push(const QueuedRequest& request);
+
+    /**
+     * @brief Check whether takeNext() would return a request
+     * @param now Current millis()
+     */
+    bool hasReady(unsigned long now) const;
+
+    /**
+     * @brief Take the oldest request that may be sent now
+     * @param now Current millis()
+     * @param request Receives the request
+     * @return true if one was ready
+     *
+     * Skips requests whose insight is in flight or whose retry isn't due
+     * yet. The request counts as in flight until finish().
+     */
+    bool takeNext(unsigned long now, QueuedRequest& request);
+
+    /**
+     * @brief List the requests takeNext() could return now, oldest first
+     * @param now Current millis()
+     * @return Copies of the ready requests; they stay pending
+     */
+    std::vector<QueuedRequest> ready(unsigned long now) const;
+
+    /**
+     * @brief Take a particular insight's request, if it may be sent now
+     * @param insight_id Insight whose request to take
+     * @param now Current millis()
+     * @param request Receives the request
+     * @return true if the insight had a ready request
+     *
+     * Like takeNext(), the request counts as in flight until finish().
+     */
+    bool take(const String& insight_id, unsigned long now, QueuedRequest& request);
+
+    /**
+     * @brief Mark an insight's in-flight request as done
+     * @param insight_id Insight whose request finished
+     * @param request Receives the request, including anything merged into it
+     *        while it was in flight
+     * @return false if the insight had no request in flight
+     */
+    bool finish(const String& insight_id, QueuedRequest& request);
+
+    /**
+     * @brief Number of pending requests, not counting those in flight
+     */
+    size_t size() const { return _pending.size(); }
+
+    /**
+     * @brief Check whether no requests are pending
+     */
+    bool empty() const { return _pending.empty(); }
+
+    /**
+     * @brief Number of pending requests waiting out a retry backoff
+     * @param now Current millis()
+     */
+    size_t waiting(unsigned long now) const;
+
+    /**
+     * @brief Number of requests waiting on an async calculation
+     */
+    size_t polling() const;
+
+private:
+    static void merge(QueuedRequest& into, const QueuedRequest& from);
+    bool isReady(const QueuedRequest& request, unsigned long now) const;
+
+    std::deque<String> _order;                    ///< Pending insight IDs, oldest first
+    std::map<String, QueuedRequest> _pending;     ///< Pending request of each insight
+    std::map<String, QueuedRequest> _inFlight;    ///< In-flight request of each insight
+};
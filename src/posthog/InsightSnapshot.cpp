@@ -0,0 +1,488 @@
+#include "InsightSnapshot.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+namespace {
+// Cursor over an encode/decode buffer that stops at the end instead of
+// overrunning it. Fields are copied in native byte order, which is
+// little-endian on both the ESP32 and host builds.
+class Cursor {
+public:
+    Cursor(uint8_t* data, size_t size) : _data(data), _size(size), _pos(0), _ok(true) {}
+
+    void put(const void* src, size_t length) {
+        if (!reserve(length)) return;
+        if (_data) memcpy(_data + _pos, src, length);
+        _pos += length;
+    }
+
+    void get(void* dst, size_t length) {
+        if (!reserve(length)) return;
+        memcpy(dst, _data + _pos, length);
+        _pos += length;
+    }
+
+    // Strings are a length byte followed by the characters, without the NUL
+    void putString(const char* str) {
+        uint8_t length = static_cast<uint8_t>(std::min(strlen(str), static_cast<size_t>(255)));
+        put(&length, 1);
+        put(str, length);
+    }
+
+    void getString(char* dst, size_t capacity) {
+        uint8_t length = 0;
+        get(&length, 1);
+        if (!reserve(length)) return;
+        size_t kept = std::min(static_cast<size_t>(length), capacity - 1);
+        memcpy(dst, _data + _pos, kept);
+        dst[kept] = '\0';
+        _pos += length;
+    }
+
+    size_t pos() const { return _pos; }
+    bool ok() const { return _ok; }
+
+private:
+    bool reserve(size_t length) {
+        // A null buffer only measures
+        if (_data && _pos + length > _size) {
+            _ok = false;
+        }
+        return _ok;
+    }
+
+    uint8_t* _data;
+    size_t _size;
+    size_t _pos;
+    bool _ok;
+};
+
+void copyString(char* dst, size_t capacity, const char* src) {
+    strncpy(dst, src, capacity - 1);
+    dst[capacity - 1] = '\0';
+}
+
+// How the x labels of a snapshot are encoded
+enum : uint8_t {
+    LABELS_STRINGS = 0,  // One string per point
+    LABELS_DAYS = 1      // The first date, then a byte per point of days since the one before
+};
+
+// Write days since 1970-01-01 as YYYY-MM-DD
+void formatDate(int32_t days, char* out, size_t capacity) {
+    // Civil-from-days over 400-year eras, which repeat exactly
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int32_t day_of_era = days - era * 146097;
+    int32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int32_t shifted_month = (5 * day_of_year + 2) / 153;  // March is 0
+    int32_t day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    int32_t month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    int32_t year = year_of_era + era * 400 + (month <= 2);
+    snprintf(out, capacity, "%04d-%02d-%02d", static_cast<int>(year), static_cast<int>(month), static_cast<int>(day));
+}
+
+// Read a YYYY-MM-DD date as days since 1970-01-01; false for anything
+// that wouldn't be written back exactly the same
+bool parseDate(const char* label, int32_t* days) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (strlen(label) != 10 || sscanf(label, "%4d-%2d-%2d", &year, &month, &day) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    int32_t year_of_era = year - era * 400;
+    int32_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    *days = era * 146097 + day_of_era - 719468;
+
+    char check[InsightSnapshot::LABEL_SIZE];
+    formatDate(*days, check, sizeof(check));
+    return strcmp(check, label) == 0;
+}
+
+// Days from each label to the next, if every label is a date at most 255
+// days after the one before it
+bool daySteps(const InsightSnapshot& snapshot, size_t points, std::vector<uint8_t>& steps) {
+    int32_t previous = 0;
+    for (size_t i = 0; i < points; i++) {
+        int32_t day = 0;
+        if (!parseDate(snapshot.xLabel(i), &day)) {
+            return false;
+        }
+        if (i > 0) {
+            if (day < previous || day - previous > 255) {
+                return false;
+            }
+            steps.push_back(static_cast<uint8_t>(day - previous));
+        }
+        previous = day;
+    }
+    return true;
+}
+
+// A funnel step's custom name, or its event or action name
+void copyStepName(char* dst, size_t capacity, JsonObjectConst step) {
+    const char* name = step[JSON_KEY_CUSTOM_NAME];
+    if (!name) {
+        name = step[JSON_KEY_NAME];
+    }
+    copyString(dst, capacity, name ? name : "");
+}
+}
+
+InsightSnapshot InsightSnapshot::fromParser(const InsightParser& parser) {
+    InsightSnapshot snapshot;
+    snapshot.type = parser.getInsightType();
+    if (!parser.getName(snapshot.title, sizeof(snapshot.title))) {
+        copyString(snapshot.title, sizeof(snapshot.title), "Insight");
+    }
+
+    // Everything below walks the result once; the per-index getters would
+    // look each point and step up from the document root again
+    JsonVariantConst result = parser.m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+
+    switch (snapshot.type) {
+        case InsightParser::InsightType::NUMERIC_CARD:
+            snapshot.numeric_value = parser.getNumericCardValue();
+            parser.getNumericFormattingPrefix(snapshot.prefix, sizeof(snapshot.prefix));
+            parser.getNumericFormattingSuffix(snapshot.suffix, sizeof(snapshot.suffix));
+            break;
+
+        case InsightParser::InsightType::LINE_GRAPH:
+        case InsightParser::InsightType::AREA_CHART:
+            extractSeries(result, snapshot);
+            break;
+
+        case InsightParser::InsightType::FUNNEL:
+            if (parser.private_hasFunnelResultData()) {
+                extractFunnel(result, snapshot);
+            } else if (!result.isNull()) {
+                // Not calculated yet: the steps are named, but have no counts
+                extractFunnelSteps(parser.m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS], snapshot);
+            }
+            break;
+
+        default:
+            break;
+    }
+    return snapshot;
+}
+
+void InsightSnapshot::extractSeries(JsonArrayConst result, InsightSnapshot& snapshot) {
+    if (result[0].is<JsonObjectConst>()) {
+        extractSeriesObjects(result, snapshot);
+    } else {
+        extractSeriesRows(result, snapshot);
+    }
+}
+
+void InsightSnapshot::extractSeriesRows(JsonArrayConst rows, InsightSnapshot& snapshot) {
+    // [date_string, value_0, value_1, ...]
+    JsonArrayConst first = rows[0];
+    size_t series_count = std::min(first.size() > 1 ? first.size() - 1 : 0, MAX_SERIES);
+    size_t points = rows.size();
+    snapshot.series_count = static_cast<uint8_t>(series_count);
+    snapshot.values.assign(series_count * points, 0.0f);
+    snapshot.x_labels.assign(points * LABEL_SIZE, '\0');
+
+    size_t index = 0;
+    for (JsonArrayConst point : rows) {
+        for (size_t series = 0; series < series_count; series++) {
+            snapshot.values[series * points + index] = point[series + 1].as<float>();
+        }
+        const char* date = point[0];
+        if (date) {
+            // Keeps the date, drops any time of day
+            copyString(&snapshot.x_labels[index * LABEL_SIZE], LABEL_SIZE, date);
+        }
+        index++;
+    }
+}
+
+void InsightSnapshot::extractSeriesObjects(JsonArrayConst result, InsightSnapshot& snapshot) {
+    // One object per series, each with its own data and days; the first
+    // series' days label the shared x axis
+    size_t series_count = std::min(result.size(), MAX_SERIES);
+    size_t points = result[0][JSON_KEY_DATA].size();
+    snapshot.series_count = static_cast<uint8_t>(series_count);
+    snapshot.values.assign(series_count * points, 0.0f);
+    snapshot.x_labels.assign(points * LABEL_SIZE, '\0');
+
+    size_t series = 0;
+    for (JsonObjectConst item : result) {
+        if (series == series_count) break;
+        float* column = &snapshot.values[series * points];
+        size_t index = 0;
+        // A shorter series keeps its zero padding; a longer one is cut to the axis
+        for (JsonVariantConst value : item[JSON_KEY_DATA].as<JsonArrayConst>()) {
+            if (index == points) break;
+            column[index++] = value.as<float>();
+        }
+
+        const char* label = item[JSON_KEY_LABEL];
+        copyString(snapshot.series_names[series], SERIES_NAME_SIZE, label ? label : "");
+        const char* compare_label = item[JSON_KEY_COMPARE_LABEL];
+        if (compare_label && strcmp(compare_label, JSON_VAL_COMPARE_PREVIOUS) == 0) {
+            snapshot.previous_period |= 1 << series;
+        }
+        series++;
+    }
+
+    size_t index = 0;
+    for (JsonVariantConst day : result[0][JSON_KEY_DAYS].as<JsonArrayConst>()) {
+        if (index == points) break;
+        const char* date = day;
+        if (date) {
+            copyString(&snapshot.x_labels[index * LABEL_SIZE], LABEL_SIZE, date);
+        }
+        index++;
+    }
+}
+
+void InsightSnapshot::extractFunnel(JsonArrayConst result, InsightSnapshot& snapshot) {
+    // A funnel without breakdowns is a flat list of steps; with breakdowns
+    // it is a list of such lists, one per breakdown
+    if (!result[0].is<JsonArrayConst>()) {
+        readFunnelBreakdown(result, 0, snapshot);
+        snapshot.funnel_breakdowns = 1;
+        return;
+    }
+
+    size_t breakdown = 0;
+    for (JsonArrayConst steps : result) {
+        if (breakdown == MAX_BREAKDOWNS) break;
+        readFunnelBreakdown(steps, breakdown++, snapshot);
+    }
+    snapshot.funnel_breakdowns = static_cast<uint8_t>(breakdown);
+}
+
+void InsightSnapshot::readFunnelBreakdown(JsonArrayConst steps, size_t breakdown, InsightSnapshot& snapshot) {
+    size_t step = 0;
+    for (JsonObjectConst item : steps) {
+        if (step == MAX_FUNNEL_STEPS) break;
+        uint32_t count = item[JSON_KEY_COUNT].as<uint32_t>();
+        snapshot.breakdown_counts[step][breakdown] = count;
+        snapshot.step_totals[step] += count;
+        // Every breakdown has the same steps; names come from the first
+        if (breakdown == 0) {
+            copyStepName(snapshot.step_names[step], sizeof(snapshot.step_names[step]), item);
+        }
+        step++;
+    }
+    if (breakdown == 0) {
+        snapshot.funnel_steps = static_cast<uint8_t>(step);
+    }
+}
+
+void InsightSnapshot::extractFunnelSteps(JsonObjectConst filters, InsightSnapshot& snapshot) {
+    size_t step = 0;
+    for (const char* key : {JSON_KEY_EVENTS, JSON_KEY_ACTIONS}) {
+        for (JsonObjectConst item : filters[key].as<JsonArrayConst>()) {
+            if (step == MAX_FUNNEL_STEPS) break;
+            copyStepName(snapshot.step_names[step], sizeof(snapshot.step_names[step]), item);
+            step++;
+        }
+    }
+    snapshot.funnel_steps = static_cast<uint8_t>(step);
+    snapshot.funnel_breakdowns = 1;
+}
+
+void InsightSnapshot::downsample(size_t max_points) {
+    size_t points = pointCount();
+    if (max_points < 3 || points <= max_points) {
+        return;
+    }
+
+    // Points are evenly spaced in time, so x is the index. The first and
+    // last points are kept; the rest split into max_points - 2 buckets of
+    // at least one point each
+    size_t buckets = max_points - 2;
+    auto bucketStart = [&](size_t bucket) {
+        return std::min(1 + bucket * (points - 2) / buckets, points);
+    };
+
+    std::vector<size_t> kept;
+    kept.reserve(max_points);
+    kept.push_back(0);
+    std::vector<double> next_average(series_count);
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        size_t start = bucketStart(bucket);
+        size_t end = bucketStart(bucket + 1);
+        // The next bucket's average is the triangle's far corner; after the
+        // last bucket that is just the last point
+        size_t next_start = end;
+        size_t next_end = bucket + 1 < buckets ? bucketStart(bucket + 2) : points;
+        double next_x = (next_start + next_end - 1) / 2.0;
+        for (size_t series = 0; series < series_count; series++) {
+            const float* y = seriesValues(series);
+            double sum = 0.0;
+            for (size_t i = next_start; i < next_end; i++) {
+                sum += y[i];
+            }
+            next_average[series] = sum / (next_end - next_start);
+        }
+
+        size_t previous = kept.back();
+        size_t best = start;
+        double best_area = -1.0;
+        for (size_t i = start; i < end; i++) {
+            // Twice the triangle's area, which ranks the same
+            double area = 0.0;
+            for (size_t series = 0; series < series_count; series++) {
+                const float* y = seriesValues(series);
+                area += fabs((previous - next_x) * (y[i] - y[previous]) -
+                             (previous - static_cast<double>(i)) * (next_average[series] - y[previous]));
+            }
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        kept.push_back(best);
+    }
+    kept.push_back(points - 1);
+
+    std::vector<float> kept_values(series_count * kept.size());
+    std::vector<char> kept_labels(kept.size() * LABEL_SIZE, '\0');
+    for (size_t k = 0; k < kept.size(); k++) {
+        for (size_t series = 0; series < series_count; series++) {
+            kept_values[series * kept.size() + k] = seriesValues(series)[kept[k]];
+        }
+        copyString(&kept_labels[k * LABEL_SIZE], LABEL_SIZE, xLabel(kept[k]));
+    }
+    values.swap(kept_values);
+    x_labels.swap(kept_labels);
+}
+
+size_t InsightSnapshot::encodedSize() const {
+    return encode(nullptr, 0);
+}
+
+size_t InsightSnapshot::encode(uint8_t* out, size_t capacity) const {
+    Cursor cursor(out, capacity);
+    uint8_t version = FORMAT_VERSION;
+    uint8_t type_id = static_cast<uint8_t>(type);
+    cursor.put(&version, 1);
+    cursor.put(&type_id, 1);
+    cursor.putString(title);
+
+    cursor.put(&numeric_value, sizeof(numeric_value));
+    cursor.putString(prefix);
+    cursor.putString(suffix);
+
+    uint16_t points = static_cast<uint16_t>(std::min(pointCount(), static_cast<size_t>(UINT16_MAX)));
+    cursor.put(&series_count, 1);
+    cursor.put(&previous_period, 1);
+    cursor.put(&points, sizeof(points));
+    for (size_t series = 0; series < series_count; series++) {
+        cursor.putString(series_names[series]);
+        if (points) {
+            cursor.put(seriesValues(series), points * sizeof(float));
+        }
+    }
+
+    // Trend dates step by whole days, so after the first each takes a byte;
+    // anything else is kept as strings
+    std::vector<uint8_t> steps;
+    uint8_t label_format = points && daySteps(*this, points, steps) ? LABELS_DAYS : LABELS_STRINGS;
+    cursor.put(&label_format, 1);
+    if (label_format == LABELS_DAYS) {
+        cursor.putString(xLabel(0));
+        if (!steps.empty()) {
+            cursor.put(steps.data(), steps.size());
+        }
+    } else {
+        for (size_t i = 0; i < points; i++) {
+            cursor.putString(xLabel(i));
+        }
+    }
+
+    cursor.put(&funnel_steps, 1);
+    cursor.put(&funnel_breakdowns, 1);
+    for (size_t step = 0; step < funnel_steps; step++) {
+        cursor.putString(step_names[step]);
+        cursor.put(&step_totals[step], sizeof(uint32_t));
+        cursor.put(breakdown_counts[step], funnel_breakdowns * sizeof(uint32_t));
+    }
+    return cursor.ok() ? cursor.pos() : 0;
+}
+
+bool InsightSnapshot::decode(const uint8_t* data, size_t size) {
+    *this = InsightSnapshot();
+    // Reads only; the cursor never writes through the pointer when decoding
+    Cursor cursor(const_cast<uint8_t*>(data), size);
+
+    uint8_t version = 0;
+    uint8_t type_id = 0;
+    cursor.get(&version, 1);
+    if (!cursor.ok() || version != FORMAT_VERSION) {
+        return false;
+    }
+    cursor.get(&type_id, 1);
+    type = static_cast<InsightParser::InsightType>(type_id);
+    cursor.getString(title, sizeof(title));
+
+    cursor.get(&numeric_value, sizeof(numeric_value));
+    cursor.getString(prefix, sizeof(prefix));
+    cursor.getString(suffix, sizeof(suffix));
+
+    uint16_t points = 0;
+    cursor.get(&series_count, 1);
+    cursor.get(&previous_period, 1);
+    cursor.get(&points, sizeof(points));
+    if (!cursor.ok() || series_count > MAX_SERIES || cursor.pos() + series_count * points * sizeof(float) > size) {
+        return false;
+    }
+    values.resize(series_count * points);
+    for (size_t series = 0; series < series_count; series++) {
+        cursor.getString(series_names[series], SERIES_NAME_SIZE);
+        if (points) {
+            cursor.get(&values[series * points], points * sizeof(float));
+        }
+    }
+    x_labels.assign(points * LABEL_SIZE, '\0');
+    uint8_t label_format = LABELS_STRINGS;
+    cursor.get(&label_format, 1);
+    if (label_format == LABELS_DAYS && points) {
+        char first[LABEL_SIZE];
+        int32_t day = 0;
+        cursor.getString(first, sizeof(first));
+        if (!cursor.ok() || !parseDate(first, &day)) {
+            return false;
+        }
+        for (size_t i = 0; i < points; i++) {
+            if (i > 0) {
+                uint8_t step = 0;
+                cursor.get(&step, 1);
+                day += step;
+            }
+            formatDate(day, &x_labels[i * LABEL_SIZE], LABEL_SIZE);
+        }
+    } else if (label_format == LABELS_STRINGS) {
+        for (size_t i = 0; i < points; i++) {
+            cursor.getString(&x_labels[i * LABEL_SIZE], LABEL_SIZE);
+        }
+    } else {
+        return false;
+    }
+
+    cursor.get(&funnel_steps, 1);
+    cursor.get(&funnel_breakdowns, 1);
+    if (funnel_steps > MAX_FUNNEL_STEPS || funnel_breakdowns > MAX_BREAKDOWNS) {
+        return false;
+    }
+    for (size_t step = 0; step < funnel_steps; step++) {
+        cursor.getString(step_names[step], sizeof(step_names[step]));
+        cursor.get(&step_totals[step], sizeof(uint32_t));
+        cursor.get(breakdown_counts[step], funnel_breakdowns * sizeof(uint32_t));
+    }
+    return cursor.ok();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "parsers/InsightParser.h"
+
+/**
+ * @struct InsightSnapshot
+ * @brief Compact copy of the data an InsightCard renders
+ *
+ * Holds just what the renderers draw - title, numeric value, series and
+ * funnel steps - in plain fields, so it can outlive the parser's JSON
+ * document and be persisted by SnapshotStore. Builds on host as well as
+ * on the device.
+ *
+ * Extracted in a single walk of the document on the connection worker,
+ * which then frees the document; cards only ever hold the snapshot, at
+ * most about 4 KB for four full-width series, instead of the parse
+ * document. Encoded, dates take a byte each after the first.
+ */
+struct InsightSnapshot {
+    static constexpr uint8_t FORMAT_VERSION = 5;   ///< Bumped whenever the encoding changes
+    static constexpr size_t MAX_FUNNEL_STEPS = 5;  ///< Steps the funnel renderer can show
+    static constexpr size_t MAX_BREAKDOWNS = 5;    ///< Breakdowns the funnel renderer can show
+    static constexpr size_t LABEL_SIZE = 11;       ///< Bytes per x label: a YYYY-MM-DD date and its NUL
+    static constexpr size_t MAX_SERIES = 4;        ///< Series the line graph renderer can show
+    static constexpr size_t SERIES_NAME_SIZE = 24; ///< Bytes per series name, NUL included
+    static constexpr size_t MAX_CHART_POINTS = 230; ///< Line graph width in pixels; longer series are downsampled to it
+
+    InsightParser::InsightType type = InsightParser::InsightType::INSIGHT_NOT_SUPPORTED;
+    char title[64] = "";
+
+    // Numeric card
+    double numeric_value = 0.0;
+    char prefix[16] = "";                          ///< Formatting prefix, e.g. "$"
+    char suffix[16] = "";                          ///< Formatting suffix, e.g. "%"
+
+    // Line graph, stored by column: every series shares x_labels
+    uint8_t series_count = 0;
+    uint8_t previous_period = 0;                   ///< Bit per series that is a compare-to-previous period
+    char series_names[MAX_SERIES][SERIES_NAME_SIZE] = {};
+    std::vector<float> values;                     ///< series_count runs of pointCount() y values, back to back
+    std::vector<char> x_labels;                    ///< One LABEL_SIZE label per point, back to back
+
+    // Funnel
+    uint8_t funnel_steps = 0;
+    uint8_t funnel_breakdowns = 0;
+    char step_names[MAX_FUNNEL_STEPS][48] = {};
+    uint32_t step_totals[MAX_FUNNEL_STEPS] = {};   ///< Users at each step, summed over breakdowns
+    uint32_t breakdown_counts[MAX_FUNNEL_STEPS][MAX_BREAKDOWNS] = {}; ///< Users at each step per breakdown
+
+    /**
+     * @brief Copy the renderable data out of a parsed insight
+     * @param parser Valid parser
+     * @return Snapshot of the insight; steps and breakdowns past the limits are dropped
+     */
+    static InsightSnapshot fromParser(const InsightParser& parser);
+
+    /**
+     * @brief Points in each series
+     */
+    size_t pointCount() const {
+        return series_count ? values.size() / series_count : 0;
+    }
+
+    /**
+     * @brief Y values of one series
+     * @param index Series index
+     * @return pointCount() contiguous values, or nullptr past the last series
+     */
+    const float* seriesValues(size_t index) const {
+        return index < series_count && pointCount() ? &values[index * pointCount()] : nullptr;
+    }
+
+    /**
+     * @brief X label of a series point
+     * @param index Point index
+     * @return Date of the point, or "" past the end
+     */
+    const char* xLabel(size_t index) const {
+        return index < pointCount() && (index + 1) * LABEL_SIZE <= x_labels.size() ? &x_labels[index * LABEL_SIZE] : "";
+    }
+
+    /**
+     * @brief Reduce the series to at most max_points, keeping their shape
+     * @param max_points Points to keep, e.g. the chart's width in pixels; below 3 does nothing
+     *
+     * Largest-Triangle-Three-Buckets: keeps the first and last points and,
+     * from each bucket of points between them, the one forming the largest
+     * triangle with the point kept before it and the average of the next
+     * bucket. Peaks survive where picking every nth point would step over
+     * them. Areas are summed over the series, which share the chart's y
+     * axis, so one choice of points serves all of them and they keep
+     * sharing x labels.
+     */
+    void downsample(size_t max_points);
+
+    /**
+     * @brief Size of the binary encoding
+     */
+    size_t encodedSize() const;
+
+    /**
+     * @brief Write the binary encoding
+     * @param out Buffer of at least encodedSize() bytes
+     * @param capacity Size of the buffer
+     * @return Bytes written, or 0 if the buffer is too small
+     */
+    size_t encode(uint8_t* out, size_t capacity) const;
+
+    /**
+     * @brief Read a binary encoding written by encode()
+     * @param data Encoded snapshot, e.g. straight from mapped flash
+     * @param size Length of the encoding
+     * @return false if the data is truncated or from another FORMAT_VERSION
+     */
+    bool decode(const uint8_t* data, size_t size);
+
+private:
+    static void extractSeries(JsonArrayConst result, InsightSnapshot& snapshot);
+    static void extractSeriesRows(JsonArrayConst rows, InsightSnapshot& snapshot);
+    static void extractSeriesObjects(JsonArrayConst result, InsightSnapshot& snapshot);
+    static void extractFunnel(JsonArrayConst result, InsightSnapshot& snapshot);
+    static void readFunnelBreakdown(JsonArrayConst steps, size_t breakdown, InsightSnapshot& snapshot);
+    static void extractFunnelSteps(JsonObjectConst filters, InsightSnapshot& snapshot);
+};
@@ -1,27 +1,117 @@
 #include "PostHogClient.h"
 #include "../ConfigManager.h"
+#include <algorithm>
 
+// Keeps only the completion fields of a query status response
+static StaticJsonDocument<64> createQueryStatusFilter() {
+    StaticJsonDocument<64> filter;
+    filter["query_status"]["complete"] = true;
+    filter["query_status"]["error"] = true;
+    return filter;
+}
+
+// Keeps each tile's short ID and the insight fields InsightParser uses
+static StaticJsonDocument<512> createDashboardFilter() {
+    StaticJsonDocument<512> filter;
+    JsonObject insight = filter[JSON_KEY_TILES][0][JSON_KEY_INSIGHT].to<JsonObject>();
+    insight[JSON_KEY_SHORT_ID] = true;
+    InsightParser::addInsightFilter(insight);
+    return filter;
+}
+
+// The data cards render, or nullptr if the response isn't an insight
+static std::shared_ptr<const InsightSnapshot> snapshotOf(const InsightParser& parser) {
+    if (!parser.isValid()) {
+        return nullptr;
+    }
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    // A year of days is more points than the chart has pixels
+    snapshot.downsample(InsightSnapshot::MAX_CHART_POINTS);
+    return std::make_shared<const InsightSnapshot>(std::move(snapshot));
+}
 
 
-PostHogClient::PostHogClient(ConfigManager& config, EventQueue& eventQueue) 
+PostHogClient::PostHogClient(ConfigManager& config, EventQueue& eventQueue, SnapshotStore& snapshotStore, uint8_t poolSize)
     : _config(config)
     , _eventQueue(eventQueue)
-    , has_active_request(false)
-    , last_refresh_check(0) {
-    // Configure secure client for HTTPS
-    _secureClient.setInsecure(); // TODO: get proper cert baked into the firmware to verify these connections
-    _http.setReuse(true);
+    , _snapshotStore(snapshotStore)
+    , _refreshesNotModified(0)
+    , _refreshesUnchanged(0)
+    , _asyncQueries(0)
+    , _dashboardId(ConfigManager::NO_DASHBOARD_ID)
+    , _dashboardUsable(true)
+    , _dashboardFetches(0)
+    , _dashboardInsights(0)
+    , _dashboardDocumentPeak(0)
+    , _poolSize(std::min(std::max(poolSize, MIN_POOL_SIZE), MAX_POOL_SIZE))
+    , _inFlight(0)
+    , _batchStart(0)
+    , _batchCount(0) {
+    _queueMutex = xSemaphoreCreateMutex();
+    _scheduler.setUserInterval(_config.getInsightRefreshMinutes() * 60000UL);
+
+    // A job is either waiting, on a worker, or waiting to be collected, and
+    // never more than _poolSize are out at once, so neither queue can fill
+    _jobQueue = xQueueCreate(_poolSize, sizeof(FetchJob*));
+    _resultQueue = xQueueCreate(_poolSize, sizeof(FetchJob*));
+    
+    // Needed to tell a chunked or compressed body apart from a plain one
+    // when streaming, and to make the next refresh conditional
+    static const char* header_keys[] = {"Transfer-Encoding", "Content-Encoding", "ETag", "Last-Modified"};
+
+    for (uint8_t i = 0; i < _poolSize; i++) {
+        std::unique_ptr<Connection> conn(new Connection());
+        conn->owner = this;
+        conn->index = i;
+        conn->http.setReuse(true);
+#ifdef POSTHOG_API_CA_CERT
+        conn->client.setCACert(POSTHOG_API_CA_CERT);
+#endif
+        conn->http.collectHeaders(header_keys, sizeof(header_keys) / sizeof(header_keys[0]));
+        _connections.push_back(std::move(conn));
+    }
     
     // Subscribe to force refresh events
-    _eventQueue.subscribe([this](const Event& event) {
-        if (event.type == EventType::INSIGHT_FORCE_REFRESH) {
-            this->requestInsightData(event.insightId, true);
-        }
+    _forceRefreshSubscription = _eventQueue.subscribe(EventType::INSIGHT_FORCE_REFRESH, [this](const Event& event) {
+        this->requestInsightData(event.insightId, true);
     });
 }
 
+void PostHogClient::begin() {
+    for (auto& conn : _connections) {
+        if (conn->task) {
+            continue;
+        }
+        char name[16];
+        snprintf(name, sizeof(name), "InsightConn%u", conn->index);
+        // TLS handshakes need a deep stack
+        xTaskCreatePinnedToCore(
+            connectionTask,
+            name,
+            8192,
+            conn.get(),
+            1,
+            &conn->task,
+            0
+        );
+    }
+    Serial.printf("[PostHogClient] Started %u insight connections\n", _poolSize);
+}
+
 String PostHogClient::buildBaseUrl() const {
+#ifdef POSTHOG_API_BASE_URL
+    return POSTHOG_API_BASE_URL;
+#else
     return "https://" + _config.getRegion() + ".posthog.com/api/projects/";
+#endif
+}
+
+String PostHogClient::apiHost() const {
+    String url = buildBaseUrl();
+    int start = url.indexOf("://");
+    start = start < 0 ? 0 : start + 3;
+    int end = url.indexOf('/', start);
+    return end < 0 ? url.substring(start) : url.substring(start, end);
 }
 
 void PostHogClient::requestInsightData(const String& insight_id, bool forceRefresh) {
@@ -29,12 +119,22 @@ void PostHogClient::requestInsightData(const String& insight_id, bool forceRefre
     QueuedRequest request = {
         .insight_id = insight_id,
         .retry_count = 0,
-        .force_refresh = forceRefresh
+        .force_refresh = forceRefresh,
+        .is_refresh = false,
+        .not_before = millis()
     };
-    request_queue.push(request);
+
+    // Called from the LVGL and event tasks as well as the insight task
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    // A reconcile asks again for every insight; those still queued or in
+    // flight are merged instead of fetched twice
+    if (!request_queue.push(request)) {
+        Serial.printf("[PostHogClient] %s already requested, merged\n", insight_id.c_str());
+    }
     
-    // Add to our set of known insights for future refreshes
-    requested_insights.insert(insight_id);
+    // Schedule future refreshes of this insight
+    _scheduler.track(insight_id, millis());
+    xSemaphoreGive(_queueMutex);
 }
 
 bool PostHogClient::isReady() const {
@@ -44,100 +144,422 @@ bool PostHogClient::isReady() const {
 }
 
 void PostHogClient::process() {
+    // Always collect, so finished jobs are never stranded when the system
+    // stops being ready mid-flight
+    collectResults();
+
     if (!isReady()) {
         return;
     }
 
-    // Process any queued requests
-    if (!has_active_request) {
-        processQueue();
-    }
+    // Hand queued requests to idle connections
+    dispatchQueue();
 
     // Check for needed refreshes
-    if (!has_active_request) {
+    checkRefreshes();
+}
+
+void PostHogClient::dispatchQueue() {
+    // Requests wait in the queue while WiFi is down instead of failing
+    if (WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+
+    String host = apiHost();
+    int dashboard_id = _config.getDashboardId();
+    while (_inFlight < _poolSize) {
+        xSemaphoreTake(_queueMutex, portMAX_DELAY);
+        // Requests waiting out a backoff or behind an in-flight request for
+        // the same insight are skipped; an open circuit holds the queue
+        // until the host has had time to recover
         unsigned long now = millis();
-        if (now - last_refresh_check >= REFRESH_INTERVAL) {
-            last_refresh_check = now;
-            checkRefreshes();
+        QueuedRequest request;
+        if (!request_queue.hasReady(now) || !_retryPolicy.allowRequest(host, now)) {
+            xSemaphoreGive(_queueMutex);
+            return;
+        }
+        FetchJob* job = new FetchJob();
+        bool batch = takeDashboardBatch(dashboard_id, now, *job);
+        if (!batch) {
+            request_queue.takeNext(now, request);
+            job->request = request;
+
+            // Only background refreshes are conditional; a card asking for
+            // data must get it even if nothing changed since the last fetch
+            if (request.is_refresh && !request.force_refresh) {
+                auto it = _validators.find(request.insight_id);
+                if (it != _validators.end()) {
+                    job->validators = it->second;
+                }
+            }
+            auto peak = _documentPeaks.find(request.insight_id);
+            if (peak != _documentPeaks.end()) {
+                job->document_hint = peak->second;
+            }
+            auto filter_type = _filterTypes.find(request.insight_id);
+            if (filter_type != _filterTypes.end()) {
+                job->filter_type = filter_type->second;
+            }
+        } else {
+            job->document_hint = _dashboardDocumentPeak;
+        }
+        xSemaphoreGive(_queueMutex);
+
+        // URLs read the config, so build them here rather than on the workers
+        if (batch) {
+            job->dashboard_url = buildDashboardUrl(dashboard_id);
+        } else {
+            job->cached_url = buildInsightUrl(request.insight_id, "force_cache");
+            job->async_url = buildInsightUrl(request.insight_id, "async");
+            if (request.query_id.length() > 0) {
+                job->query_url = buildQueryUrl(request.query_id);
+            }
         }
+        job->queued_ms = millis();
+
+        if (_inFlight == 0 && _batchStart == 0) {
+            _batchStart = job->queued_ms;
+            _batchCount = 0;
+        }
+
+        xQueueSend(_jobQueue, &job, portMAX_DELAY);
+        _inFlight++;
     }
 }
 
-void PostHogClient::onSystemStateChange(SystemState state) {
-    if (!SystemController::isSystemFullyReady() == false) {
-        // Clear any active request when system becomes not ready
-        has_active_request = false;
+bool PostHogClient::takeDashboardBatch(int dashboard_id, unsigned long now, FetchJob& job) {
+    if (dashboard_id != _dashboardId) {
+        // What was learned about another dashboard doesn't apply
+        _dashboardId = dashboard_id;
+        _dashboardUsable = true;
+        _dashboardMembers.clear();
     }
+    if (_dashboardId == ConfigManager::NO_DASHBOARD_ID || !_dashboardUsable) {
+        return false;
+    }
+
+    // Insights not seen on the dashboard yet are tried; those it turned
+    // out not to have are fetched on their own
+    std::vector<String> ids;
+    for (const QueuedRequest& request : request_queue.ready(now)) {
+        auto member = _dashboardMembers.find(request.insight_id);
+        if (request.solo || request.force_refresh || request.query_id.length() > 0 ||
+            (member != _dashboardMembers.end() && !member->second)) {
+            continue;
+        }
+        ids.push_back(request.insight_id);
+    }
+    // One insight is cheaper to fetch on its own than the whole dashboard
+    if (ids.size() < MIN_DASHBOARD_BATCH) {
+        return false;
+    }
+
+    for (const String& id : ids) {
+        QueuedRequest request;
+        request_queue.take(id, now, request);
+        job.batch.push_back(request);
+    }
+    return true;
 }
 
-void PostHogClient::processQueue() {
-    if (request_queue.empty()) {
-        return;
+void PostHogClient::recordOutcome(const FetchJob& job, const String& host) {
+    // Any answer from the server, even an error the request can't
+    // recover from, shows the host is up
+    if (job.offline) {
+        _retryPolicy.recordAbandoned(host);
+    } else if (job.success || job.query_failed || job.document_full || !RetryPolicy::isRetryable(job.http_code)) {
+        _retryPolicy.recordSuccess(host);
+    } else {
+        _retryPolicy.recordFailure(host, millis());
+    }
+}
+
+bool PostHogClient::acceptData(const QueuedRequest& request, const InsightValidators& response) {
+    bool same = false;
+    // Validators of an insight whose card went away are not kept
+    if (_scheduler.isTracked(request.insight_id)) {
+        InsightValidators& known = _validators[request.insight_id];
+        if (known.content_hash != 0) {
+            same = known.content_hash == response.content_hash;
+            _scheduler.recordChange(request.insight_id, !same);
+        }
+        known = response;
     }
 
-    QueuedRequest request = request_queue.front();
-    String response;
+    if (same && request.is_refresh) {
+        // Same data as the cards already show: don't publish, so they
+        // aren't rebuilt for nothing
+        _refreshesUnchanged++;
+        Serial.printf("[PostHogClient] %s unchanged, skipped (%u not modified, %u unchanged so far)\n",
+                      request.insight_id.c_str(), _refreshesNotModified, _refreshesUnchanged);
+        return false;
+    }
+    return true;
+}
+
+void PostHogClient::collectResults() {
+    String host = apiHost();
+    FetchJob* job = nullptr;
+    while (xQueueReceive(_resultQueue, &job, 0) == pdTRUE) {
+        _inFlight--;
+        _batchCount++;
+        if (!job->batch.empty()) {
+            collectDashboard(*job, host);
+            delete job;
+            continue;
+        }
+        QueuedRequest request = job->request;
+
+        Serial.printf("[PostHogClient] %s on conn %u: %s, wait %lu ms, request %lu ms, parse %lu ms, %u request(s), %zu bytes (%zu inflated), document %zu of %zu bytes\n",
+                      request.insight_id.c_str(), job->connection, job->success ? "ok" : "failed",
+                      job->wait_ms, job->request_ms, job->parse_ms, job->http_requests, job->body_bytes,
+                      job->inflated_bytes ? job->inflated_bytes : job->body_bytes,
+                      job->document_used, job->document_capacity);
     
-    if (fetchInsight(request.insight_id, response, request.force_refresh)) {
-        // Publish to the event system
-        publishInsightDataEvent(request.insight_id, response);
-        request_queue.pop();
-    } else {
-        // Handle failure - retry if under max attempts
-        if (request.retry_count < MAX_RETRIES) {
-            // Update retry count and push back to end of queue
+        bool publish = false;
+        bool retry = false;
+
+        xSemaphoreTake(_queueMutex, portMAX_DELAY);
+        // Picks up requests merged in while this one was in flight
+        request_queue.finish(request.insight_id, request);
+        recordOutcome(*job, host);
+
+        // Size the next parse of this insight from this one
+        if (job->document_full) {
+            _documentPeaks[request.insight_id] = job->document_capacity * 2;
+        } else if (job->document_used > 0 && _scheduler.isTracked(request.insight_id)) {
+            _documentPeaks[request.insight_id] = job->document_used;
+            _filterTypes[request.insight_id] = job->filter_type;
+        }
+
+        if (job->success && job->pending_query_id.length() > 0) {
+            if (request.query_id.length() == 0) {
+                _asyncQueries++;
+            }
+            if (request.poll_count < MAX_POLLS) {
+                // Poll from the queue, so the connection serves other
+                // insights while PostHog calculates this one
+                request.query_id = job->pending_query_id;
+                request.poll_count++;
+                unsigned long wait = std::min(POLL_INTERVAL << std::min<uint8_t>(request.poll_count - 1, 4),
+                                              MAX_POLL_INTERVAL);
+                Serial.printf("[PostHogClient] %s still calculating, polling again in %lu ms (%u/%u)\n",
+                              request.insight_id.c_str(), wait, request.poll_count, MAX_POLLS);
+                request.not_before = millis() + wait;
+                request_queue.push(request);
+                retry = true;
+            } else {
+                Serial.printf("[PostHogClient] Gave up waiting for %s to calculate\n", request.insight_id.c_str());
+            }
+        } else if (job->success && job->not_modified) {
+            _refreshesNotModified++;
+            _scheduler.recordChange(request.insight_id, false);
+            Serial.printf("[PostHogClient] %s not modified, skipped (%u not modified, %u unchanged so far)\n",
+                          request.insight_id.c_str(), _refreshesNotModified, _refreshesUnchanged);
+            if (!request.is_refresh) {
+                // A card asked for the insight while this refresh was in
+                // flight; it needs the data itself
+                request_queue.push({request.insight_id, 0, request.force_refresh, false, millis()});
+            }
+        } else if (job->success) {
+            publish = acceptData(request, job->response_validators);
+        } else if (job->query_failed) {
+            Serial.printf("Calculation of insight %s failed, not retrying\n", request.insight_id.c_str());
+        } else if (job->offline) {
+            // Nothing was sent, so no retry is used up; it goes out again
+            // once WiFi is back
+            request.not_before = millis();
+            request_queue.push(request);
+            retry = true;
+        } else if (!RetryPolicy::isRetryable(job->http_code)) {
+            Serial.printf("Request for insight %s failed with %d, not retrying\n",
+                          request.insight_id.c_str(), job->http_code);
+        } else if (request.retry_count < MAX_RETRIES) {
+            // Requeue the request, held back until its backoff has passed
             request.retry_count++;
-            Serial.printf("Request for insight %s failed, retrying (%d/%d)...\n", 
-                          request.insight_id.c_str(), request.retry_count, MAX_RETRIES);
-            
-            // Remove from front and add to back with incremented retry count
-            request_queue.pop();
+            unsigned long wait = _retryPolicy.backoff(request.retry_count);
+            Serial.printf("Request for insight %s failed, retrying (%d/%d) in %lu ms...\n", 
+                          request.insight_id.c_str(), request.retry_count, MAX_RETRIES, wait);
+            request.not_before = millis() + wait;
             request_queue.push(request);
-            
-            // Add delay before next attempt
-            delay(RETRY_DELAY);
+            retry = true;
         } else {
             // Max retries reached, drop request
             Serial.printf("Max retries reached for insight %s, dropping request\n", 
                          request.insight_id.c_str());
-            request_queue.pop();
+        }
+
+        // The next refresh is timed from when this fetch ended
+        if (!retry) {
+            _scheduler.reschedule(request.insight_id, millis());
+        }
+        xSemaphoreGive(_queueMutex);
+
+        if (publish) {
+            // Publish to the event system
+            publishInsightDataEvent(request.insight_id, std::move(job->snapshot));
+        }
+        delete job;
+    }
+
+    // Report how long it took to drain everything that was queued, e.g. to
+    // fill every card after boot
+    if (_batchStart != 0 && _inFlight == 0) {
+        xSemaphoreTake(_queueMutex, portMAX_DELAY);
+        bool idle = request_queue.empty();
+        xSemaphoreGive(_queueMutex);
+        if (idle) {
+            Serial.printf("[PostHogClient] Fetched %u insight(s) in %lu ms over %u connections\n",
+                          _batchCount, millis() - _batchStart, _poolSize);
+            _batchStart = 0;
         }
     }
 }
 
-void PostHogClient::checkRefreshes() {
-    if (requested_insights.empty()) {
-        return;
+void PostHogClient::collectDashboard(FetchJob& job, const String& host) {
+    Serial.printf("[PostHogClient] Dashboard %d on conn %u: %s, %zu request(s), %zu tile(s), wait %lu ms, request %lu ms, parse %lu ms, %zu bytes (%zu inflated), document %zu of %zu bytes\n",
+                  _dashboardId, job.connection, job.success ? "ok" : "failed", job.batch.size(), job.tiles.size(),
+                  job.wait_ms, job.request_ms, job.parse_ms, job.body_bytes,
+                  job.inflated_bytes ? job.inflated_bytes : job.body_bytes,
+                  job.document_used, job.document_capacity);
+
+    std::vector<std::pair<String, std::shared_ptr<const InsightSnapshot>>> publish;
+    unsigned long now = millis();
+
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    recordOutcome(job, host);
+    if (job.success) {
+        _dashboardFetches++;
+        _dashboardDocumentPeak = job.document_used;
+    } else if (job.document_full && job.document_capacity < ParserArena::MAX_SLAB) {
+        // Requeued below; the next dashboard fetch gets a larger document
+        _dashboardDocumentPeak = job.document_capacity * 2;
+    } else if (!job.offline && !RetryPolicy::isRetryable(job.http_code)) {
+        // Gone, forbidden or too large to parse: retrying won't help, so
+        // insights are fetched one by one until the dashboard ID changes
+        Serial.printf("[PostHogClient] Dashboard %d failed with %d, fetching insights on their own\n",
+                      _dashboardId, job.http_code);
+        _dashboardUsable = false;
     }
-    
-    // Pick one insight to refresh
+
+    for (QueuedRequest request : job.batch) {
+        // Picks up requests merged in while this one was in flight
+        request_queue.finish(request.insight_id, request);
+
+        if (job.success) {
+            auto tile = job.tiles.find(request.insight_id);
+            _dashboardMembers[request.insight_id] = tile != job.tiles.end();
+            if (tile == job.tiles.end() || !tile->second.snapshot || tile->second.empty_result) {
+                // Not on the dashboard, or not calculated yet: the single
+                // request path can fetch it and start its calculation
+                request.solo = tile != job.tiles.end();
+                request.not_before = now;
+                request_queue.push(request);
+                continue;
+            }
+            InsightValidators validators;
+            validators.content_hash = tile->second.content_hash;
+            _documentPeaks[request.insight_id] = tile->second.document_used;
+            _filterTypes[request.insight_id] = tile->second.filter_type;
+            if (acceptData(request, validators)) {
+                publish.emplace_back(request.insight_id, tile->second.snapshot);
+            }
+            job.tiles.erase(tile);
+            _dashboardInsights++;
+        } else if (job.offline || job.document_full || !RetryPolicy::isRetryable(job.http_code)) {
+            // Nothing was sent, the document was too small, or the dashboard
+            // is unusable; no retry is used up in any case
+            request.not_before = now;
+            request_queue.push(request);
+            continue;
+        } else if (request.retry_count < MAX_RETRIES) {
+            request.retry_count++;
+            request.not_before = now + _retryPolicy.backoff(request.retry_count);
+            request_queue.push(request);
+            continue;
+        } else {
+            Serial.printf("Max retries reached for insight %s, dropping request\n",
+                          request.insight_id.c_str());
+        }
+        _scheduler.reschedule(request.insight_id, now);
+    }
+
+    // The rest of the dashboard came along for free: cards showing those
+    // insights get the new data, and their next refresh is put off
+    for (const auto& [id, tile] : job.tiles) {
+        if (!_scheduler.isTracked(id) || !tile.snapshot || tile.empty_result) {
+            continue;
+        }
+        _dashboardMembers[id] = true;
+        _documentPeaks[id] = tile.document_used;
+        _filterTypes[id] = tile.filter_type;
+        InsightValidators validators;
+        validators.content_hash = tile.content_hash;
+        QueuedRequest refresh = {id, 0, false, true, now};
+        if (acceptData(refresh, validators)) {
+            publish.emplace_back(id, tile.snapshot);
+        }
+        _scheduler.reschedule(id, now);
+        _dashboardInsights++;
+    }
+    xSemaphoreGive(_queueMutex);
+
+    for (auto& [id, snapshot] : publish) {
+        publishInsightDataEvent(id, std::move(snapshot));
+    }
+}
+
+void PostHogClient::checkRefreshes() {
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    // Queue each due insight like any other request so it goes out on the
+    // next free connection
     String refresh_id;
-    
-    // This cycles through insights in a round-robin fashion since sets are ordered
-    static auto it = requested_insights.begin();
-    if (it == requested_insights.end()) {
-        it = requested_insights.begin();
+    unsigned long now = millis();
+    while (_scheduler.takeDue(now, refresh_id)) {
+        Serial.printf("[PostHogClient] Refresh due for %s (every %lu s)\n",
+                      refresh_id.c_str(), _scheduler.intervalFor(refresh_id) / 1000);
+        request_queue.push({refresh_id, 0, false, true, now});
     }
-    
-    if (it != requested_insights.end()) {
-        refresh_id = *it;
-        ++it;
-    } else {
-        // Reset if we're at the end
-        it = requested_insights.begin();
-        if (it != requested_insights.end()) {
-            refresh_id = *it;
+    xSemaphoreGive(_queueMutex);
+}
+
+void PostHogClient::setVisibleInsight(const String& insight_id) {
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    _scheduler.setVisible(insight_id, millis());
+    xSemaphoreGive(_queueMutex);
+}
+
+void PostHogClient::retainInsights(const std::vector<String>& insight_ids) {
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    _scheduler.retain(insight_ids);
+    for (auto it = _validators.begin(); it != _validators.end();) {
+        if (_scheduler.isTracked(it->first)) {
             ++it;
+        } else {
+            it = _validators.erase(it);
         }
     }
-    
-    if (!refresh_id.isEmpty()) {
-        String response;
-        if (fetchInsight(refresh_id, response)) {
-            // Publish to the event system
-            publishInsightDataEvent(refresh_id, response);
+    for (auto it = _documentPeaks.begin(); it != _documentPeaks.end();) {
+        if (_scheduler.isTracked(it->first)) {
+            ++it;
+        } else {
+            it = _documentPeaks.erase(it);
         }
     }
+    for (auto it = _filterTypes.begin(); it != _filterTypes.end();) {
+        if (_scheduler.isTracked(it->first)) {
+            ++it;
+        } else {
+            it = _filterTypes.erase(it);
+        }
+    }
+    xSemaphoreGive(_queueMutex);
+}
+
+void PostHogClient::setRefreshIntervalMinutes(uint16_t minutes) {
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    _scheduler.setUserInterval(minutes * 60000UL);
+    xSemaphoreGive(_queueMutex);
 }
 
 String PostHogClient::buildInsightUrl(const String& insight_id, const char* refresh_mode) const {
@@ -152,145 +574,350 @@ String PostHogClient::buildInsightUrl(const String& insight_id, const char* refr
     return url;
 }
 
-bool PostHogClient::fetchInsight(const String& insight_id, String& response, bool forceRefresh) {
-    if (!isReady() || WiFi.status() != WL_CONNECTED) {
+String PostHogClient::buildDashboardUrl(int dashboard_id) const {
+    String url = buildBaseUrl();
+    url += String(_config.getTeamId());
+    url += "/dashboards/";
+    url += String(dashboard_id);
+    url += "/?refresh=force_cache&personal_api_key=";
+    url += _config.getApiKey();
+    return url;
+}
+
+String PostHogClient::buildQueryUrl(const String& query_id) const {
+    String url = buildBaseUrl();
+    url += String(_config.getTeamId());
+    url += "/query/";
+    url += query_id;
+    url += "/?personal_api_key=";
+    url += _config.getApiKey();
+    return url;
+}
+
+void PostHogClient::connectionTask(void* parameter) {
+    Connection* conn = static_cast<Connection*>(parameter);
+    PostHogClient* self = conn->owner;
+    FetchJob* job = nullptr;
+
+    while (true) {
+        // Whichever connection is idle takes the next job
+        if (xQueueReceive(self->_jobQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        job->connection = conn->index;
+        job->wait_ms = millis() - job->queued_ms;
+        job->success = self->fetchInsight(*conn, *job);
+        if (job->parser) {
+            // Only the extracted data goes back; the document returns to
+            // the arena here, before the insight task ever sees the job
+            job->filter_type = job->parser->filterType();
+            job->snapshot = snapshotOf(*job->parser);
+            job->parser.reset();
+        }
+        xQueueSend(self->_resultQueue, &job, portMAX_DELAY);
+    }
+}
+
+bool PostHogClient::fetchInsight(Connection& conn, FetchJob& job) {
+    if (WiFi.status() != WL_CONNECTED) {
+        job.offline = true;
         return false;
     }
 
-    unsigned long start_time = millis();
-    has_active_request = true;
-    
+    if (!job.batch.empty()) {
+        return fetchDashboard(conn, job);
+    }
+
+    // A calculation started by an earlier request: check on it instead
+    if (job.request.query_id.length() > 0) {
+        return pollQuery(conn, job);
+    }
+
     bool success = false;
-    bool needsRefresh = false;
-    
-    // If force refresh is requested, go straight to blocking mode
-    if (forceRefresh) {
-        String url = buildInsightUrl(insight_id, "blocking");
-        Serial.printf("Force refreshing insight %s\n", insight_id.c_str());
-        
-        _http.begin(_secureClient, url);
-        int httpCode = _http.GET();
-        
-        if (httpCode == HTTP_CODE_OK) {
-            unsigned long network_time = millis() - start_time;
-            Serial.printf("Force refresh network time for %s: %lu ms\n", insight_id.c_str(), network_time);
-            
-            // Get content length for allocation
-            size_t contentLength = _http.getSize();
-            
-            // Pre-allocate in PSRAM if content is large
-            if (contentLength > 8192) { // 8KB threshold
-                response = String();
-                response.reserve(contentLength);
-                Serial.printf("Pre-allocated %u bytes in PSRAM for force refresh response\n", contentLength);
-            }
-            
-            response = _http.getString();
-            success = true;
-        } else {
-            Serial.printf("HTTP GET (force refresh) failed for %s, error: %d\n", insight_id.c_str(), httpCode);
+    // If force refresh is requested, go straight to async mode
+    if (job.request.force_refresh) {
+        Serial.printf("Force refreshing insight %s\n", job.request.insight_id.c_str());
+        success = streamInsight(conn, job.async_url, job, false);
+    } else {
+        // Normal flow: First, try to get cached data
+        success = streamInsight(conn, job.cached_url, job, true);
+        if (success && job.not_modified) {
+            return true;
+        }
+
+        // A cached insight that was never calculated has a null or empty
+        // result; make a second request that starts the calculation
+        if (success && job.parser->hasEmptyResult()) {
+            Serial.printf("No cached result for %s, requesting async refresh\n", job.request.insight_id.c_str());
+            job.parser.reset();
+            success = streamInsight(conn, job.async_url, job, false);
         }
-        
-        _http.end();
-        has_active_request = false;
-        return success;
     }
     
-    // Normal flow: First, try to get cached data
-    String url = buildInsightUrl(insight_id, "force_cache");
-    
-    _http.begin(_secureClient, url);
-    int httpCode = _http.GET();
+    // PostHog answers at once when it has to calculate; the result is
+    // polled for later, so this connection is free for the next insight
+    char query_id[64];
+    if (success && job.parser->getPendingQuery(query_id, sizeof(query_id))) {
+        job.pending_query_id = query_id;
+        job.parser.reset();
+    }
+
+    return success;
+}
+
+bool PostHogClient::pollQuery(Connection& conn, FetchJob& job) {
+    unsigned long start_time = millis();
+    job.http_requests++;
+
+    conn.http.begin(conn.client, job.query_url);
+    conn.http.addHeader("Accept-Encoding", "gzip");
+    int httpCode = conn.http.GET();
+    job.request_ms += millis() - start_time;
+    job.http_code = httpCode;
+
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Status poll failed for %s on conn %u, error: %d\n",
+                      job.request.insight_id.c_str(), conn.index, httpCode);
+        conn.http.end();
+        return false;
+    }
+
+    // Only the status is kept; the results come with the insight
+    static StaticJsonDocument<64> filter = createQueryStatusFilter();
+    StaticJsonDocument<128> status;
+    DeserializationError error;
+    bool complete = readBody(conn, job, [&](Stream& body) {
+        error = deserializeJson(status, body, DeserializationOption::Filter(filter));
+    });
+
+    if (!complete || error) {
+        Serial.printf("Status of %s was cut short or corrupt\n", job.request.insight_id.c_str());
+        job.http_code = HTTPC_ERROR_CONNECTION_LOST;
+        return false;
+    }
+
+    JsonObjectConst query_status = status["query_status"];
+    if (query_status["error"].as<bool>()) {
+        job.query_failed = true;
+        return false;
+    }
+    if (!query_status["complete"].as<bool>()) {
+        job.pending_query_id = job.request.query_id;
+        return true;
+    }
     
-    if (httpCode == HTTP_CODE_OK) {
-        unsigned long network_time = millis() - start_time;
-        Serial.printf("Network fetch time for %s: %lu ms\n", insight_id.c_str(), network_time);
-        
-        start_time = millis();
-        
-        // Get content length for allocation
-        size_t contentLength = _http.getSize();
-        
-        // Pre-allocate in PSRAM if content is large
-        if (contentLength > 8192) { // 8KB threshold
-            // Force allocation in PSRAM for large responses
-            response = String();
-            response.reserve(contentLength);
-            Serial.printf("Pre-allocated %u bytes in PSRAM for large response\n", contentLength);
-        }
-        
-        response = _http.getString();
-        unsigned long string_time = millis() - start_time;
-        Serial.printf("Response processing time: %lu ms (size: %u bytes)\n", string_time, response.length());
-        
-        // Quick check if we need to refresh (look for null result)
-        if (response.indexOf("\"result\":null") >= 0 || 
-            response.indexOf("\"result\":[]") >= 0) {
-            needsRefresh = true;
-        } else {
-            success = true;
+    // The result is in PostHog's cache now
+    return streamInsight(conn, job.cached_url, job, true);
+}
+
+bool PostHogClient::fetchDashboard(Connection& conn, FetchJob& job) {
+    unsigned long start_time = millis();
+    job.http_requests++;
+
+    conn.http.begin(conn.client, job.dashboard_url);
+    conn.http.addHeader("Accept-Encoding", "gzip");
+    int httpCode = conn.http.GET();
+    job.request_ms += millis() - start_time;
+    job.http_code = httpCode;
+
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("HTTP GET failed for dashboard on conn %u, error: %d\n", conn.index, httpCode);
+        conn.http.end();
+        return false;
+    }
+
+    // Every tile is filtered down to the fields a single insight response
+    // keeps, so the whole dashboard fits one document
+    static StaticJsonDocument<512> filter = createDashboardFilter();
+    ArenaJsonDocument dashboard(InsightParser::estimateCapacity(conn.http.getSize(),
+                                                                GzipStream::isGzip(conn.http.header("Content-Encoding")),
+                                                                job.document_hint, DASHBOARD_DOC_SIZE));
+    DeserializationError error;
+    bool complete = readBody(conn, job, [&](Stream& body) {
+        error = deserializeJson(dashboard, body, DeserializationOption::Filter(filter));
+    });
+
+    if (!complete) {
+        Serial.printf("Dashboard body was cut short or corrupt\n");
+        job.http_code = HTTPC_ERROR_CONNECTION_LOST;
+        return false;
+    }
+    job.document_used = dashboard.memoryUsage();
+    job.document_capacity = dashboard.capacity();
+    if (error == DeserializationError::NoMemory) {
+        Serial.printf("Dashboard outgrew its %zu byte document\n", job.document_capacity);
+        job.document_full = true;
+        job.http_code = HTTPC_ERROR_TOO_LESS_RAM;
+        return false;
+    }
+    if (error) {
+        // Arrived whole, so fetching it again won't parse any better
+        Serial.printf("Dashboard didn't parse: %s\n", error.c_str());
+        return false;
+    }
+
+    // Each insight is copied into a document of its own, sized to fit, so
+    // it reads like a single insight response; only its snapshot is kept
+    unsigned long split_start = millis();
+    for (JsonObjectConst tile : dashboard[JSON_KEY_TILES].as<JsonArrayConst>()) {
+        JsonObjectConst insight = tile[JSON_KEY_INSIGHT];
+        const char* short_id = insight[JSON_KEY_SHORT_ID];
+        if (short_id) {
+            // Text tiles have no insight
+            InsightParser parser(insight);
+            DashboardTile& parsed = job.tiles[short_id];
+            parsed.snapshot = snapshotOf(parser);
+            parsed.empty_result = parser.hasEmptyResult();
+            parsed.content_hash = parser.contentHash();
+            parsed.document_used = parser.memoryUsed();
+            parsed.filter_type = parser.filterType();
         }
+    }
+    job.parse_ms += millis() - split_start;
+    return true;
+}
+
+bool PostHogClient::readBody(Connection& conn, FetchJob& job, const std::function<void(Stream&)>& parse) {
+    String transfer_encoding = conn.http.header("Transfer-Encoding");
+    transfer_encoding.toLowerCase();
+    HttpBodyStream body(*conn.http.getStreamPtr(), transfer_encoding.indexOf("chunked") >= 0, conn.http.getSize());
+
+    unsigned long start_time = millis();
+    bool inflate_failed = false;
+    if (GzipStream::isGzip(conn.http.header("Content-Encoding"))) {
+        GzipStream inflated(body);
+        parse(inflated);
+        inflate_failed = inflated.failed();
+        job.inflated_bytes += inflated.bytesOut();
     } else {
-        // Handle HTTP errors
-        Serial.print("HTTP GET failed, error: ");
-        Serial.println(httpCode);
+        parse(body);
     }
-    
-    _http.end();
-    
-    // If we need to refresh, make a second request with blocking
-    if (needsRefresh) {
-        url = buildInsightUrl(insight_id, "blocking");
-        
-        unsigned long refresh_start = millis();
-        _http.begin(_secureClient, url);
-        httpCode = _http.GET();
-        
-        if (httpCode == HTTP_CODE_OK) {
-            unsigned long refresh_network = millis() - refresh_start;
-            Serial.printf("Refresh network time: %lu ms\n", refresh_network);
-            
-            refresh_start = millis();
-            
-            // Get content length for allocation
-            size_t contentLength = _http.getSize();
-            
-            // Pre-allocate in PSRAM if content is large
-            if (contentLength > 8192) { // 8KB threshold
-                // Force allocation in PSRAM for large responses
-                response = String();
-                response.reserve(contentLength);
-                Serial.printf("Pre-allocated %u bytes in PSRAM for refresh response\n", contentLength);
-            }
-            
-            response = _http.getString();
-            unsigned long refresh_string = millis() - refresh_start;
-            Serial.printf("Refresh string time: %lu ms (size: %u bytes)\n", refresh_string, response.length());
-            
-            success = true;
-        } else {
-            // Handle HTTP errors
-            Serial.print("HTTP GET (blocking) failed, error: ");
-            Serial.println(httpCode);
+    body.finish();
+    job.parse_ms += millis() - start_time;
+    job.body_bytes += body.bytesRead();
+
+    // Keeps the socket open for the connection's next request
+    conn.http.end();
+    return !body.truncated() && !inflate_failed;
+}
+
+bool PostHogClient::streamInsight(Connection& conn, const String& url, FetchJob& job, bool conditional) {
+    unsigned long start_time = millis();
+    job.http_requests++;
+
+    conn.http.begin(conn.client, url);
+    conn.http.addHeader("Accept-Encoding", "gzip");
+    if (conditional) {
+        if (job.validators.etag.length() > 0) {
+            conn.http.addHeader("If-None-Match", job.validators.etag);
+        }
+        if (job.validators.last_modified.length() > 0) {
+            conn.http.addHeader("If-Modified-Since", job.validators.last_modified);
         }
-        
-        _http.end();
+    }
+    int httpCode = conn.http.GET();
+    job.request_ms += millis() - start_time;
+    job.http_code = httpCode;
+
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+        // Nothing to download or parse
+        conn.http.end();
+        job.not_modified = true;
+        return true;
     }
     
-    has_active_request = false;
-    return success;
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("HTTP GET failed for %s on conn %u, error: %d\n",
+                      job.request.insight_id.c_str(), conn.index, httpCode);
+        conn.http.end();
+        return false;
+    }
+    
+    job.response_validators.etag = conn.http.header("ETag");
+    job.response_validators.last_modified = conn.http.header("Last-Modified");
+
+    // Parse straight off the socket so the raw payload is never buffered,
+    // into a document sized from the body and the last parse
+    size_t capacity = InsightParser::estimateCapacity(conn.http.getSize(),
+                                                      GzipStream::isGzip(conn.http.header("Content-Encoding")),
+                                                      job.document_hint);
+    bool complete = readBody(conn, job, [&job, capacity](Stream& body) {
+        job.parser = std::make_shared<InsightParser>(body, capacity, job.filter_type);
+    });
+    
+    // A stalled or cut-off body is a network failure worth retrying; a body
+    // that arrived whole but isn't an insight still goes to the card so it
+    // can show the error
+    if (!complete) {
+        Serial.printf("Response body for %s was cut short or corrupt\n", job.request.insight_id.c_str());
+        job.parser.reset();
+        job.http_code = HTTPC_ERROR_CONNECTION_LOST;
+        return false;
+    }
+
+    job.document_used = job.parser->memoryUsed();
+    job.document_capacity = job.parser->memoryCapacity();
+    if (job.parser->outOfMemory() && job.document_capacity < ParserArena::MAX_SLAB) {
+        // Retried like a network error, with twice the document
+        Serial.printf("Insight %s outgrew its %zu byte document\n", job.request.insight_id.c_str(), job.document_capacity);
+        job.parser.reset();
+        job.document_full = true;
+        job.http_code = HTTPC_ERROR_TOO_LESS_RAM;
+        return false;
+    }
+
+    if (job.parser->filterMismatch()) {
+        // The insight changed type or shape since its last parse, so the filter
+        // chosen from that parse dropped fields it needs; fetch it again keeping all
+        Serial.printf("Insight %s needs fields its filter dropped, parsing again with the general filter\n", job.request.insight_id.c_str());
+        job.parser.reset();
+        job.filter_type = InsightParser::InsightType::INSIGHT_NOT_SUPPORTED;
+        return streamInsight(conn, url, job, false);
+    }
+
+    // Fallback validator for servers that send no ETag or Last-Modified
+    job.response_validators.content_hash = job.parser->contentHash();
+    return true;
 }
 
-void PostHogClient::publishInsightDataEvent(const String& insight_id, const String& response) {
-    // Check if response is empty or invalid
-    if (response.length() == 0) {
-        Serial.printf("Empty response for insight %s\n", insight_id.c_str());
-        return;
+void PostHogClient::writeStats(JsonObject out) const {
+    out["connections"] = _poolSize;
+    out["in_flight"] = _inFlight;
+    out["refreshes_not_modified"] = _refreshesNotModified;
+    out["refreshes_unchanged"] = _refreshesUnchanged;
+
+    xSemaphoreTake(_queueMutex, portMAX_DELAY);
+    out["scheduled_insights"] = _scheduler.size();
+    out["queued_requests"] = request_queue.size();
+    out["waiting_retries"] = request_queue.waiting(millis());
+    out["polling_queries"] = request_queue.polling();
+    out["async_queries"] = _asyncQueries;
+    out["dashboard_fetches"] = _dashboardFetches;
+    out["dashboard_insights"] = _dashboardInsights;
+    JsonObject peaks = out.createNestedObject("document_peaks");
+    for (const auto& [id, bytes] : _documentPeaks) {
+        peaks[id] = bytes;
+    }
+    out["circuit_open"] = _retryPolicy.isOpen(apiHost());
+    xSemaphoreGive(_queueMutex);
+}
+
+void PostHogClient::publishInsightDataEvent(const String& insight_id, std::shared_ptr<const InsightSnapshot> snapshot) {
+    if (!snapshot) {
+        // Still published, so the card shows the error
+        Serial.printf("Response for insight %s isn't a renderable insight\n", insight_id.c_str());
     }
     
-    // Publish the event with the raw JSON response
-    _eventQueue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, insight_id, response);
+    // Cards render from the snapshot; nothing is copied or re-parsed
+    std::shared_ptr<const InsightSnapshot> stored = snapshot;
+    _eventQueue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, insight_id, std::move(snapshot));
     
     // Log for debugging
-    Serial.printf("Published raw JSON data for %s\n", insight_id.c_str());
-} 
\ No newline at end of file
+    Serial.printf("Published parsed data for %s\n", insight_id.c_str());
+    
+    // Saved once the card has its data: a flash write, or a bank erase when
+    // the store compacts, holds up this task instead of the card
+    if (stored) {
+        _snapshotStore.save(insight_id.c_str(), *stored, millis());
+    }
+}
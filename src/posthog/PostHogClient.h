@@ -3,26 +3,60 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <queue>
+#include "../net/SecureClient.h"
 #include <vector>
-#include <set>
+#include <map>
 #include <memory>
+#include <functional>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "../ConfigManager.h"
 #include "SystemController.h"
 #include "EventQueue.h"
 #include "parsers/InsightParser.h"
+#include "InsightSnapshot.h"
+#include "SnapshotStore.h"
+#include "../net/HttpBodyStream.h"
+#include "../net/GzipStream.h"
+#include "RefreshScheduler.h"
+#include "RetryPolicy.h"
+#include "InsightRequestQueue.h"
+
+// Number of persistent TLS connections used to fetch insights in parallel.
+// Each one costs a worker task and an mbedTLS session, so keep it small.
+#ifndef POSTHOG_CONNECTION_POOL_SIZE
+#define POSTHOG_CONNECTION_POOL_SIZE 3
+#endif
+
+// Define POSTHOG_API_BASE_URL to point the client at a local HTTPS stand-in
+// server instead of {region}.posthog.com, e.g.
+// -DPOSTHOG_API_BASE_URL="\"https://192.168.1.20:8443/api/projects/\""
+// Its certificate is verified too: define POSTHOG_API_CA_CERT as the PEM of
+// the CA that signed it, or the built-in CA bundle will reject it.
 
 /**
  * @class PostHogClient
  * @brief Client for fetching PostHog insight data
  * 
  * Features:
- * - Queued insight requests with retry logic
- * - Automatic refresh of insights
+ * - Queued insight requests with non-blocking retries and backoff
+ * - Async recalculation: an insight PostHog has to compute is polled from
+ *   the queue instead of holding a connection until it's ready
+ * - Dashboard batch fetch: insights on the configured dashboard are fetched
+ *   together in one request and fanned out to their cards
+ * - Circuit breaker that stops requests to a failing host
+ * - Per-insight refresh deadlines driven by visibility and change frequency
+ * - Pool of persistent TLS connections fetching insights concurrently
  * - Thread-safe operation with event queue
  * - Configurable retry and refresh intervals
  * - Support for multiple insight types
+ *
+ * The insight task owns the request queue: process() hands queued requests
+ * to idle connections and collects their results. Each connection has its
+ * own worker task, SecureClient and HTTPClient, and keeps its socket
+ * alive between requests so only the first fetch pays for a TLS handshake,
+ * and a reconnect resumes the TLS session instead of doing a full one.
  */
 class PostHogClient {
 public:
@@ -31,12 +65,22 @@ public:
      * 
      * @param config Reference to configuration manager
      * @param eventQueue Reference to event system
+     * @param snapshotStore Flash store that keeps the last data of each insight
+     * @param poolSize Number of concurrent connections, clamped to 2-4
      */
-    explicit PostHogClient(ConfigManager& config, EventQueue& eventQueue);
+    PostHogClient(ConfigManager& config, EventQueue& eventQueue, SnapshotStore& snapshotStore,
+                  uint8_t poolSize = POSTHOG_CONNECTION_POOL_SIZE);
     
     // Delete copy constructor and assignment operator
     PostHogClient(const PostHogClient&) = delete;
     void operator=(const PostHogClient&) = delete;
+
+    /**
+     * @brief Start the connection worker tasks
+     *
+     * Call once during setup, before the insight task starts calling process().
+     */
+    void begin();
     
     /**
      * @brief Queue an insight for immediate fetch
@@ -44,10 +88,32 @@ public:
      * @param insight_id ID of insight to fetch
      * @param forceRefresh If true, force recalculation instead of using cache
      * 
-     * Adds insight to request queue with retry count of 0.
-     * Will be processed in FIFO order.
+     * Adds insight to request queue with retry count of 0 and schedules
+     * it for refreshes. Will be processed in FIFO order. If the insight is
+     * already queued or in flight, the request is merged into that one.
+     * Safe to call from any task.
      */
     void requestInsightData(const String& insight_id, bool forceRefresh = false);
+
+    /**
+     * @brief Tell the scheduler which insight is on screen
+     * @param insight_id Insight on the visible card, or empty if none
+     *
+     * The visible insight refreshes on the tightest interval.
+     */
+    void setVisibleInsight(const String& insight_id);
+
+    /**
+     * @brief Stop refreshing insights that no card shows
+     * @param insight_ids Insight IDs of every remaining insight card
+     */
+    void retainInsights(const std::vector<String>& insight_ids);
+
+    /**
+     * @brief Override the adaptive refresh interval
+     * @param minutes Refresh interval, or 0 for adaptive scheduling
+     */
+    void setRefreshIntervalMinutes(uint16_t minutes);
     
     /**
      * @brief Check if client is ready for operation
@@ -56,82 +122,285 @@ public:
      */
     bool isReady() const;
     
+    /**
+     * @brief Report refresh and connection figures
+     * @param out JSON object to fill, e.g. the "posthog" section of /api/status
+     */
+    void writeStats(JsonObject out) const;
+    
     /**
      * @brief Process queued requests and refreshes
      * 
      * Should be called regularly in main loop.
      * Handles:
-     * - Processing queued requests
-     * - Retrying failed requests
+     * - Dispatching queued requests to idle connections
+     * - Publishing finished requests and retrying failed ones
      * - Refreshing existing insights
      */
     void process();
     
 private:
     /**
-     * @struct QueuedRequest
-     * @brief Tracks a queued insight request
+     * @struct InsightValidators
+     * @brief What the client knows about the last response for an insight
      */
-    struct QueuedRequest {
-        String insight_id;     ///< ID of insight to fetch
-        uint8_t retry_count;   ///< Number of retry attempts
-        bool force_refresh;    ///< Force recalculation instead of cache
+    struct InsightValidators {
+        String etag;                ///< ETag of the last full response, sent as If-None-Match
+        String last_modified;       ///< Last-Modified of the last full response, sent as If-Modified-Since
+        uint32_t content_hash = 0;  ///< InsightParser::contentHash() of the last published data
     };
     
+    /**
+     * @struct DashboardTile
+     * @brief What the insight task needs of one parsed dashboard tile
+     */
+    struct DashboardTile {
+        std::shared_ptr<const InsightSnapshot> snapshot; ///< Extracted insight, or nullptr if it didn't parse
+        bool empty_result = false;               ///< Not calculated yet
+        uint32_t content_hash = 0;               ///< InsightParser::contentHash() of the tile
+        size_t document_used = 0;                ///< Bytes of the tile's parse document used
+        InsightParser::InsightType filter_type = InsightParser::InsightType::INSIGHT_NOT_SUPPORTED; ///< InsightParser::filterType() of the tile
+    };
+
+    /**
+     * @struct FetchJob
+     * @brief One request handed to a connection worker and back
+     *
+     * Allocated by the insight task, filled in by the worker and returned
+     * through the result queue, so only a pointer crosses tasks.
+     */
+    struct FetchJob {
+        QueuedRequest request;                   ///< Request being served, unless this is a batch
+        std::vector<QueuedRequest> batch;        ///< Requests served by one dashboard fetch, if any
+        String dashboard_url;                    ///< Dashboard URL of a batch
+        String cached_url;                       ///< force_cache URL, built on the insight task
+        String async_url;                        ///< async URL for force refreshes and empty results
+        String query_url;                        ///< Status URL of request.query_id, if it has one
+        unsigned long queued_ms = 0;             ///< When the job was handed to the pool
+        InsightValidators validators;            ///< Sent with conditional (refresh) requests
+        size_t document_hint = 0;                ///< Document size the last parse of this insight used, or 0
+        InsightParser::InsightType filter_type = InsightParser::InsightType::INSIGHT_NOT_SUPPORTED; ///< Filter to parse with; the worker sets it to the parse's filterType()
+
+        // Filled in by the worker
+        std::shared_ptr<InsightParser> parser;   ///< Parsed response; released on the worker once extracted
+        std::shared_ptr<const InsightSnapshot> snapshot; ///< Extracted insight on success, nullptr if the body wasn't one
+        String pending_query_id;                 ///< Calculation still running; there is no snapshot
+        std::map<String, DashboardTile> tiles;   ///< Parsed dashboard tiles by short ID
+        bool query_failed = false;               ///< The calculation failed on the server
+        bool success = false;                    ///< Whether the fetch produced data
+        bool not_modified = false;               ///< Server answered 304; there is no snapshot
+        bool offline = false;                    ///< WiFi was down, nothing was sent
+        int http_code = 0;                       ///< Last HTTPClient result; negative for connection errors
+        InsightValidators response_validators;   ///< Validators of the response received
+        uint8_t connection = 0;                  ///< Index of the connection that served it
+        uint8_t http_requests = 0;               ///< 2 when the cached result was empty or a poll completed
+        unsigned long wait_ms = 0;               ///< Time waiting for an idle connection
+        unsigned long request_ms = 0;            ///< Time from GET to response headers
+        unsigned long parse_ms = 0;              ///< Time streaming and parsing the body
+        size_t body_bytes = 0;                   ///< Body bytes read from the socket
+        size_t inflated_bytes = 0;               ///< Body bytes after inflating; 0 if sent uncompressed
+        size_t document_used = 0;                ///< Bytes of the parse document used
+        size_t document_capacity = 0;            ///< Size of the parse document
+        bool document_full = false;              ///< The body didn't fit the document; retry with a larger one
+    };
+
+    /**
+     * @struct Connection
+     * @brief A persistent TLS connection and the worker task that drives it
+     */
+    struct Connection {
+        PostHogClient* owner = nullptr;          ///< Client whose job queue this worker serves
+        uint8_t index = 0;                       ///< Position in the pool, for logging
+        SecureClient client;                     ///< Verified TLS client, resumes sessions on reconnect
+        HTTPClient http;                         ///< HTTP client reusing the client's socket
+        TaskHandle_t task = nullptr;             ///< Worker task
+    };
+
     // Configuration
     ConfigManager& _config;         ///< Configuration storage
     EventQueue& _eventQueue;        ///< Event system
+    SnapshotStore& _snapshotStore;  ///< Last data of each insight, shown at boot
+    EventSubscription _forceRefreshSubscription; ///< INSIGHT_FORCE_REFRESH handler
     
     // Request tracking
-    std::set<String> requested_insights;  ///< All known insight IDs
-    std::queue<QueuedRequest> request_queue; ///< Queue of pending requests
-    bool has_active_request;               ///< Request in progress flag
-    WiFiClientSecure _secureClient;        ///< Secure WiFi client for HTTPS
-    HTTPClient _http;                      ///< HTTP client instance
-    unsigned long last_refresh_check;       ///< Last refresh timestamp
+    SemaphoreHandle_t _queueMutex;           ///< Guards request_queue, _scheduler, _retryPolicy and _validators
+    RefreshScheduler _scheduler;             ///< Refresh deadline of every insight shown on a card
+    RetryPolicy _retryPolicy;                ///< Retry backoff and per-host circuit breaker
+    InsightRequestQueue request_queue;       ///< Pending and in-flight requests, one per insight
+    std::map<String, InsightValidators> _validators; ///< Per-insight validators
+    uint32_t _refreshesNotModified;          ///< Refreshes answered 304 Not Modified
+    uint32_t _refreshesUnchanged;            ///< Refreshes whose content hash matched
+    std::map<String, size_t> _documentPeaks; ///< Parse document bytes each insight used last time
+    std::map<String, InsightParser::InsightType> _filterTypes; ///< Filter each insight's last parse called for
+    uint32_t _asyncQueries;                  ///< Calculations started by async refreshes
+
+    // Dashboard batching
+    int _dashboardId;                        ///< Dashboard _dashboardMembers describes
+    bool _dashboardUsable;                   ///< False once the dashboard failed in a way retries won't fix
+    std::map<String, bool> _dashboardMembers; ///< Whether each insight seen so far is on the dashboard
+    uint32_t _dashboardFetches;              ///< Successful dashboard fetches
+    uint32_t _dashboardInsights;             ///< Insights served by dashboard fetches
+    size_t _dashboardDocumentPeak;           ///< Document bytes the last dashboard parse used
+
+    // Connection pool
+    uint8_t _poolSize;                                  ///< Number of connections
+    std::vector<std::unique_ptr<Connection>> _connections; ///< Persistent connections
+    QueueHandle_t _jobQueue;                            ///< FetchJob* waiting for an idle connection
+    QueueHandle_t _resultQueue;                         ///< FetchJob* finished by a worker
+    uint8_t _inFlight;                                  ///< Jobs handed to the pool, not yet collected
+    unsigned long _batchStart;                          ///< When the pool last went from idle to busy
+    uint16_t _batchCount;                               ///< Jobs finished since _batchStart
     
     // Constants
     static const char* BASE_URL;                        ///< PostHog API base URL
-    static const unsigned long REFRESH_INTERVAL = 60000 * 30; ///< Refresh every 30 minutes
     static const uint8_t MAX_RETRIES = 3;              ///< Max retry attempts
-    static const unsigned long RETRY_DELAY = 1000;      ///< Delay between retries
+    static constexpr uint8_t MAX_POLLS = 20;              ///< Status polls before giving up on a calculation
+    static constexpr unsigned long POLL_INTERVAL = 1000;      ///< ms before the first status poll
+    static constexpr unsigned long MAX_POLL_INTERVAL = 16000; ///< Longest wait between status polls
+    static constexpr size_t MIN_DASHBOARD_BATCH = 2;      ///< Ready requests worth a dashboard fetch
+    static constexpr size_t DASHBOARD_DOC_SIZE = 131072;  ///< Largest first guess at a dashboard document
+    static constexpr uint8_t MIN_POOL_SIZE = 2;           ///< Smallest allowed pool
+    static constexpr uint8_t MAX_POOL_SIZE = 4;           ///< Largest allowed pool
     
-
-
-        /**
+    /**
      * @brief Build Base API URL based on project region
      */
     String buildBaseUrl() const;
 
     /**
-     * @brief Handle system state changes
-     * @param state New system state
+     * @brief Host part of the base URL, which keys the circuit breaker
+     */
+    String apiHost() const;
+
+    /**
+     * @brief Hand queued requests to idle connections
      */
-    void onSystemStateChange(SystemState state);
+    void dispatchQueue();
+
+    /**
+     * @brief Move ready requests for dashboard insights into a batch job
+     * 
+     * @param dashboard_id Configured dashboard, or ConfigManager::NO_DASHBOARD_ID
+     * @param now Current millis()
+     * @param job Job receiving the requests
+     * @return true if enough requests were ready to make a batch
+     * 
+     * Force refreshes, async polls and insights known not to be on the
+     * dashboard are left for single requests. Call with the queue mutex held.
+     */
+    bool takeDashboardBatch(int dashboard_id, unsigned long now, FetchJob& job);
+
     
     /**
-     * @brief Process pending requests in queue
+     * @brief Publish finished requests and requeue failed ones
+     * 
+     * Failed requests are requeued with a backoff instead of retried at once;
+     * requests that never went out because WiFi was down don't use up a retry.
+     * Requests whose calculation is still running are requeued to poll it,
+     * waiting longer after each poll.
+     */
+    void collectResults();
+
+    /**
+     * @brief Publish the tiles of a finished dashboard fetch
+     * 
+     * @param job Finished batch job
+     * @param host API host, for the circuit breaker
+     * 
+     * Requests whose insight wasn't on the dashboard, or had no result
+     * there, are requeued as single requests. Tiles of other tracked
+     * insights are published too, and their refreshes rescheduled.
+     */
+    void collectDashboard(FetchJob& job, const String& host);
+
+    /**
+     * @brief Tell the circuit breaker how a job went
+     * @param job Finished job
+     * @param host API host
+     */
+    void recordOutcome(const FetchJob& job, const String& host);
+
+    /**
+     * @brief Remember the validators of new data and decide whether to publish it
+     * 
+     * @param request Request the data answers
+     * @param response Validators of the data
+     * @return false for a background refresh whose content hash is unchanged
      * 
-     * Handles retry logic and request timeouts.
+     * Call with the queue mutex held.
      */
-    void processQueue();
+    bool acceptData(const QueuedRequest& request, const InsightValidators& response);
     
     /**
      * @brief Check if insights need refreshing
      * 
-     * Queues refresh requests for insights older than REFRESH_INTERVAL.
+     * Queues refresh requests for insights whose deadline has passed.
      */
     void checkRefreshes();
     
+    /**
+     * @brief Worker task serving jobs on one connection
+     * @param parameter The Connection this task drives
+     */
+    static void connectionTask(void* parameter);
+
     /**
      * @brief Fetch insight data from PostHog
      * 
-     * @param insight_id ID of insight to fetch
-     * @param response String to store response
-     * @param forceRefresh If true, force recalculation instead of using cache
+     * @param conn Connection to make the request on
+     * @param job Request to serve; receives the parser and timings
      * @return true if fetch was successful
+     * 
+     * Runs on the connection's worker task. Falls back to an async refresh
+     * when the cached insight has no result; if PostHog starts calculating
+     * it, the job returns the query ID to poll instead of waiting for it.
+     */
+    bool fetchInsight(Connection& conn, FetchJob& job);
+
+    /**
+     * @brief Check on the calculation of a request's query_id
+     * 
+     * @param conn Connection to make the request on
+     * @param job Request to serve
+     * @return true if the query is still running, or completed and the insight was fetched
+     * 
+     * Fetches the cached insight once the query completes; otherwise sets
+     * the job's pending_query_id so it's polled again.
      */
-    bool fetchInsight(const String& insight_id, String& response, bool forceRefresh = false);
+    bool pollQuery(Connection& conn, FetchJob& job);
+
+    /**
+     * @brief Fetch the configured dashboard and split it into tiles
+     * 
+     * @param conn Connection to make the request on
+     * @param job Batch job; receives a snapshot per insight tile
+     * @return true if the dashboard arrived complete and parsed
+     */
+    bool fetchDashboard(Connection& conn, FetchJob& job);
+
+    /**
+     * @brief Read the body of the response on a connection
+     * 
+     * @param conn Connection whose GET succeeded
+     * @param job Job receiving the timings and byte counts
+     * @param parse Deserializes the body from the stream it's given
+     * @return false if the body was cut short or failed to inflate
+     * 
+     * Strips chunked framing and inflates gzip as parse() reads, then ends
+     * the request, keeping the socket open for the next one.
+     */
+    bool readBody(Connection& conn, FetchJob& job, const std::function<void(Stream&)>& parse);
+
+    /**
+     * @brief Make one insight request and parse the body as it arrives
+     * 
+     * @param conn Connection to make the request on
+     * @param url Insight URL from buildInsightUrl()
+     * @param job Job receiving the parser and timings
+     * @param conditional Send the job's validators so the server can answer 304
+     * @return true if the request succeeded and the body arrived complete, or was not modified
+     */
+    bool streamInsight(Connection& conn, const String& url, FetchJob& job, bool conditional);
     
     /**
      * @brief Build insight API URL
@@ -142,6 +411,22 @@ private:
      */
     String buildInsightUrl(const String& insight_id, const char* refresh_mode = "force_cache") const;
     
+    /**
+     * @brief Build the status URL of an async query
+     * 
+     * @param query_id ID reported by InsightParser::getPendingQuery()
+     * @return Complete API URL
+     */
+    String buildQueryUrl(const String& query_id) const;
+    
+    /**
+     * @brief Build dashboard API URL
+     * 
+     * @param dashboard_id ID of dashboard
+     * @return Complete API URL, asking for cached tile results
+     */
+    String buildDashboardUrl(int dashboard_id) const;
+    
     // Event-related methods
-    void publishInsightDataEvent(const String& insight_id, const String& response);
-}; 
\ No newline at end of file
+    void publishInsightDataEvent(const String& insight_id, std::shared_ptr<const InsightSnapshot> snapshot);
+}; 
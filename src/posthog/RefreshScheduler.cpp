@@ -0,0 +1,122 @@
+#include "RefreshScheduler.h"
+#include <algorithm>
+
+namespace {
+// Weight of the newest refresh in the change-rate average; about the last
+// five refreshes matter
+constexpr float CHANGE_RATE_WEIGHT = 0.3f;
+
+// Wrap-safe "a is at or after b" for millis() values
+bool reached(unsigned long now, unsigned long deadline) {
+    return static_cast<long>(now - deadline) >= 0;
+}
+}
+
+void RefreshScheduler::track(const String& insight_id, unsigned long now) {
+    if (_entries.count(insight_id)) {
+        return;
+    }
+    Entry& entry = _entries[insight_id];
+    entry.last_fetch = now;
+    entry.next_due = now + intervalFor(insight_id, entry);
+}
+
+void RefreshScheduler::retain(const std::vector<String>& insight_ids) {
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (std::find(insight_ids.begin(), insight_ids.end(), it->first) == insight_ids.end()) {
+            Serial.printf("[RefreshScheduler] No card shows %s any more, unscheduled\n", it->first.c_str());
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool RefreshScheduler::isTracked(const String& insight_id) const {
+    return _entries.count(insight_id) > 0;
+}
+
+void RefreshScheduler::setVisible(const String& insight_id, unsigned long now) {
+    if (_visible == insight_id) {
+        return;
+    }
+    _visible = insight_id;
+
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end() || it->second.due_taken) {
+        return;
+    }
+    // Pull the deadline in; stale data on screen is refreshed on the next tick
+    Entry& entry = it->second;
+    unsigned long due = entry.last_fetch + VISIBLE_INTERVAL;
+    if (reached(now, due)) {
+        due = now;
+    }
+    if (reached(entry.next_due, due)) {
+        entry.next_due = due;
+    }
+}
+
+void RefreshScheduler::setUserInterval(unsigned long interval_ms) {
+    _userInterval = interval_ms;
+    // Apply the new interval to deadlines already set
+    for (auto& [id, entry] : _entries) {
+        if (!entry.due_taken) {
+            entry.next_due = entry.last_fetch + intervalFor(id, entry);
+        }
+    }
+}
+
+bool RefreshScheduler::takeDue(unsigned long now, String& insight_id) {
+    Entry* earliest = nullptr;
+    for (auto& [id, entry] : _entries) {
+        if (entry.due_taken || !reached(now, entry.next_due)) {
+            continue;
+        }
+        if (!earliest || reached(earliest->next_due, entry.next_due)) {
+            earliest = &entry;
+            insight_id = id;
+        }
+    }
+    if (!earliest) {
+        return false;
+    }
+    earliest->due_taken = true;
+    return true;
+}
+
+void RefreshScheduler::recordChange(const String& insight_id, bool changed) {
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end()) {
+        return;
+    }
+    float& rate = it->second.change_rate;
+    rate = rate * (1.0f - CHANGE_RATE_WEIGHT) + (changed ? CHANGE_RATE_WEIGHT : 0.0f);
+}
+
+void RefreshScheduler::reschedule(const String& insight_id, unsigned long now) {
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end()) {
+        return;
+    }
+    Entry& entry = it->second;
+    entry.last_fetch = now;
+    entry.next_due = now + intervalFor(insight_id, entry);
+    entry.due_taken = false;
+}
+
+unsigned long RefreshScheduler::intervalFor(const String& insight_id) const {
+    auto it = _entries.find(insight_id);
+    return it == _entries.end() ? 0 : intervalFor(insight_id, it->second);
+}
+
+unsigned long RefreshScheduler::intervalFor(const String& insight_id, const Entry& entry) const {
+    unsigned long interval = _userInterval;
+    if (interval == 0) {
+        interval = MAX_INTERVAL - static_cast<unsigned long>((MAX_INTERVAL - MIN_INTERVAL) * entry.change_rate);
+    }
+    if (insight_id == _visible) {
+        interval = std::min(interval, VISIBLE_INTERVAL);
+    }
+    return interval;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+/**
+ * @class RefreshScheduler
+ * @brief Per-insight refresh deadlines for PostHogClient
+ *
+ * Each tracked insight gets its own deadline instead of sharing one timer:
+ * - The insight on the visible card refreshes every VISIBLE_INTERVAL
+ * - Other insights refresh between MIN_INTERVAL and MAX_INTERVAL, sooner
+ *   the more often recent refreshes actually changed the data
+ * - A user-configured interval, if set, replaces the adaptive one
+ *
+ * Not thread-safe; PostHogClient guards it with its queue mutex. All times
+ * are millis() values passed in by the caller.
+ */
+class RefreshScheduler {
+public:
+    static constexpr unsigned long VISIBLE_INTERVAL = 2UL * 60 * 1000;  ///< Visible card
+    static constexpr unsigned long MIN_INTERVAL = 5UL * 60 * 1000;      ///< Insight that changes every refresh
+    static constexpr unsigned long MAX_INTERVAL = 60UL * 60 * 1000;     ///< Insight that never changes
+
+    /**
+     * @brief Start scheduling an insight if it isn't already
+     * @param insight_id Insight to track
+     * @param now Current millis(); the caller is fetching it now
+     */
+    void track(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Stop scheduling every insight not in the list
+     * @param insight_ids Insights that still have a card
+     */
+    void retain(const std::vector<String>& insight_ids);
+
+    /**
+     * @brief Check whether an insight is scheduled
+     */
+    bool isTracked(const String& insight_id) const;
+
+    /**
+     * @brief Mark which insight is on screen
+     * @param insight_id Insight on the visible card, or empty if none
+     * @param now Current millis()
+     *
+     * Data older than VISIBLE_INTERVAL becomes due at once.
+     */
+    void setVisible(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Set the user-configured interval
+     * @param interval_ms Refresh interval, or 0 for adaptive scheduling
+     */
+    void setUserInterval(unsigned long interval_ms);
+
+    /**
+     * @brief Take the next insight whose deadline has passed
+     * @param now Current millis()
+     * @param insight_id Receives the due insight
+     * @return true if an insight was due
+     *
+     * The insight isn't returned again until reschedule() is called for it.
+     */
+    bool takeDue(unsigned long now, String& insight_id);
+
+    /**
+     * @brief Feed back whether a refresh changed the insight's data
+     * @param insight_id Insight that was fetched
+     * @param changed true if the data differed from the previous fetch
+     */
+    void recordChange(const String& insight_id, bool changed);
+
+    /**
+     * @brief Set the next deadline after a fetch finished or was given up
+     * @param insight_id Insight that was fetched
+     * @param now Current millis()
+     */
+    void reschedule(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Current refresh interval for an insight
+     * @return Interval in ms, or 0 if the insight isn't tracked
+     */
+    unsigned long intervalFor(const String& insight_id) const;
+
+    /**
+     * @brief Number of tracked insights
+     */
+    size_t size() const { return _entries.size(); }
+
+private:
+    struct Entry {
+        unsigned long last_fetch = 0;   ///< When the last fetch finished
+        unsigned long next_due = 0;     ///< When the next refresh is due
+        float change_rate = 0.5f;       ///< Moving average of refreshes that changed the data
+        bool due_taken = false;         ///< Handed out by takeDue(), not yet rescheduled
+    };
+
+    unsigned long intervalFor(const String& insight_id, const Entry& entry) const;
+
+    std::map<String, Entry> _entries;
+    String _visible;
+    unsigned long _userInterval = 0;
+};
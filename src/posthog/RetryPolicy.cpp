@@ -0,0 +1,95 @@
+#include "RetryPolicy.h"
+#include <algorithm>
+
+namespace {
+// Wrap-safe "a is at or after b" for millis() values
+bool reached(unsigned long now, unsigned long deadline) {
+    return static_cast<long>(now - deadline) >= 0;
+}
+}
+
+bool RetryPolicy::isRetryable(int http_code) {
+    return http_code <= 0 || http_code == 408 || http_code == 429 || http_code >= 500;
+}
+
+unsigned long RetryPolicy::backoff(uint8_t attempt) const {
+    unsigned long step = BASE_DELAY;
+    for (uint8_t i = 1; i < attempt && step < MAX_DELAY; i++) {
+        step *= 2;
+    }
+    step = std::min(step, MAX_DELAY);
+    // Jitter keeps requests that failed together from retrying together
+    return step / 2 + random(step / 2 + 1);
+}
+
+bool RetryPolicy::allowRequest(const String& host, unsigned long now) {
+    auto it = _circuits.find(host);
+    if (it == _circuits.end()) {
+        return true;
+    }
+    Circuit& circuit = it->second;
+    switch (circuit.state) {
+        case State::CLOSED:
+            return true;
+        case State::OPEN:
+            if (!reached(now, circuit.open_until)) {
+                return false;
+            }
+            Serial.printf("[RetryPolicy] Circuit for %s half-open, sending a probe\n", host.c_str());
+            circuit.state = State::HALF_OPEN;
+            circuit.probe_in_flight = true;
+            return true;
+        case State::HALF_OPEN:
+            if (circuit.probe_in_flight) {
+                return false;
+            }
+            circuit.probe_in_flight = true;
+            return true;
+    }
+    return true;
+}
+
+void RetryPolicy::recordSuccess(const String& host) {
+    auto it = _circuits.find(host);
+    if (it == _circuits.end()) {
+        return;
+    }
+    if (it->second.state != State::CLOSED) {
+        Serial.printf("[RetryPolicy] Circuit for %s closed\n", host.c_str());
+    }
+    _circuits.erase(it);
+}
+
+void RetryPolicy::recordFailure(const String& host, unsigned long now) {
+    Circuit& circuit = _circuits[host];
+    switch (circuit.state) {
+        case State::CLOSED:
+            if (++circuit.failures < FAILURE_THRESHOLD) {
+                return;
+            }
+            break;
+        case State::HALF_OPEN:
+            // The probe failed; stay away longer this time
+            circuit.open_time = std::min(circuit.open_time * 2, MAX_OPEN_TIME);
+            break;
+        case State::OPEN:
+            // A request sent before the circuit opened; already counted
+            return;
+    }
+    circuit.state = State::OPEN;
+    circuit.probe_in_flight = false;
+    circuit.open_until = now + circuit.open_time;
+    Serial.printf("[RetryPolicy] Circuit for %s open for %lu s\n", host.c_str(), circuit.open_time / 1000);
+}
+
+void RetryPolicy::recordAbandoned(const String& host) {
+    auto it = _circuits.find(host);
+    if (it != _circuits.end()) {
+        it->second.probe_in_flight = false;
+    }
+}
+
+bool RetryPolicy::isOpen(const String& host) const {
+    auto it = _circuits.find(host);
+    return it != _circuits.end() && it->second.state != State::CLOSED;
+}
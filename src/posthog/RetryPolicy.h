@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+
+/**
+ * @class RetryPolicy
+ * @brief Backoff and circuit breaking for failed PostHog requests
+ *
+ * Failed requests wait an exponentially growing, jittered delay before
+ * their next attempt instead of retrying straight away. Each host also
+ * has a circuit breaker:
+ * - Closed: requests flow; FAILURE_THRESHOLD failures in a row open it
+ * - Open: no requests for the open time, which doubles up to MAX_OPEN_TIME
+ *   every time the circuit re-opens
+ * - Half-open: one probe request is let through; success closes the
+ *   circuit, failure opens it again
+ *
+ * Not thread-safe; PostHogClient guards it with its queue mutex. All times
+ * are millis() values passed in by the caller.
+ */
+class RetryPolicy {
+public:
+    static constexpr unsigned long BASE_DELAY = 2000;            ///< Backoff before the first retry
+    static constexpr unsigned long MAX_DELAY = 60UL * 1000;      ///< Longest backoff
+    static constexpr uint8_t FAILURE_THRESHOLD = 3;              ///< Consecutive failures that open a circuit
+    static constexpr unsigned long OPEN_TIME = 30UL * 1000;      ///< First open period
+    static constexpr unsigned long MAX_OPEN_TIME = 5UL * 60 * 1000; ///< Longest open period
+
+    /**
+     * @brief Check whether a failed response is worth retrying
+     * @param http_code HTTPClient result; negative for connection errors
+     * @return true for connection errors, timeouts, rate limiting and 5xx
+     *
+     * Other 4xx responses, e.g. a bad API key or insight ID, will fail the
+     * same way every time.
+     */
+    static bool isRetryable(int http_code);
+
+    /**
+     * @brief Delay before a retry
+     * @param attempt Retry number, starting at 1
+     * @return Delay in ms: half the exponential step plus a random share of the other half
+     */
+    unsigned long backoff(uint8_t attempt) const;
+
+    /**
+     * @brief Check whether a request to a host may go out now
+     * @param host Host the request is for
+     * @param now Current millis()
+     * @return false while the circuit is open or its probe is in flight
+     *
+     * Lets the half-open probe through, so only call it when the request
+     * will actually be sent.
+     */
+    bool allowRequest(const String& host, unsigned long now);
+
+    /**
+     * @brief Record a request that reached the host and succeeded
+     */
+    void recordSuccess(const String& host);
+
+    /**
+     * @brief Record a request that failed in a retryable way
+     * @param host Host the request was for
+     * @param now Current millis()
+     */
+    void recordFailure(const String& host, unsigned long now);
+
+    /**
+     * @brief Record a request that never reached the host, e.g. WiFi was down
+     *
+     * Counts neither way, but frees the half-open probe slot.
+     */
+    void recordAbandoned(const String& host);
+
+    /**
+     * @brief Check whether a host's circuit is open or half-open
+     */
+    bool isOpen(const String& host) const;
+
+private:
+    enum class State {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    struct Circuit {
+        State state = State::CLOSED;
+        uint8_t failures = 0;                ///< Consecutive failures while closed
+        unsigned long open_until = 0;        ///< When an open circuit turns half-open
+        unsigned long open_time = OPEN_TIME; ///< Length of the next open period
+        bool probe_in_flight = false;        ///< Half-open probe sent, result pending
+    };
+
+    std::map<String, Circuit> _circuits;
+};
@@ -0,0 +1,103 @@
+#include "SnapshotFlash.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+
+SnapshotFlash::SnapshotFlash(const char* label) : _label(label) {}
+
+SnapshotFlash::~SnapshotFlash() {
+    if (_data) {
+        esp_partition_munmap(_mmapHandle);
+    }
+}
+
+bool SnapshotFlash::begin() {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, _label);
+    if (!_partition) {
+        printf("[SnapshotFlash] No '%s' partition; flash the current partition table\n", _label);
+        return false;
+    }
+
+    const void* mapped = nullptr;
+    esp_err_t err = esp_partition_mmap(_partition, 0, _partition->size, ESP_PARTITION_MMAP_DATA,
+                                       &mapped, &_mmapHandle);
+    if (err != ESP_OK) {
+        printf("[SnapshotFlash] Failed to map '%s': %s\n", _label, esp_err_to_name(err));
+        return false;
+    }
+    _data = static_cast<const uint8_t*>(mapped);
+    _size = _partition->size;
+    return true;
+}
+
+bool SnapshotFlash::erase(size_t offset, size_t length) {
+    if (!_partition || esp_partition_erase_range(_partition, offset, length) != ESP_OK) {
+        return false;
+    }
+    _eraseCount += length / SECTOR_SIZE;
+    return true;
+}
+
+bool SnapshotFlash::write(size_t offset, const void* src, size_t length) {
+    // The flash driver keeps the mapped view coherent with what it writes
+    return _partition && esp_partition_write(_partition, offset, src, length) == ESP_OK;
+}
+
+#else
+
+SnapshotFlash::SnapshotFlash(const char* path, size_t size) : _size(size), _path(path) {}
+
+SnapshotFlash::~SnapshotFlash() = default;
+
+bool SnapshotFlash::begin() {
+    _contents.assign(_size, 0xFF);
+    FILE* file = fopen(_path.c_str(), "rb");
+    if (file) {
+        size_t read = fread(_contents.data(), 1, _size, file);
+        fclose(file);
+        if (read != _size) {
+            // A short or empty file reads as erased past its end
+            memset(_contents.data() + read, 0xFF, _size - read);
+        }
+    }
+    _data = _contents.data();
+    return flush(0, _size);
+}
+
+bool SnapshotFlash::erase(size_t offset, size_t length) {
+    if (offset % SECTOR_SIZE != 0 || length % SECTOR_SIZE != 0 || offset + length > _size) {
+        return false;
+    }
+    memset(_contents.data() + offset, 0xFF, length);
+    _eraseCount += length / SECTOR_SIZE;
+    return flush(offset, length);
+}
+
+bool SnapshotFlash::write(size_t offset, const void* src, size_t length) {
+    if (offset + length > _size) {
+        return false;
+    }
+    // NOR flash can only clear bits
+    const uint8_t* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < length; i++) {
+        _contents[offset + i] &= bytes[i];
+    }
+    return flush(offset, length);
+}
+
+bool SnapshotFlash::flush(size_t offset, size_t length) {
+    FILE* file = fopen(_path.c_str(), "r+b");
+    if (!file) {
+        file = fopen(_path.c_str(), "w+b");
+    }
+    if (!file) {
+        return false;
+    }
+    bool ok = fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+              fwrite(_contents.data() + offset, 1, length, file) == length;
+    fclose(file);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "esp_partition.h"
+#else
+#include <string>
+#include <vector>
+#endif
+
+/**
+ * @class SnapshotFlash
+ * @brief Raw access to the flash region behind SnapshotStore
+ *
+ * On the device this is the "snapshots" data partition, memory-mapped so
+ * stored snapshots are read in place. On host it is a file of the same
+ * size that behaves like NOR flash: erasing sets bytes to 0xFF and writing
+ * can only clear bits. That lets the store be exercised without hardware.
+ */
+class SnapshotFlash {
+public:
+    static constexpr size_t SECTOR_SIZE = 4096;   ///< Erase granularity
+
+#ifdef ARDUINO
+    /**
+     * @brief Constructor
+     * @param label Partition label in partitions.csv
+     */
+    explicit SnapshotFlash(const char* label = "snapshots");
+#else
+    /**
+     * @brief Constructor
+     * @param path File standing in for the partition; created erased if missing
+     * @param size Partition size, a multiple of SECTOR_SIZE
+     */
+    SnapshotFlash(const char* path, size_t size);
+#endif
+
+    ~SnapshotFlash();
+
+    SnapshotFlash(const SnapshotFlash&) = delete;
+    SnapshotFlash& operator=(const SnapshotFlash&) = delete;
+
+    /**
+     * @brief Find and map the partition
+     * @return false if there is no such partition or it can't be mapped
+     */
+    bool begin();
+
+    /**
+     * @brief Read-only view of the whole partition
+     * @return Mapped contents, or nullptr before a successful begin()
+     */
+    const uint8_t* data() const { return _data; }
+
+    /**
+     * @brief Partition size in bytes
+     */
+    size_t size() const { return _size; }
+
+    /**
+     * @brief Erase whole sectors
+     * @param offset Sector-aligned start
+     * @param length Multiple of SECTOR_SIZE
+     * @return true on success
+     */
+    bool erase(size_t offset, size_t length);
+
+    /**
+     * @brief Program bytes; the range must have been erased
+     * @return true on success
+     */
+    bool write(size_t offset, const void* src, size_t length);
+
+    /**
+     * @brief Sectors erased since boot, for wear reporting
+     */
+    uint32_t eraseCount() const { return _eraseCount; }
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    uint32_t _eraseCount = 0;
+
+#ifdef ARDUINO
+    const char* _label;
+    const esp_partition_t* _partition = nullptr;
+    esp_partition_mmap_handle_t _mmapHandle = 0;
+#else
+    bool flush(size_t offset, size_t length);
+
+    std::string _path;
+    std::vector<uint8_t> _contents;
+#endif
+};
@@ -0,0 +1,308 @@
+#include "SnapshotStore.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+constexpr uint32_t BANK_MAGIC = 0x53534844;  // "DHSS"
+constexpr uint16_t RECORD_MAGIC = 0x5AA5;
+
+struct BankHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t generation;
+    uint32_t unused;
+};
+
+struct RecordHeader {
+    uint16_t magic;
+    uint8_t id_size;
+    uint8_t reserved;
+    uint16_t payload_size;
+    uint16_t unused;
+    uint32_t crc;          // Over the ID and payload
+};
+
+static_assert(sizeof(BankHeader) == 16, "BankHeader layout");
+static_assert(sizeof(RecordHeader) == 12, "RecordHeader layout");
+
+// Records start on 4-byte boundaries, as flash writes prefer
+size_t padded(size_t size) {
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+}
+
+SnapshotStore::SnapshotStore(SnapshotFlash& flash)
+    : _flash(flash)
+    , _ready(false)
+    , _bankSize(0)
+    , _activeBank(0)
+    , _generation(0)
+    , _writePos(0) {
+}
+
+bool SnapshotStore::begin() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_flash.begin() || _flash.size() < 2 * SnapshotFlash::SECTOR_SIZE) {
+        return false;
+    }
+    _bankSize = (_flash.size() / 2) & ~(SnapshotFlash::SECTOR_SIZE - 1);
+
+    // The valid bank with the newest generation is active
+    bool found = false;
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        BankHeader header;
+        memcpy(&header, _flash.data() + bankBase(bank), sizeof(header));
+        if (header.magic != BANK_MAGIC || header.version != STORE_VERSION) {
+            continue;
+        }
+        if (!found || static_cast<int32_t>(header.generation - _generation) > 0) {
+            found = true;
+            _activeBank = bank;
+            _generation = header.generation;
+        }
+    }
+
+    if (!found) {
+        printf("[SnapshotStore] No snapshots in version %u format, starting empty\n", STORE_VERSION);
+        if (!formatBank(0, 1)) {
+            return false;
+        }
+        _activeBank = 0;
+        _generation = 1;
+    }
+
+    _ready = true;
+    scanBank();
+    printf("[SnapshotStore] %zu snapshot(s) in bank %u, %zu of %zu bytes used\n",
+           _entries.size(), _activeBank, _writePos - bankBase(_activeBank), _bankSize);
+    return true;
+}
+
+bool SnapshotStore::formatBank(uint8_t bank, uint32_t generation) {
+    if (!_flash.erase(bankBase(bank), _bankSize)) {
+        return false;
+    }
+    BankHeader header = {BANK_MAGIC, STORE_VERSION, 0xFFFF, generation, 0xFFFFFFFF};
+    return _flash.write(bankBase(bank), &header, sizeof(header));
+}
+
+bool SnapshotStore::readRecord(size_t offset, size_t limit, std::string* id, const uint8_t** payload,
+                               size_t* payload_size, size_t* record_size) const {
+    if (offset + sizeof(RecordHeader) > limit) {
+        return false;
+    }
+    RecordHeader header;
+    memcpy(&header, _flash.data() + offset, sizeof(header));
+    if (header.magic != RECORD_MAGIC) {
+        return false;
+    }
+    size_t size = padded(sizeof(header) + header.id_size + header.payload_size);
+    if (offset + size > limit) {
+        return false;
+    }
+    *record_size = size;
+
+    const uint8_t* body = _flash.data() + offset + sizeof(header);
+    if (crc32(0, body, header.id_size + header.payload_size) != header.crc) {
+        // Torn write; the size is still right, so the log goes on after it
+        id->clear();
+        return true;
+    }
+    id->assign(reinterpret_cast<const char*>(body), header.id_size);
+    *payload = body + header.id_size;
+    *payload_size = header.payload_size;
+    return true;
+}
+
+void SnapshotStore::scanBank() {
+    _entries.clear();
+    size_t base = bankBase(_activeBank);
+    size_t limit = base + _bankSize;
+    size_t offset = base + sizeof(BankHeader);
+
+    while (offset + sizeof(RecordHeader) <= limit) {
+        uint16_t magic;
+        memcpy(&magic, _flash.data() + offset, sizeof(magic));
+        if (magic == 0xFFFF) {
+            break;  // Erased: end of the log
+        }
+
+        std::string id;
+        const uint8_t* payload = nullptr;
+        size_t payload_size = 0;
+        size_t record_size = 0;
+        if (!readRecord(offset, limit, &id, &payload, &payload_size, &record_size)) {
+            // Garbage; nothing after it can be trusted, so the next save compacts
+            printf("[SnapshotStore] Unreadable record at 0x%zx\n", offset);
+            offset = limit;
+            break;
+        }
+        if (!id.empty()) {
+            _entries[id].offset = offset;
+        }
+        offset += record_size;
+    }
+    _writePos = offset;
+}
+
+bool SnapshotStore::load(const std::string& insight_id, InsightSnapshot& snapshot) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _entries.find(insight_id);
+    if (!_ready || it == _entries.end()) {
+        return false;
+    }
+    std::string id;
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+    size_t record_size = 0;
+    size_t limit = bankBase(_activeBank) + _bankSize;
+    // Decodes straight from the mapped partition
+    return readRecord(it->second.offset, limit, &id, &payload, &payload_size, &record_size) &&
+           id == insight_id && snapshot.decode(payload, payload_size);
+}
+
+bool SnapshotStore::save(const std::string& insight_id, const InsightSnapshot& snapshot, unsigned long now) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_ready || insight_id.empty() || insight_id.size() > 255) {
+        return false;
+    }
+
+    size_t payload_size = snapshot.encodedSize();
+    if (payload_size == 0 || padded(sizeof(RecordHeader) + insight_id.size() + payload_size) > MAX_RECORD_SIZE) {
+        printf("[SnapshotStore] Snapshot of %s is too large to store (%zu bytes)\n", insight_id.c_str(), payload_size);
+        return false;
+    }
+    std::vector<uint8_t> payload(payload_size);
+    snapshot.encode(payload.data(), payload.size());
+
+    auto it = _entries.find(insight_id);
+    if (it != _entries.end()) {
+        Entry& entry = it->second;
+        if (entry.written && now - entry.written_ms < MIN_REWRITE_INTERVAL) {
+            return false;
+        }
+        std::string id;
+        const uint8_t* stored = nullptr;
+        size_t stored_size = 0;
+        size_t record_size = 0;
+        size_t limit = bankBase(_activeBank) + _bankSize;
+        if (readRecord(entry.offset, limit, &id, &stored, &stored_size, &record_size) &&
+            stored_size == payload_size && memcmp(stored, payload.data(), payload_size) == 0) {
+            return false;
+        }
+    }
+
+    size_t record_size = padded(sizeof(RecordHeader) + insight_id.size() + payload_size);
+    if (_writePos + record_size > bankBase(_activeBank) + _bankSize) {
+        if (!compact(insight_id) || _writePos + record_size > bankBase(_activeBank) + _bankSize) {
+            printf("[SnapshotStore] No room for %s\n", insight_id.c_str());
+            return false;
+        }
+    }
+
+    if (!append(insight_id, payload.data(), payload_size)) {
+        return false;
+    }
+    Entry& entry = _entries[insight_id];
+    entry.written = true;
+    entry.written_ms = now;
+    return true;
+}
+
+bool SnapshotStore::append(const std::string& insight_id, const uint8_t* payload, size_t payload_size) {
+    size_t record_size = padded(sizeof(RecordHeader) + insight_id.size() + payload_size);
+    std::vector<uint8_t> record(record_size, 0xFF);
+
+    RecordHeader header = {RECORD_MAGIC, static_cast<uint8_t>(insight_id.size()), 0xFF,
+                           static_cast<uint16_t>(payload_size), 0xFFFF, 0};
+    uint8_t* body = record.data() + sizeof(header);
+    memcpy(body, insight_id.data(), insight_id.size());
+    memcpy(body + insight_id.size(), payload, payload_size);
+    header.crc = crc32(0, body, insight_id.size() + payload_size);
+    memcpy(record.data(), &header, sizeof(header));
+
+    // One write, so a power cut leaves at most one record failing its CRC
+    if (!_flash.write(_writePos, record.data(), record.size())) {
+        printf("[SnapshotStore] Flash write failed at 0x%zx\n", _writePos);
+        return false;
+    }
+    _entries[insight_id].offset = _writePos;
+    _writePos += record_size;
+    return true;
+}
+
+bool SnapshotStore::compact(const std::string& skip_id) {
+    uint8_t target = 1 - _activeBank;
+    size_t base = bankBase(target);
+    size_t limit = bankBase(_activeBank) + _bankSize;
+    if (!_flash.erase(base, _bankSize)) {
+        return false;
+    }
+
+    size_t offset = base + sizeof(BankHeader);
+    std::vector<uint8_t> record;
+    std::map<std::string, Entry> kept;
+    for (const auto& [id, entry] : _entries) {
+        std::string stored_id;
+        const uint8_t* payload = nullptr;
+        size_t payload_size = 0;
+        size_t record_size = 0;
+        if (id == skip_id ||
+            !readRecord(entry.offset, limit, &stored_id, &payload, &payload_size, &record_size) ||
+            stored_id != id) {
+            continue;
+        }
+        // Copy through RAM; flash can't be written from its own mapped view
+        record.assign(_flash.data() + entry.offset, _flash.data() + entry.offset + record_size);
+        if (!_flash.write(offset, record.data(), record.size())) {
+            return false;
+        }
+        kept[id] = entry;
+        kept[id].offset = offset;
+        offset += record_size;
+    }
+
+    // The header goes last, so the old bank stays active until the copy is whole
+    BankHeader header = {BANK_MAGIC, STORE_VERSION, 0xFFFF, _generation + 1, 0xFFFFFFFF};
+    if (!_flash.write(base, &header, sizeof(header))) {
+        return false;
+    }
+
+    // The record being replaced is left behind; save() appends its successor
+    _entries = std::move(kept);
+    _activeBank = target;
+    _generation++;
+    _writePos = offset;
+    printf("[SnapshotStore] Compacted %zu snapshot(s) into bank %u, %lu sector erase(s) since boot\n",
+           _entries.size(), _activeBank, static_cast<unsigned long>(_flash.eraseCount()));
+    return true;
+}
+
+void SnapshotStore::retain(const std::vector<std::string>& insight_ids) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (std::find(insight_ids.begin(), insight_ids.end(), it->first) == insight_ids.end()) {
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t SnapshotStore::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "InsightSnapshot.h"
+#include "SnapshotFlash.h"
+
+/**
+ * @class SnapshotStore
+ * @brief Keeps the last InsightSnapshot of each insight in flash
+ *
+ * Lets insight cards show real data straight after boot, while the first
+ * fetch is still waiting for WiFi.
+ *
+ * The partition is split into two banks used as append-only logs:
+ * - Saving appends a record (insight ID + encoded snapshot + CRC) to the
+ *   active bank; the newest record of an insight wins
+ * - When the active bank is full, the newest record of every insight is
+ *   copied to the other bank, which is erased first, and the new bank's
+ *   header is written last; a power cut before that leaves the old bank in use
+ * - So every sector is erased once per pass over both banks
+ *
+ * A save is skipped when the data matches what is stored, or when the
+ * insight was already written less than MIN_REWRITE_INTERVAL ago.
+ * Records carry STORE_VERSION in the bank header and FORMAT_VERSION in
+ * the snapshot; a bank from another version is treated as empty.
+ *
+ * Safe to call from any task.
+ */
+class SnapshotStore {
+public:
+    static constexpr uint16_t STORE_VERSION = 1;                        ///< Bumped whenever the layout changes
+    static constexpr unsigned long MIN_REWRITE_INTERVAL = 15UL * 60 * 1000; ///< Per-insight write throttle
+    static constexpr size_t MAX_RECORD_SIZE = 2 * SnapshotFlash::SECTOR_SIZE; ///< Larger snapshots aren't stored; records may span sectors
+
+    /**
+     * @brief Constructor
+     * @param flash Partition to keep snapshots in
+     */
+    explicit SnapshotStore(SnapshotFlash& flash);
+
+    /**
+     * @brief Map the partition and index the stored snapshots
+     * @return false if the partition is missing; the store then stays empty
+     */
+    bool begin();
+
+    /**
+     * @brief Read the stored snapshot of an insight
+     * @param insight_id Insight to look up
+     * @param snapshot Receives the snapshot
+     * @return true if one was stored and decodes with the current format
+     */
+    bool load(const std::string& insight_id, InsightSnapshot& snapshot) const;
+
+    /**
+     * @brief Store an insight's latest snapshot
+     * @param insight_id Insight the snapshot belongs to
+     * @param snapshot Data to store
+     * @param now Current millis(), for the rewrite throttle
+     * @return true if it was written
+     */
+    bool save(const std::string& insight_id, const InsightSnapshot& snapshot, unsigned long now);
+
+    /**
+     * @brief Forget insights that no card shows
+     * @param insight_ids Insights to keep
+     *
+     * Their records are dropped at the next compaction.
+     */
+    void retain(const std::vector<std::string>& insight_ids);
+
+    /**
+     * @brief Number of stored insights
+     */
+    size_t size() const;
+
+private:
+    struct Entry {
+        size_t offset = 0;             ///< Record position in the partition
+        unsigned long written_ms = 0;  ///< When this boot last wrote it
+        bool written = false;          ///< Written since boot
+    };
+
+    bool readRecord(size_t offset, size_t limit, std::string* id, const uint8_t** payload,
+                    size_t* payload_size, size_t* record_size) const;
+    bool formatBank(uint8_t bank, uint32_t generation);
+    void scanBank();
+    bool compact(const std::string& skip_id);
+    bool append(const std::string& insight_id, const uint8_t* payload, size_t payload_size);
+    size_t bankBase(uint8_t bank) const { return bank * _bankSize; }
+
+    SnapshotFlash& _flash;
+    mutable std::mutex _mutex;         ///< std::mutex so the store also builds on host
+    std::map<std::string, Entry> _entries;
+    bool _ready;
+    size_t _bankSize;
+    uint8_t _activeBank;
+    uint32_t _generation;
+    size_t _writePos;                  ///< Where the next record goes
+};
@@ -1,48 +1,198 @@
 #include "InsightParser.h"
 #include <stdio.h>
+#include <string.h>
 #include <algorithm> // Add for std::min
+#include <memory>
 
 #ifdef ARDUINO
 #include <Arduino.h>
 #endif
 
+// Room for the largest filter, the funnel's, with a few slots to spare
+typedef StaticJsonDocument<32 * JSON_OBJECT_SIZE(1)> FilterDocument;
+
 // Filter to dramatically reduce memory usage by filtering out unused fields
-static StaticJsonDocument<256> createFilter() {
+static FilterDocument createFilter(InsightParser::InsightType type) {
+    FilterDocument filter;
+    InsightParser::addInsightFilter(filter[JSON_KEY_RESULTS][0].to<JsonObject>(), type);
+    return filter;
+}
+
+// Keeps only what prescan() reads
+static StaticJsonDocument<256> createPrescanFilter() {
     StaticJsonDocument<256> filter;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_NAME] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_RESULT] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_DISPLAY] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_CHART_SETTINGS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_TABLE_SETTINGS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_INSIGHT] = true; // <--- FIX: Used JSON_KEY_INSIGHT
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_EVENTS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_ACTIONS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL_UNIT] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_COMPARE] = true; // Filter for "compare" at the results[0] level
+    JsonObject insight = filter[JSON_KEY_RESULTS][0].to<JsonObject>();
+    insight[JSON_KEY_QUERY][JSON_KEY_DISPLAY] = true;
+    insight[JSON_KEY_FILTERS][JSON_KEY_INSIGHT] = true;
     return filter;
 }
 
-InsightParser::InsightParser(const char* json) : doc(65536), valid(false) { // DynamicJsonDocument will allocate 64KB
-    static StaticJsonDocument<256> filter = createFilter(); // Static filter for efficiency
+// Built once per type; deserialization only reads them
+static const FilterDocument& filterFor(InsightParser::InsightType type) {
+    static const FilterDocument general = createFilter(InsightParser::InsightType::INSIGHT_NOT_SUPPORTED);
+    static const FilterDocument numeric = createFilter(InsightParser::InsightType::NUMERIC_CARD);
+    static const FilterDocument series = createFilter(InsightParser::InsightType::LINE_GRAPH);
+    static const FilterDocument funnel = createFilter(InsightParser::InsightType::FUNNEL);
+
+    switch (type) {
+        case InsightParser::InsightType::NUMERIC_CARD: return numeric;
+        case InsightParser::InsightType::LINE_GRAPH:
+        case InsightParser::InsightType::AREA_CHART: return series;
+        case InsightParser::InsightType::FUNNEL: return funnel;
+        default: return general;
+    }
+}
+
+void InsightParser::addInsightFilter(JsonObject filter, InsightType filter_type) {
+    // Every type: what type detection and the card title need. query.display
+    // and filters.insight are kept so a parse can tell it used the wrong filter
+    filter[JSON_KEY_NAME] = true;
+    filter[JSON_KEY_QUERY][JSON_KEY_DISPLAY] = true;
+    filter[JSON_KEY_FILTERS][JSON_KEY_INSIGHT] = true; // <--- FIX: Used JSON_KEY_INSIGHT
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_ID] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_COMPLETE] = true;
+
+    bool general = filter_type == InsightType::INSIGHT_NOT_SUPPORTED;
+    bool series = filter_type == InsightType::LINE_GRAPH || filter_type == InsightType::AREA_CHART;
+    bool funnel = filter_type == InsightType::FUNNEL;
+    if (series) {
+        // One object per series. Rows, an array per point, don't match and
+        // are dropped; private_finishParse() then asks for the general filter
+        JsonObject item = filter[JSON_KEY_RESULT][0].to<JsonObject>();
+        item[JSON_KEY_DATA] = true;
+        item[JSON_KEY_DAYS] = true;
+        item[JSON_KEY_LABEL] = true;
+        item[JSON_KEY_COMPARE_LABEL] = true;
+        item[JSON_KEY_ACTION][JSON_KEY_NAME] = true;
+        item[JSON_KEY_ACTION][JSON_KEY_CUSTOM_NAME] = true;
+    } else if (funnel) {
+        // One object per step. Breakdowns, an array of steps each, are
+        // dropped the same way
+        JsonObject step = filter[JSON_KEY_RESULT][0].to<JsonObject>();
+        step[JSON_KEY_NAME] = true;
+        step[JSON_KEY_CUSTOM_NAME] = true;
+        step[JSON_KEY_COUNT] = true;
+        step[JSON_KEY_ORDER] = true;
+        step[JSON_KEY_BREAKDOWN] = true;
+        step[JSON_KEY_BREAKDOWN_VALUE] = true;
+        step[JSON_KEY_AVERAGE_CONVERSION_TIME] = true;
+        step[JSON_KEY_MEDIAN_CONVERSION_TIME] = true;
+        step[JSON_KEY_ACTION_ID] = true;
+    } else {
+        // Numeric cards come as objects or as HogQL rows, so keep either
+        filter[JSON_KEY_RESULT] = true;
+    }
+
+    if (general || filter_type == InsightType::NUMERIC_CARD) {
+        // Value formatting
+        filter[JSON_KEY_QUERY][JSON_KEY_CHART_SETTINGS] = true;
+        filter[JSON_KEY_QUERY][JSON_KEY_TABLE_SETTINGS] = true;
+    }
+    if (general || series) {
+        filter[JSON_KEY_COMPARE] = true; // Filter for "compare" at the results[0] level
+    }
+    if (general || funnel) {
+        // Step names before the funnel is calculated, and its window
+        filter[JSON_KEY_FILTERS][JSON_KEY_EVENTS] = true;
+        filter[JSON_KEY_FILTERS][JSON_KEY_ACTIONS] = true;
+        filter[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL] = true;
+        filter[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL_UNIT] = true;
+    }
+}
+
+InsightParser::InsightType InsightParser::prescan(const char* json) {
+    static StaticJsonDocument<256> filter = createPrescanFilter();
 
+    StaticJsonDocument<512> fields;
+    DeserializationError error = deserializeJson(fields, json, DeserializationOption::Filter(filter));
+    if (error) {
+        // The full parse will report it
+        return InsightType::INSIGHT_NOT_SUPPORTED;
+    }
+    return private_filterTypeOf(fields[JSON_KEY_RESULTS][0]);
+}
+
+InsightParser::InsightType InsightParser::private_filterTypeOf(JsonObjectConst insight) {
+    const char* insightType = insight[JSON_KEY_FILTERS][JSON_KEY_INSIGHT];
+    if (insightType && strcmp(insightType, JSON_VAL_INSIGHT_FUNNELS) == 0) {
+        return InsightType::FUNNEL;
+    }
+
+    const char* displayType = insight[JSON_KEY_QUERY][JSON_KEY_DISPLAY];
+    if (!displayType) {
+        // Numeric cards can also be told apart by their result; that needs the general filter
+        return InsightType::INSIGHT_NOT_SUPPORTED;
+    }
+    if (strcmp(displayType, JSON_VAL_DISPLAY_BOLD_NUMBER) == 0) {
+        return InsightType::NUMERIC_CARD;
+    }
+    if (strcmp(displayType, JSON_VAL_DISPLAY_ACTIONS_LINE_GRAPH) == 0 ||
+        strcmp(displayType, JSON_VAL_DISPLAY_ACTIONS_AREA_GRAPH) == 0) {
+        return InsightType::LINE_GRAPH;
+    }
+    return InsightType::INSIGHT_NOT_SUPPORTED;
+}
+
+static void logParseMemory(size_t capacity) {
 #ifdef ARDUINO
     if (psramFound()) {
         size_t psramSize = ESP.getPsramSize();
         size_t psramFree = ESP.getFreePsram();
-        Serial.printf("PSRAM available: %zu bytes, free: %zu bytes\n", psramSize, psramFree);
+        Serial.printf("PSRAM available: %zu bytes, free: %zu bytes, document: %zu bytes\n", psramSize, psramFree, capacity);
 
-        if (psramFree < 65536) {
-            Serial.println("Warning: Less than 64KB PSRAM free, parsing may fail");
+        if (psramFree < capacity) {
+            Serial.println("Warning: Less PSRAM free than the document needs, parsing may fail");
         }
     } else {
         Serial.println("Warning: PSRAM not found, using SRAM for JSON parsing");
     }
 #endif
+}
 
-    DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(filter));
+InsightParser::InsightParser(const char* json) : InsightParser(json, prescan(json)) {
+    if (m_filterMismatch) {
+        // Rows or breakdowns the pre-scan can't see; a string can be read again
+        m_filterMismatch = false;
+        private_finishParse(deserializeJson(doc, json, DeserializationOption::Filter(filterFor(InsightType::INSIGHT_NOT_SUPPORTED))),
+                            InsightType::INSIGHT_NOT_SUPPORTED);
+    }
+}
+
+InsightParser::InsightParser(const char* json, InsightType filter_type)
+    : doc(DEFAULT_CAPACITY), valid(false), m_outOfMemory(false), m_filterMismatch(false)
+    , m_filterType(InsightType::INSIGHT_NOT_SUPPORTED), m_pendingQueryId{} {
+    logParseMemory(doc.capacity());
+    private_finishParse(deserializeJson(doc, json, DeserializationOption::Filter(filterFor(filter_type))), filter_type);
+}
+
+#ifdef ARDUINO
+InsightParser::InsightParser(Stream& input, size_t capacity, InsightType filter_type)
+    : doc(capacity), valid(false), m_outOfMemory(false), m_filterMismatch(false)
+    , m_filterType(InsightType::INSIGHT_NOT_SUPPORTED), m_pendingQueryId{} {
+    logParseMemory(doc.capacity());
+    // Pulls bytes from the stream as it parses; the filter drops everything
+    // the renderers don't use before it reaches the document
+    private_finishParse(deserializeJson(doc, input, DeserializationOption::Filter(filterFor(filter_type))), filter_type);
+}
+#endif
+
+InsightParser::InsightParser(JsonObjectConst insight)
+    : doc(ParserArena::slabSize(insight.memoryUsage() + JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(1) + 256))
+    , valid(false), m_outOfMemory(false), m_filterMismatch(false)
+    , m_filterType(InsightType::INSIGHT_NOT_SUPPORTED), m_pendingQueryId{} {
+    // Same layout as a single insight response, so every getter works unchanged
+    if (!doc.createNestedArray(JSON_KEY_RESULTS).add(insight)) {
+        printf("Insight of %zu bytes doesn't fit its document\n", insight.memoryUsage());
+        m_outOfMemory = true;
+        return;
+    }
+    private_finishParse(DeserializationError::Ok, InsightType::INSIGHT_NOT_SUPPORTED);
+}
+
+void InsightParser::private_finishParse(DeserializationError error, InsightType filter_type) {
     if (error) {
         printf("JSON Deserialization failed: %s\n", error.c_str());
+        m_outOfMemory = error == DeserializationError::NoMemory;
         return;
     }
 
@@ -76,6 +226,42 @@ InsightParser::InsightParser(const char* json) : doc(65536), valid(false) { // D
     }
     // --- End m_insightDataRoot initialization and validation ---
 
+    // An async refresh reports the calculation it started. Take it out of the
+    // document so it doesn't reach contentHash(): the ID differs every time
+    JsonObject insight = doc[JSON_KEY_RESULTS][0];
+    JsonObject queryStatus = insight[JSON_KEY_QUERY_STATUS];
+    if (!queryStatus.isNull()) {
+        const char* queryId = queryStatus[JSON_KEY_ID];
+        if (!queryStatus[JSON_KEY_COMPLETE].as<bool>() && queryId) {
+            strncpy(m_pendingQueryId, queryId, sizeof(m_pendingQueryId) - 1);
+        }
+        insight.remove(JSON_KEY_QUERY_STATUS);
+    }
+
+    // A type-specific filter may have dropped fields this insight needs,
+    // e.g. when it was changed to another type since its last parse
+    m_filterType = private_filterTypeOf(firstInsightObject);
+    if (filter_type != InsightType::INSIGHT_NOT_SUPPORTED && filter_type != m_filterType) {
+        printf("Insight is no longer of the type its filter was chosen for\n");
+        m_filterMismatch = true;
+        return;
+    }
+
+    // Typed series and funnel filters only keep objects in result. Rows
+    // and breakdowns come out null under them, so those insights stay on
+    // the general filter
+    if (m_filterType == InsightType::LINE_GRAPH || m_filterType == InsightType::FUNNEL) {
+        JsonArrayConst result = firstInsightObject[JSON_KEY_RESULT];
+        if (result.size() > 0 && !result[0].is<JsonObjectConst>()) {
+            m_filterType = InsightType::INSIGHT_NOT_SUPPORTED;
+            if (filter_type != InsightType::INSIGHT_NOT_SUPPORTED) {
+                printf("Insight result is not a list of objects, which its filter needs\n");
+                m_filterMismatch = true;
+                return;
+            }
+        }
+    }
+
     valid = true; // If we reached here, parsing and initial structure validation passed.
 }
 
@@ -198,7 +384,14 @@ bool InsightParser::private_hasLineGraphStructure() const {
     // - results array exists
     // - first result has result array with multiple points
     JsonArrayConst timeseriesData = firstResult[JSON_KEY_RESULT];
-    if (timeseriesData.isNull() || timeseriesData.size() <= 1) return false; // Needs at least 2 points for a line graph
+    if (timeseriesData.isNull()) return false;
+
+    // Legacy trends: one object per series, each with its own data and days
+    JsonObjectConst firstSeries = timeseriesData[0];
+    if (!firstSeries.isNull()) {
+        return firstSeries[JSON_KEY_DATA].size() > 1;
+    }
+    if (timeseriesData.size() <= 1) return false; // Needs at least 2 points for a line graph
 
     // Additional check: verify it's explicitly a line graph if display type is present
     const char* displayType = firstResult[JSON_KEY_QUERY][JSON_KEY_DISPLAY];
@@ -206,9 +399,9 @@ bool InsightParser::private_hasLineGraphStructure() const {
         return true;
     }
     
-    // Check first data point has expected time series structure [date_string, numeric_value]
+    // Check first data point has expected time series structure [date_string, numeric_value, ...]
     JsonArrayConst firstPoint = timeseriesData[0];
-    if (firstPoint.isNull() || firstPoint.size() != 2) return false;
+    if (firstPoint.isNull() || firstPoint.size() < 2) return false;
     
     // Time series first element should be a date string
     const char* dateStr = firstPoint[0];
@@ -256,6 +449,70 @@ bool InsightParser::private_hasAreaChartStructure() const {
     return false;
 }
 
+bool InsightParser::hasEmptyResult() const {
+    if (!valid) {
+        return false;
+    }
+
+    JsonVariantConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+    return result.isNull() || (result.is<JsonArrayConst>() && result.size() == 0);
+}
+
+size_t InsightParser::estimateCapacity(long content_length, bool compressed, size_t previous_peak, size_t fallback) {
+    size_t estimate = fallback;
+    if (previous_peak > 0) {
+        // The last parse of this insight is the best guess; leave it room to grow
+        estimate = previous_peak + previous_peak / 4;
+    } else if (content_length > 0) {
+        // Before the first parse, go by the body. The filter drops most of
+        // it, but what's left is mostly numbers: a 16-byte slot each for a
+        // few bytes of JSON text. Gzip hides a further 5-10x
+        estimate = std::min(static_cast<size_t>(content_length) * (compressed ? 16 : 2), fallback);
+    }
+    estimate = std::min(std::max(estimate, ParserArena::MIN_SLAB), ParserArena::MAX_SLAB);
+    // Use the whole slab the document will get anyway
+    return ParserArena::slabSize(estimate);
+}
+
+bool InsightParser::getPendingQuery(char* buffer, size_t bufferSize) const {
+    if (!valid || bufferSize == 0 || m_pendingQueryId[0] == '\0') {
+        return false;
+    }
+
+    strncpy(buffer, m_pendingQueryId, bufferSize - 1);
+    buffer[bufferSize - 1] = '\0';
+    return true;
+}
+
+namespace {
+// ArduinoJson writer that hashes output instead of storing it
+struct Fnv1aWriter {
+    uint32_t hash = 2166136261u;
+
+    size_t write(uint8_t c) {
+        hash = (hash ^ c) * 16777619u;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            write(buffer[i]);
+        }
+        return length;
+    }
+};
+}
+
+uint32_t InsightParser::contentHash() const {
+    if (!valid) {
+        return 0;
+    }
+
+    Fnv1aWriter writer;
+    serializeJson(doc, writer);
+    return writer.hash;
+}
+
 // Renamed from detectInsightType, added const
 InsightParser::InsightType InsightParser::getInsightType() const {
     if (!valid) return InsightType::INSIGHT_NOT_SUPPORTED;
@@ -346,31 +603,81 @@ bool InsightParser::private_hasFunnelNestedStructure() const {
     return false; // For flat structure, result[0] is typically an object directly.
 }
 
+bool InsightParser::private_hasSeriesObjects() const {
+    JsonVariantConst first = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT][0];
+    return first.is<JsonObjectConst>();
+}
+
+size_t InsightParser::getSeriesCount() const {
+    if (!valid || !private_hasLineGraphStructure()) return 0;
+
+    JsonArrayConst timeseriesData = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+    if (private_hasSeriesObjects()) {
+        return timeseriesData.size();
+    }
+    // [date_string, value_0, value_1, ...]: one column per series
+    size_t columns = timeseriesData[0].size();
+    return columns > 1 ? columns - 1 : 0;
+}
+
 size_t InsightParser::getSeriesPointCount() const {
     if (!valid || !private_hasLineGraphStructure()) return 0;
     
     // Use m_insightDataRoot
     JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
     JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
+    if (private_hasSeriesObjects()) {
+        // Every series shares the first one's x axis
+        return timeseriesData[0][JSON_KEY_DATA].size();
+    }
     return timeseriesData.size();
 }
 
-bool InsightParser::getSeriesYValues(double* yValues) const {
+bool InsightParser::getSeriesYValues(double* yValues, size_t series) const {
     if (!valid || !private_hasLineGraphStructure() || !yValues) return false;
+    if (series >= getSeriesCount()) return false;
     
     // Use m_insightDataRoot
     JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
     JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
-    size_t pointCount = timeseriesData.size();
+    size_t pointCount = getSeriesPointCount();
+    
+    if (private_hasSeriesObjects()) {
+        JsonArrayConst data = timeseriesData[series][JSON_KEY_DATA];
+        for (size_t i = 0; i < pointCount; i++) {
+            yValues[i] = data[i].as<double>(); // 0 past the end of a shorter series
+        }
+        return true;
+    }
     
-    // Extract y-values directly - format is consistent with [date_string, numeric_value]
+    // Extract y-values directly - format is consistent with [date_string, numeric_value, ...]
     for (size_t i = 0; i < pointCount; i++) {
-        yValues[i] = timeseriesData[i][1].as<double>();
+        yValues[i] = timeseriesData[i][series + 1].as<double>();
     }
     
     return true;
 }
 
+bool InsightParser::getSeriesName(size_t series, char* buffer, size_t bufferSize) const {
+    if (!valid || !private_hasSeriesObjects() || !buffer || bufferSize == 0) return false;
+    if (series >= getSeriesCount()) return false;
+
+    // Rows of a single query carry no series names
+    const char* label = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT][series][JSON_KEY_LABEL];
+    if (!label) return false;
+
+    strncpy(buffer, label, bufferSize - 1);
+    buffer[bufferSize - 1] = '\0';
+    return true;
+}
+
+bool InsightParser::isPreviousPeriodSeries(size_t series) const {
+    if (!valid || !private_hasSeriesObjects() || series >= getSeriesCount()) return false;
+
+    const char* compareLabel = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT][series][JSON_KEY_COMPARE_LABEL];
+    return compareLabel && strcmp(compareLabel, JSON_VAL_COMPARE_PREVIOUS) == 0;
+}
+
 bool InsightParser::getSeriesXLabel(size_t index, char* buffer, size_t bufferSize) const {
     if (!valid || !private_hasLineGraphStructure() || !buffer || bufferSize == 0) return false;
     
@@ -378,9 +685,15 @@ bool InsightParser::getSeriesXLabel(size_t index, char* buffer, size_t bufferSiz
     JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
     JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
     
-    if (index >= timeseriesData.size()) return false;
-    
-    const char* dateStr = timeseriesData[index][0];
+    const char* dateStr = nullptr;
+    if (private_hasSeriesObjects()) {
+        JsonArrayConst days = timeseriesData[0][JSON_KEY_DAYS];
+        if (index >= days.size()) return false;
+        dateStr = days[index];
+    } else {
+        if (index >= timeseriesData.size()) return false;
+        dateStr = timeseriesData[index][0];
+    }
     if (!dateStr) return false;
     
     // Copy just the year and month (YYYY-MM) to keep labels compact
@@ -395,29 +708,28 @@ bool InsightParser::getSeriesXLabel(size_t index, char* buffer, size_t bufferSiz
 }
 
 void InsightParser::getSeriesRange(double* minValue, double* maxValue) const {
+    if (minValue) *minValue = 0.0;
+    if (maxValue) *maxValue = 0.0;
     if (!valid || !private_hasLineGraphStructure() || !minValue || !maxValue) {
-        if (minValue) *minValue = 0.0;
-        if (maxValue) *maxValue = 0.0;
         return;
     }
     
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
-    
-    if (timeseriesData.size() == 0) {
-        *minValue = 0.0;
-        *maxValue = 0.0;
+    size_t seriesCount = getSeriesCount();
+    size_t pointCount = getSeriesPointCount();
+    if (seriesCount == 0 || pointCount == 0) {
         return;
     }
 
-    *minValue = timeseriesData[0][1].as<double>();
-    *maxValue = *minValue;
-    
-    for (size_t i = 1; i < timeseriesData.size(); i++) {
-        double value = timeseriesData[i][1].as<double>();
-        if (value < *minValue) *minValue = value;
-        if (value > *maxValue) *maxValue = value;
+    // Across every series, as they share the y axis
+    std::unique_ptr<double[]> values(new double[pointCount]);
+    bool first = true;
+    for (size_t series = 0; series < seriesCount; series++) {
+        getSeriesYValues(values.get(), series);
+        for (size_t i = 0; i < pointCount; i++) {
+            if (first || values[i] < *minValue) *minValue = values[i];
+            if (first || values[i] > *maxValue) *maxValue = values[i];
+            first = false;
+        }
     }
 }
 
@@ -5,6 +5,13 @@
 // e.g., in platformio.ini: build_flags = -DARDUINOJSON_USE_PSRAM
 #define ARDUINOJSON_DEFAULT_NESTING_LIMIT 50
 #include <ArduinoJson.h>
+#include "ParserArena.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+struct InsightSnapshot;
 
 // REMOVED: #define MAX_BREAKDOWNS 5 // This constant is likely defined elsewhere (e.g., InsightCard.h) using static constexpr
 
@@ -21,12 +28,16 @@
  * 
  * Features:
  * - Memory-efficient JSON parsing using ArduinoJson (leveraging PSRAM if enabled)
+ * - Filters that keep only the fields the insight's type renders
+ * - Documents sized per response and leased from a reusable ParserArena slab
  * - Centralized data access for robustness against minor JSON structure variations
  * - Automatic insight type detection
  * - Comprehensive funnel analysis
  */
 class InsightParser {
 public:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;  ///< Document size when nothing better is known
+
     /**
      * @enum InsightType
      * @brief Supported visualization types for insights
@@ -45,10 +56,73 @@ public:
      * 
      * Initializes parser with JSON data and attempts to allocate memory.
      * On ESP32 platforms, will attempt to use PSRAM if available (requires ARDUINOJSON_USE_PSRAM build flag).
-     * Uses isValid() to check if parsing was successful.
+     * Reads the insight's type with prescan() first, then parses with that
+     * type's filter, or again with the general filter if that one didn't
+     * fit. Uses isValid() to check if parsing was successful.
      */
     InsightParser(const char* json);
 
+    /**
+     * @brief Constructor - parses JSON data with a given type's filter
+     * @param json Raw JSON string to parse
+     * @param filter_type Type whose fields to keep, or INSIGHT_NOT_SUPPORTED for every field any type uses
+     * 
+     * Skips the pre-scan. If the insight turns out to be of another type,
+     * or its result holds rows or breakdowns the type's filter drops, the
+     * parse fails and filterMismatch() is set.
+     */
+    InsightParser(const char* json, InsightType filter_type);
+
+#ifdef ARDUINO
+    /**
+     * @brief Constructor - parses JSON straight from a stream
+     * @param input Stream positioned at the start of the JSON body
+     * @param capacity Document size, e.g. from estimateCapacity()
+     * @param filter_type Type whose fields to keep, e.g. the filterType() of
+     *        the insight's last parse; INSIGHT_NOT_SUPPORTED keeps every field any type uses
+     * 
+     * Deserializes through a filter as bytes arrive, so the raw payload is
+     * never held in memory; only the filtered document is. A stream can't
+     * be pre-scanned, so the type comes from the caller.
+     * Use isValid() to check if parsing was successful, outOfMemory()
+     * to tell whether a larger document would have helped, and
+     * filterMismatch() whether the general filter would have.
+     */
+    explicit InsightParser(Stream& input, size_t capacity = DEFAULT_CAPACITY,
+                           InsightType filter_type = InsightType::INSIGHT_NOT_SUPPORTED);
+#endif
+
+    /**
+     * @brief Constructor - copies one insight out of a larger document
+     * @param insight Insight object, e.g. a dashboard tile's "insight"
+     * 
+     * The document is sized to the insight, and laid out like a single
+     * insight response, so the getters work as with the other constructors.
+     * The source document can be freed afterwards.
+     * Use isValid() to check if the copy was successful.
+     */
+    explicit InsightParser(JsonObjectConst insight);
+
+    /**
+     * @brief Add the fields the parser uses to a deserialization filter
+     * @param filter Filter object that matches one insight
+     * @param filter_type Type whose fields to keep; INSIGHT_NOT_SUPPORTED keeps every field any type uses
+     * 
+     * Lets a response that nests insights, like a dashboard, be filtered
+     * down to the same fields as a single insight response.
+     */
+    static void addInsightFilter(JsonObject filter, InsightType filter_type = InsightType::INSIGHT_NOT_SUPPORTED);
+
+    /**
+     * @brief Read an insight's type from a tiny first pass over the JSON
+     * @param json Raw JSON string
+     * @return Type whose filter fits the insight, or INSIGHT_NOT_SUPPORTED if it can't tell
+     * 
+     * Keeps only query.display and filters.insight, so it needs a few
+     * hundred bytes of document whatever the payload size.
+     */
+    static InsightType prescan(const char* json);
+
     /**
      * @brief Default destructor
      */
@@ -91,24 +165,52 @@ public:
      */
     bool getNumericFormattingSuffix(char* buffer, size_t bufferSize) const;
     
+    /**
+     * @brief Get number of series in a line graph
+     * @return Number of series or 0 if not a line graph
+     * 
+     * Trends with several events, breakdowns or compare-to-previous have
+     * one series each. Legacy results hold one object per series; query
+     * results hold one value column per series after the date.
+     */
+    size_t getSeriesCount() const;
+
     /**
      * @brief Get number of data points in line graph series
      * @return Number of points or 0 if not a line graph
      * 
      * Returns the number of time series data points for line graphs.
-     * Should only be called if getInsightType() returns LINE_GRAPH.
+     * Every series shares the first one's x axis and point count.
+     * Should only be called if getInsightType() returns LINE_GRAPH or AREA_CHART.
      */
     size_t getSeriesPointCount() const;
 
     /**
      * @brief Get Y-values for line graph series
      * @param yValues Array to fill with Y-values (must be pre-allocated)
+     * @param series Series index, below getSeriesCount()
      * @return true if values were retrieved successfully
      * 
      * Populates the provided array with Y-values from the time series.
-     * Array size must match getSeriesPointCount().
+     * Array size must match getSeriesPointCount(); a shorter series is padded with 0.
+     */
+    bool getSeriesYValues(double* yValues, size_t series = 0) const;
+
+    /**
+     * @brief Get the legend label of a series
+     * @param series Series index
+     * @param buffer Buffer to store the label
+     * @param bufferSize Size of buffer
+     * @return true if the series has a label; query results have none
+     */
+    bool getSeriesName(size_t series, char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Check whether a series is the previous period of a comparison
+     * @param series Series index
+     * @return true for the "previous" half of a compare-to-previous trend
      */
-    bool getSeriesYValues(double* yValues) const;
+    bool isPreviousPeriodSeries(size_t series) const;
 
     /**
      * @brief Get X-axis label for a data point
@@ -127,7 +229,7 @@ public:
      * @param minValue Pointer to store minimum value
      * @param maxValue Pointer to store maximum value
      * 
-     * Calculates the min/max Y values across all data points.
+     * Calculates the min/max Y values across all data points of every series.
      * Useful for scaling visualizations appropriately.
      */
     void getSeriesRange(double* minValue, double* maxValue) const;
@@ -141,6 +243,50 @@ public:
      */
     bool isValid() const;
 
+    /**
+     * @brief Check if the document was too small for the response
+     * @return true if parsing failed for lack of document memory
+     */
+    bool outOfMemory() const { return m_outOfMemory; }
+
+    /**
+     * @brief Check if the insight isn't of the type whose filter was used
+     * @return true if parsing failed because the filter dropped fields the insight's real type needs
+     */
+    bool filterMismatch() const { return m_filterMismatch; }
+
+    /**
+     * @brief Type whose filter fits this insight
+     * @return A filter type to pass to the next parse of the same insight;
+     *         INSIGHT_NOT_SUPPORTED for a trend of rows or a funnel with breakdowns
+     */
+    InsightType filterType() const { return m_filterType; }
+
+    /**
+     * @brief Bytes of the document the parse used
+     * 
+     * Nothing is freed from a document, so this is also its peak use.
+     */
+    size_t memoryUsed() const { return doc.memoryUsage(); }
+
+    /**
+     * @brief Size of the document leased from ParserArena
+     */
+    size_t memoryCapacity() const { return doc.capacity(); }
+
+    /**
+     * @brief Choose a document size for a response
+     * 
+     * @param content_length Content-Length of the body, or -1 if unknown (chunked)
+     * @param compressed Whether the body is gzip-encoded
+     * @param previous_peak memoryUsed() of the last parse of the same insight, or 0
+     * @param fallback Size to use when neither hint is available, and the
+     *        most the body size alone may ask for
+     * @return A ParserArena slab size between MIN_SLAB and MAX_SLAB
+     */
+    static size_t estimateCapacity(long content_length, bool compressed, size_t previous_peak,
+                                   size_t fallback = DEFAULT_CAPACITY);
+
     /**
      * @brief Determine visualization type from JSON structure
      * @return Detected InsightType
@@ -149,6 +295,36 @@ public:
      * Should be called before using type-specific methods.
      */
     InsightType getInsightType() const;
+
+    /**
+     * @brief Check if PostHog returned the insight without computed results
+     * @return true if the first insight's "result" is null or an empty array
+     * 
+     * A cached fetch reports this when the insight has not been calculated
+     * yet, meaning a blocking refresh is needed to get data.
+     */
+    bool hasEmptyResult() const;
+
+    /**
+     * @brief Get the ID of the calculation an async refresh started
+     * @param buffer Buffer to store the query ID
+     * @param bufferSize Size of the buffer
+     * @return true if the response reported a query that hasn't completed yet
+     * 
+     * Its status can be polled at /query/{id}/; the insight has a result
+     * once the query completes.
+     */
+    bool getPendingQuery(char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Hash the filtered insight document
+     * @return 32-bit FNV-1a hash of the document as serialized JSON, or 0 if invalid
+     * 
+     * Only fields kept by the parse filter contribute, so two responses with
+     * the same hash render identically. Used to detect unchanged refreshes
+     * when the server sends no ETag.
+     */
+    uint32_t contentHash() const;
     
     // Funnel-specific public methods
     
@@ -298,14 +474,28 @@ public:
     bool getFunnelTimeWindow(uint32_t* window_days) const;
 
 private:
-    DynamicJsonDocument doc;              ///< JSON document for parsing (allocated on heap/PSRAM)
+    // Extracts everything in one walk of the document instead of through the getters
+    friend struct InsightSnapshot;
+
+    ArenaJsonDocument doc;              ///< JSON document for parsing, leased from ParserArena
     bool valid;                         ///< Parsing status flag
+    bool m_outOfMemory;                 ///< The document was too small
+    bool m_filterMismatch;              ///< The filter was for another type of insight
+    InsightType m_filterType;           ///< Type whose filter fits the insight
     JsonObjectConst m_insightDataRoot;  ///< Points to the JsonObject containing the main "results" array
+    char m_pendingQueryId[64];          ///< Query an async refresh started, or empty
+
+    // Validates the parsed document and sets m_insightDataRoot
+    void private_finishParse(DeserializationError error, InsightType filter_type);
+
+    // Maps the fields prescan() reads to the type whose filter fits
+    static InsightType private_filterTypeOf(JsonObjectConst insight);
 
     // Private helper methods for insight type detection
     bool private_hasNumericCardStructure() const;
     bool private_hasLineGraphStructure() const;
     bool private_hasAreaChartStructure() const;
+    bool private_hasSeriesObjects() const;
     bool private_hasFunnelStructure() const;
     bool private_hasFunnelResultData() const;
     bool private_hasFunnelNestedStructure() const;
@@ -324,6 +514,10 @@ static const char* JSON_KEY_QUERY = "query";
 static const char* JSON_KEY_FILTERS = "filters";
 static const char* JSON_KEY_INSIGHT = "insight"; // <--- ADDED THIS LINE
 static const char* JSON_KEY_COMPARE = "compare";
+static const char* JSON_KEY_COMPARE_LABEL = "compare_label";
+static const char* JSON_KEY_DATA = "data";
+static const char* JSON_KEY_DAYS = "days";
+static const char* JSON_KEY_LABEL = "label";
 static const char* JSON_KEY_DISPLAY = "display";
 static const char* JSON_KEY_CHART_SETTINGS = "chartSettings";
 static const char* JSON_KEY_TABLE_SETTINGS = "tableSettings";
@@ -347,12 +541,18 @@ static const char* JSON_KEY_EVENTS = "events";
 static const char* JSON_KEY_ACTIONS = "actions";
 static const char* JSON_KEY_ID = "id";
 static const char* JSON_KEY_ACTION_ID = "action_id"; 
+static const char* JSON_KEY_ACTION = "action";
+static const char* JSON_KEY_QUERY_STATUS = "query_status";
+static const char* JSON_KEY_COMPLETE = "complete";
+static const char* JSON_KEY_SHORT_ID = "short_id";
+static const char* JSON_KEY_TILES = "tiles";
 
 // Define common JSON values as constants
 static const char* JSON_VAL_INSIGHT_FUNNELS = "FUNNELS";
 static const char* JSON_VAL_DISPLAY_BOLD_NUMBER = "BoldNumber";
 static const char* JSON_VAL_DISPLAY_ACTIONS_LINE_GRAPH = "ActionsLineGraph";
 static const char* JSON_VAL_DISPLAY_ACTIONS_AREA_GRAPH = "ActionsAreaGraph"; // Assumed display type for area charts
+static const char* JSON_VAL_COMPARE_PREVIOUS = "previous";
 static const char* JSON_VAL_FUNNEL_UNIT_DAY = "day";
 static const char* JSON_VAL_FUNNEL_UNIT_WEEK = "week";
 static const char* JSON_VAL_FUNNEL_UNIT_MONTH = "month";
@@ -0,0 +1,154 @@
+#include "ParserArena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef ARDUINO
+#include "esp_heap_caps.h"
+#endif
+
+namespace {
+// Each block starts with the class it was leased from, so release() knows
+// where it goes; the header keeps the payload 8-byte aligned
+struct SlabHeader {
+    uint32_t slab_class;
+    uint32_t size;
+};
+static_assert(sizeof(SlabHeader) == 8, "SlabHeader layout");
+
+constexpr uint32_t UNPOOLED = 0xFFFFFFFF;
+
+void* allocateSlab(size_t size) {
+#ifdef ARDUINO
+    // Plenty of PSRAM, little internal RAM
+    void* slab = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (slab) {
+        return slab;
+    }
+#endif
+    return malloc(size);
+}
+
+SlabHeader* headerOf(void* block) {
+    return static_cast<SlabHeader*>(block) - 1;
+}
+}
+
+ParserArena& ParserArena::instance() {
+    static ParserArena arena;
+    return arena;
+}
+
+size_t ParserArena::classOf(size_t size) {
+    size_t slab = MIN_SLAB;
+    size_t index = 0;
+    while (slab < size && index < CLASS_COUNT) {
+        slab *= 2;
+        index++;
+    }
+    return index;
+}
+
+size_t ParserArena::slabSize(size_t size) {
+    size_t index = classOf(size);
+    return index < CLASS_COUNT ? MIN_SLAB << index : size;
+}
+
+void* ParserArena::acquire(size_t size) {
+    size_t index = classOf(size);
+    if (index >= CLASS_COUNT) {
+        // Too big to be worth keeping around
+        SlabHeader* header = static_cast<SlabHeader*>(allocateSlab(sizeof(SlabHeader) + size));
+        if (!header) {
+            return nullptr;
+        }
+        *header = {UNPOOLED, static_cast<uint32_t>(size)};
+        return header + 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_idle[index].empty()) {
+            void* block = _idle[index].back();
+            _idle[index].pop_back();
+            _leased[index]++;
+            _reuses++;
+            return block;
+        }
+    }
+
+    size_t slab = MIN_SLAB << index;
+    SlabHeader* header = static_cast<SlabHeader*>(allocateSlab(sizeof(SlabHeader) + slab));
+    if (!header) {
+        printf("[ParserArena] No memory for a %zu byte slab\n", slab);
+        return nullptr;
+    }
+    *header = {static_cast<uint32_t>(index), static_cast<uint32_t>(slab)};
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _leased[index]++;
+    _allocations++;
+    return header + 1;
+}
+
+void ParserArena::release(void* block) {
+    if (!block) {
+        return;
+    }
+    SlabHeader* header = headerOf(block);
+    if (header->slab_class == UNPOOLED) {
+        free(header);
+        return;
+    }
+
+    size_t index = header->slab_class;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _leased[index]--;
+        if (_idle[index].size() < MAX_IDLE) {
+            _idle[index].push_back(block);
+            return;
+        }
+    }
+    free(header);
+}
+
+void* ParserArena::resize(void* block, size_t size) {
+    if (!block) {
+        return acquire(size);
+    }
+    SlabHeader* header = headerOf(block);
+    // Shrinking within the slab, or to a class the slab already covers, is free
+    if (header->slab_class != UNPOOLED && size <= header->size && slabSize(size) == header->size) {
+        return block;
+    }
+
+    void* moved = acquire(size);
+    if (!moved) {
+        return nullptr;
+    }
+    memcpy(moved, block, size < header->size ? size : header->size);
+    release(block);
+    return moved;
+}
+
+void ParserArena::writeStats(JsonObject out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t leased = 0;
+    size_t idle = 0;
+    size_t reserved = 0;
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        leased += _leased[i];
+        idle += _idle[i].size();
+        reserved += (_leased[i] + _idle[i].size()) * (MIN_SLAB << i);
+    }
+    out["leased_slabs"] = leased;
+    out["idle_slabs"] = idle;
+    out["reserved_bytes"] = reserved;
+    out["allocations"] = _allocations;
+    out["reuses"] = _reuses;
+#ifdef ARDUINO
+    // A largest block close to the free total means PSRAM isn't fragmenting
+    out["psram_free"] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    out["psram_largest_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+#endif
+}
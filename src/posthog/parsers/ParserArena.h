@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include <ArduinoJson.h>
+
+/**
+ * @class ParserArena
+ * @brief Pool of reusable memory slabs for parse documents and inflate windows
+ *
+ * Every parse used to allocate a fresh 64 KB document and free it again,
+ * so each refresh cycle churned large blocks through PSRAM. Documents now
+ * come from a few power-of-two size classes (4 KB to 256 KB). A released
+ * slab is kept for the next document of its class instead of being freed,
+ * so after the first refreshes the same blocks are handed out again and the
+ * heap stops fragmenting. Inflater leases its 32 KB window here for the
+ * same reason.
+ *
+ * Slabs live in PSRAM when there is some. Requests larger than the biggest
+ * class are allocated and freed directly.
+ *
+ * Thread-safe; parses run on every connection's worker task.
+ */
+class ParserArena {
+public:
+    static constexpr size_t MIN_SLAB = 4096;       ///< Smallest size class
+    static constexpr size_t MAX_SLAB = 262144;     ///< Largest size class
+    static constexpr size_t CLASS_COUNT = 7;       ///< Classes from MIN_SLAB to MAX_SLAB
+    static constexpr size_t MAX_IDLE = 3;          ///< Idle slabs kept per class; the rest are freed
+
+    /**
+     * @brief The arena shared by every parser
+     */
+    static ParserArena& instance();
+
+    /**
+     * @brief Lease a block of at least size bytes
+     * @return The block, or nullptr if memory ran out
+     */
+    void* acquire(size_t size);
+
+    /**
+     * @brief Return a block from acquire(), keeping it for reuse
+     */
+    void release(void* block);
+
+    /**
+     * @brief Resize a leased block, moving it to another class if needed
+     * @return The block, or nullptr if memory ran out; the old block is then still leased
+     */
+    void* resize(void* block, size_t size);
+
+    /**
+     * @brief Size of the class a request of size bytes is served from
+     * @return Class size, or size itself above MAX_SLAB
+     */
+    static size_t slabSize(size_t size);
+
+    /**
+     * @brief Report slab counts, reuse and PSRAM fragmentation
+     * @param out JSON object to fill, e.g. the "parser_arena" section of /api/status
+     */
+    void writeStats(JsonObject out) const;
+
+private:
+    ParserArena() = default;
+    ParserArena(const ParserArena&) = delete;
+    ParserArena& operator=(const ParserArena&) = delete;
+
+    static size_t classOf(size_t size);
+
+    mutable std::mutex _mutex;
+    std::vector<void*> _idle[CLASS_COUNT];   ///< Released slabs waiting for reuse, per class
+    size_t _leased[CLASS_COUNT] = {};        ///< Slabs handed out, per class
+    uint32_t _allocations = 0;               ///< Slabs taken from the heap
+    uint32_t _reuses = 0;                    ///< Leases served from an idle slab
+};
+
+/**
+ * @struct ArenaAllocator
+ * @brief ArduinoJson allocator drawing from ParserArena
+ */
+struct ArenaAllocator {
+    void* allocate(size_t size) { return ParserArena::instance().acquire(size); }
+    void deallocate(void* block) { ParserArena::instance().release(block); }
+    void* reallocate(void* block, size_t size) { return ParserArena::instance().resize(block, size); }
+};
+
+/**
+ * @brief JSON document whose memory is leased from ParserArena
+ */
+using ArenaJsonDocument = BasicJsonDocument<ArenaAllocator>;
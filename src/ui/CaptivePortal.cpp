@@ -4,6 +4,10 @@
 #include "EventQueue.h"
 #include "OtaManager.h" // Required for OtaManager interaction
 #include "ui/CardController.h" // Required for CardController interaction
+#include "posthog/PostHogClient.h" // For fetch statistics
+#include "net/SecureClient.h" // For TLS handshake statistics
+#include "net/GzipStream.h" // For compression statistics
+#include "posthog/parsers/ParserArena.h" // For parse memory statistics
 #include "html_portal.h"  // For portal HTML
 #include <ArduinoJson.h>  // For JSON responses
 #include <pgmspace.h> // For PROGMEM
@@ -36,13 +40,14 @@ const char* portalActionToString(PortalAction action) {
 }
 
 // Constructor
-CaptivePortal::CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController)
+CaptivePortal::CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController, PostHogClient& posthogClient)
     : _server(80),
       _configManager(configManager),
       _wifiInterface(wifiInterface),
       _eventQueue(eventQueue),
       _otaManager(otaManager), // Initialize the OtaManager reference
       _cardController(cardController), // Initialize the CardController reference
+      _posthogClient(posthogClient),
       _lastScanTime(0),
       _action_in_progress(PortalAction::NONE),
       _last_action_completed(PortalAction::NONE),
@@ -444,6 +449,8 @@ void CaptivePortal::processAsyncOperations() {
                 String teamIdStr = current_queued_action.param1; // Use from QueuedAction
                 String apiKey = current_queued_action.param2;    // Use from QueuedAction
                 String region = current_queued_action.param3;   // Use from QueuedAction
+                String refreshMinutes = current_queued_action.param4; // Blank means automatic
+                String dashboardId = current_queued_action.param5; // Blank means no batch fetch
                 if (!teamIdStr.isEmpty()) {
                     _configManager.setTeamId(teamIdStr.toInt());
                     if (!apiKey.isEmpty() && apiKey.indexOf("********") == -1) {
@@ -452,6 +459,11 @@ void CaptivePortal::processAsyncOperations() {
                     if(!region.isEmpty()) {
                         _configManager.setRegion(region);
                     }
+                    uint16_t minutes = (uint16_t)constrain(refreshMinutes.toInt(), 0, 1440);
+                    _configManager.setInsightRefreshMinutes(minutes);
+                    _posthogClient.setRefreshIntervalMinutes(minutes);
+                    int dashboard = dashboardId.toInt();
+                    _configManager.setDashboardId(dashboard > 0 ? dashboard : ConfigManager::NO_DASHBOARD_ID);
                     currentActionSuccess = true;
                     currentActionMessage = "Device configuration saved.";
                 } else {
@@ -526,7 +538,7 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     // return; 
 
     // RESTORE ORIGINAL FULL LOGIC
-    DynamicJsonDocument doc(4096); 
+    DynamicJsonDocument doc(16384); // Sized for event bus and fetch telemetry on top of the scan list
 
     JsonObject portalObj = doc.createNestedObject("portal");
     portalObj["action_in_progress"] = portalActionToString(_action_in_progress);
@@ -579,6 +591,8 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     deviceConfigObj["api_key_display"] = apiKey.length() > 0 ? "********" + apiKey.substring(apiKey.length() - 4) : "";
     deviceConfigObj["api_key_present"] = apiKey.length() > 0;
     deviceConfigObj["region"] = _configManager.getRegion();
+    deviceConfigObj["refresh_minutes"] = _configManager.getInsightRefreshMinutes();
+    deviceConfigObj["dashboard_id"] = _configManager.getDashboardId();
 
 
     JsonObject otaObj = doc.createNestedObject("ota");
@@ -593,6 +607,21 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     otaObj["release_notes"] = lastCheck.releaseNotes;        
     otaObj["error_message"] = lastCheck.error;               
 
+    JsonObject eventBusObj = doc.createNestedObject("event_bus");
+    _eventQueue.writeStats(eventBusObj);
+
+    JsonObject posthogObj = doc.createNestedObject("posthog");
+    _posthogClient.writeStats(posthogObj);
+
+    JsonObject tlsObj = doc.createNestedObject("tls");
+    SecureClient::writeStats(tlsObj);
+
+    JsonObject compressionObj = doc.createNestedObject("compression");
+    GzipStream::writeStats(compressionObj);
+
+    JsonObject parserArenaObj = doc.createNestedObject("parser_arena");
+    ParserArena::instance().writeStats(parserArenaObj);
+
     String responseJson;
     serializeJson(doc, responseJson);
     AsyncWebServerResponse *response = request->beginResponse(200, "application/json", responseJson);
@@ -649,6 +678,8 @@ void CaptivePortal::requestAction(PortalAction action, AsyncWebServerRequest *re
             if (request->hasParam("teamId", true)) new_action.param1 = request->getParam("teamId", true)->value();
             if (request->hasParam("apiKey", true)) new_action.param2 = request->getParam("apiKey", true)->value();
             if (request->hasParam("region", true)) new_action.param3 = request->getParam("region", true)->value();
+            if (request->hasParam("refreshMinutes", true)) new_action.param4 = request->getParam("refreshMinutes", true)->value();
+            if (request->hasParam("dashboardId", true)) new_action.param5 = request->getParam("dashboardId", true)->value();
         }
         // For actions like SCAN_WIFI, CHECK_OTA_UPDATE, START_OTA_UPDATE, params are not from request body initially.
 
@@ -22,6 +22,7 @@
 
 class OtaManager; // Forward declaration
 class CardController; // Forward declaration
+class PostHogClient; // Forward declaration
 
 // Enum to represent different asynchronous actions the portal can perform
 enum class PortalAction {
@@ -57,8 +58,9 @@ public:
      * @param eventQueue Reference to event system for state changes
      * @param otaManager Reference to OTA update manager
      * @param cardController Reference to card controller for card definitions
+     * @param posthogClient Reference to PostHog client for fetch statistics
      */
-    CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController);
+    CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController, PostHogClient& posthogClient);
 
     /**
      * @brief Initialize the portal
@@ -83,6 +85,7 @@ private:
     unsigned long _lastScanTime;     ///< Timestamp of last WiFi scan
     OtaManager& _otaManager;         ///< OTA Update Manager reference
     CardController& _cardController; ///< Card controller reference
+    PostHogClient& _posthogClient;   ///< PostHog client reference
 
     // Action queue structure (internal)
     struct QueuedAction {
@@ -90,6 +93,8 @@ private:
         String param1;
         String param2;
         String param3;
+        String param4;
+        String param5;
     };
 
     // Max size for the action queue
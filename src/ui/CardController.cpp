@@ -11,7 +11,7 @@
 QueueHandle_t CardController::uiQueue = nullptr;
 
 // Define the global UI dispatch function
-std::function<void(std::function<void()>, bool)> globalUIDispatch;
+std::function<bool(std::function<void()>, bool)> globalUIDispatch;
 
 CardController::CardController(
     lv_obj_t* screen,
@@ -20,6 +20,7 @@ CardController::CardController(
     ConfigManager& configManager,
     WiFiInterface& wifiInterface,
     PostHogClient& posthogClient,
+    SnapshotStore& snapshotStore,
     WeatherClient& weatherClient,
     EventQueue& eventQueue
 ) : screen(screen),
@@ -28,6 +29,7 @@ CardController::CardController(
     configManager(configManager),
     wifiInterface(wifiInterface),
     posthogClient(posthogClient),
+    snapshotStore(snapshotStore),
     weatherClient(weatherClient),
     eventQueue(eventQueue),
     cardStack(nullptr),
@@ -39,6 +41,9 @@ CardController::CardController(
 }
 
 CardController::~CardController() {
+    // Stop event delivery before tearing anything down
+    subscriptions.clear();
+    
     // Clean up any allocated resources
     delete cardStack;
     cardStack = nullptr;
@@ -81,6 +86,18 @@ void CardController::initialize(DisplayInterface* display) {
     // Create card navigation stack
     cardStack = new CardNavigationStack(screen, screenWidth, screenHeight);
     
+    // Let the PostHog client refresh the insight on screen first
+    cardStack->setActiveCardCallback([this](lv_obj_t* card) {
+        String visibleInsight;
+        for (const auto& cardInstance : dynamicCards[CardType::INSIGHT]) {
+            if (card && cardInstance.lvglCard == card) {
+                visibleInsight = static_cast<InsightCard*>(cardInstance.handler)->getInsightId();
+                break;
+            }
+        }
+        posthogClient.setVisibleInsight(visibleInsight);
+    });
+    
     // Create provision UI (always present, not configurable)
     provisioningCard = new ProvisioningCard(
         screen, 
@@ -108,34 +125,32 @@ void CardController::initialize(DisplayInterface* display) {
     
     
     // Subscribe to card configuration changes
-    eventQueue.subscribe([this](const Event& event) {
-        if (event.type == EventType::CARD_CONFIG_CHANGED) {
-            handleCardConfigChanged();
-        } else if (event.type == EventType::CARD_TITLE_UPDATED) {
-            handleCardTitleUpdated(event);
-        }
-    });
+    subscriptions.push_back(eventQueue.subscribe(EventType::CARD_CONFIG_CHANGED, [this](const Event& event) {
+        handleCardConfigChanged();
+    }));
+    subscriptions.push_back(eventQueue.subscribe(EventType::CARD_TITLE_UPDATED, [this](const Event& event) {
+        handleCardTitleUpdated(event);
+    }, DispatchMode::BLOCKING));  // Writes card config to flash
     
     // Subscribe to WiFi events
-    eventQueue.subscribe([this](const Event& event) {
-        if (event.type == EventType::WIFI_CONNECTING || 
-            event.type == EventType::WIFI_CONNECTED ||
-            event.type == EventType::WIFI_CONNECTION_FAILED ||
-            event.type == EventType::WIFI_AP_STARTED) {
+    for (EventType type : {EventType::WIFI_CONNECTING, EventType::WIFI_CONNECTED,
+                           EventType::WIFI_CONNECTION_FAILED, EventType::WIFI_AP_STARTED}) {
+        subscriptions.push_back(eventQueue.subscribe(type, [this](const Event& event) {
             handleWiFiEvent(event);
-        }
-    });
+        }));
+    }
     
-    // Subscribe to card API request events (handled on Core 0)
-    eventQueue.subscribe([this](const Event& event) {
-        if (event.type == EventType::WEATHER_REQUEST) {
-            handleWeatherRequest(event);
-        } else if (event.type == EventType::NOW_PLAYING_REQUEST) {
-            handleNowPlayingRequest(event);
-        } else if (event.type == EventType::TIME_SYNC_REQUEST) {
-            handleTimeSyncRequest(event);
-        }
-    });
+    // Subscribe to card API request events (handled on Core 0 event workers,
+    // since they make synchronous HTTP calls or may wait to deliver a result)
+    subscriptions.push_back(eventQueue.subscribe(EventType::WEATHER_REQUEST, [this](const Event& event) {
+        handleWeatherRequest(event);
+    }, DispatchMode::BLOCKING));
+    subscriptions.push_back(eventQueue.subscribe(EventType::NOW_PLAYING_REQUEST, [this](const Event& event) {
+        handleNowPlayingRequest(event);
+    }, DispatchMode::BLOCKING));
+    subscriptions.push_back(eventQueue.subscribe(EventType::TIME_SYNC_REQUEST, [this](const Event& event) {
+        handleTimeSyncRequest(event);
+    }, DispatchMode::BLOCKING));
 }
 
 void CardController::setDisplayInterface(DisplayInterface* display) {
@@ -225,6 +240,7 @@ void CardController::initializeCardTypes() {
             screen,
             configManager,
             eventQueue,
+            snapshotStore,
             configValue,
             screenWidth,
             screenHeight
@@ -628,6 +644,17 @@ void CardController::reconcileCards(const std::vector<CardConfig>& newConfigs) {
             }
         }
         
+        // Stop refreshing insights whose cards were removed
+        // and forget their stored snapshots
+        std::vector<String> insightIds;
+        std::vector<std::string> storedIds;
+        for (InsightCard* insightCard : getInsightCards()) {
+            insightIds.push_back(insightCard->getInsightId());
+            storedIds.push_back(insightCard->getInsightId().c_str());
+        }
+        posthogClient.retainInsights(insightIds);
+        snapshotStore.retain(storedIds);
+        
         // Force another LVGL refresh to ensure everything is properly laid out
         lv_refr_now(NULL);
         
@@ -662,7 +689,7 @@ void CardController::initUIQueue() {
         } else {
             // Set the global dispatch function to point to our method
             globalUIDispatch = [this](std::function<void()> func, bool to_front) {
-                this->dispatchToLVGLTask(std::move(func), to_front);
+                return this->dispatchToLVGLTask(std::move(func), to_front);
             };
         }
     }
@@ -679,22 +706,25 @@ void CardController::processUIQueue() {
         }
     }
     
+    // Requests whose results couldn't be queued still get their failure callback
+    AsyncRequestBase::deliverParked();
+    
     // Update active card (for games and other interactive cards)
     if (cardStack) {
         cardStack->updateActiveCard();
     }
 }
 
-void CardController::dispatchToLVGLTask(std::function<void()> update_func, bool to_front) {
+bool CardController::dispatchToLVGLTask(std::function<void()> update_func, bool to_front) {
     if (uiQueue == nullptr) {
         Serial.println("[UI-ERROR] UI Queue not initialized, cannot dispatch UI update.");
-        return;
+        return false;
     }
 
     UICallback* callback = new UICallback(std::move(update_func));
     if (!callback) {
         Serial.println("[UI-CRITICAL] Failed to allocate UICallback for dispatch!");
-        return;
+        return false;
     }
 
     BaseType_t queue_send_result;
@@ -708,7 +738,9 @@ void CardController::dispatchToLVGLTask(std::function<void()> update_func, bool
         Serial.printf("[UI-WARN] UI queue full/error (send_to_front: %d), update discarded. Core: %d\n", 
                       to_front, xPortGetCoreID());
         delete callback;
+        return false;
     }
+    return true;
 }
 
 void CardController::handleCardTitleUpdated(const Event& event) {
@@ -733,67 +765,44 @@ void CardController::handleCardTitleUpdated(const Event& event) {
 void CardController::handleWeatherRequest(const Event& event) {
     Serial.printf("CardController: Processing weather request for %s\n", event.data.c_str());
     
-    // Create response event
-    Event responseEvent;
-    responseEvent.type = EventType::WEATHER_DATA_RECEIVED;
-    responseEvent.cardId = event.cardId;
-    responseEvent.success = false;
-    responseEvent.data = "";
+    auto request = event.requestAs<WeatherData>();
+    WeatherData weatherData;
+    bool success = false;
     
     try {
         // Make weather API call using the existing weatherClient
-        WeatherData weatherData;
-        bool success = weatherClient.fetchWeatherData(event.data, weatherData);
-        
-        responseEvent.success = success;
-        
-        if (success && weatherData.valid) {
-            // Format data as: "city|temp|main|feels_like|humidity"
-            responseEvent.data = weatherData.city + "|" + 
-                               String(weatherData.temperature, 1) + "|" +
-                               weatherData.main + "|" +
-                               String(weatherData.feels_like, 1) + "|" +
-                               String(weatherData.humidity);
+        success = weatherClient.fetchWeatherData(event.data, weatherData) && weatherData.valid;
+        
+        if (success) {
             Serial.printf("CardController: Weather data retrieved successfully for %s\n", weatherData.city.c_str());
         } else {
             Serial.printf("CardController: Failed to retrieve weather data for %s\n", event.data.c_str());
         }
     } catch (...) {
         Serial.printf("CardController: Exception occurred while fetching weather data for %s\n", event.data.c_str());
-        responseEvent.success = false;
-        responseEvent.data = "";
+        success = false;
     }
     
-    // Publish response event
-    eventQueue.publishEvent(responseEvent);
+    // Answer the requesting card directly
+    if (request) {
+        request->complete(success, std::move(weatherData));
+    }
 }
 
 void CardController::handleNowPlayingRequest(const Event& event) {
     Serial.printf("CardController: Processing now playing request for %s\n", event.data.c_str());
     
-    // Create response event
-    Event responseEvent;
-    responseEvent.type = EventType::NOW_PLAYING_DATA_RECEIVED;
-    responseEvent.cardId = event.cardId;
-    responseEvent.success = false;
-    responseEvent.data = "";
+    auto request = event.requestAs<NowPlayingData>();
+    NowPlayingData nowPlayingData;
+    bool success = false;
     
     try {
         // Create a temporary NowPlayingClient if needed
         // Note: This might need to be refactored based on your NowPlayingClient implementation
         NowPlayingClient tempClient(event.data);
-        NowPlayingData nowPlayingData;
-        bool success = tempClient.fetchNowPlayingData(nowPlayingData);
-        
-        responseEvent.success = success;
+        success = tempClient.fetchNowPlayingData(nowPlayingData);
         
         if (success) {
-            // Format data as: "title|artist|album|playedAt|isPlaying"
-            responseEvent.data = nowPlayingData.title + "|" + 
-                               nowPlayingData.artist + "|" +
-                               nowPlayingData.album + "|" +
-                               nowPlayingData.playedAt + "|" +
-                               (nowPlayingData.isPlaying ? "1" : "0");
             Serial.printf("CardController: Now playing data retrieved: %s by %s\n", 
                          nowPlayingData.title.c_str(), nowPlayingData.artist.c_str());
         } else {
@@ -801,12 +810,13 @@ void CardController::handleNowPlayingRequest(const Event& event) {
         }
     } catch (...) {
         Serial.printf("CardController: Exception occurred while fetching now playing data for %s\n", event.data.c_str());
-        responseEvent.success = false;
-        responseEvent.data = "";
+        success = false;
     }
     
-    // Publish response event
-    eventQueue.publishEvent(responseEvent);
+    // Answer the requesting card directly
+    if (request) {
+        request->complete(success, std::move(nowPlayingData));
+    }
 }
 
 void CardController::handleTimeSyncRequest(const Event& event) {
@@ -851,13 +861,8 @@ void CardController::handleTimeSyncRequest(const Event& event) {
         Serial.println("CardController: Invalid time sync request format");
     }
     
-    // Create response event
-    Event responseEvent;
-    responseEvent.type = EventType::TIME_SYNC_COMPLETE;
-    responseEvent.cardId = event.cardId;
-    responseEvent.success = success;
-    responseEvent.data = "";
-    
-    // Publish response event
-    eventQueue.publishEvent(responseEvent);
+    // Answer the requesting card directly
+    if (auto request = event.requestAs<bool>()) {
+        request->complete(success, success);
+    }
 } 
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "ConfigManager.h"
 #include "hardware/WifiInterface.h"
 #include "posthog/PostHogClient.h"
+#include "posthog/SnapshotStore.h"
 #include "weather/WeatherClient.h"
 #include "ui/CardNavigationStack.h"
 #include "ui/ProvisioningCard.h"
@@ -42,6 +43,7 @@ public:
      * @param configManager Reference to configuration manager
      * @param wifiInterface Reference to WiFi interface
      * @param posthogClient Reference to PostHog client
+     * @param snapshotStore Reference to the insight snapshot store
      * @param eventQueue Reference to event queue for state changes
      */
     CardController(
@@ -51,6 +53,7 @@ public:
         ConfigManager& configManager,
         WiFiInterface& wifiInterface,
         PostHogClient& posthogClient,
+        SnapshotStore& snapshotStore,
         WeatherClient& weatherClient,
         EventQueue& eventQueue
     );
@@ -155,8 +158,10 @@ public:
      * 
      * Queues UI operations to be executed on the LVGL thread.
      * Handles queue overflow by discarding updates if queue is full.
+     * 
+     * @return false if the update was discarded
      */
-    void dispatchToLVGLTask(std::function<void()> update_func, bool to_front = false);
+    bool dispatchToLVGLTask(std::function<void()> update_func, bool to_front = false);
 
 private:
     // Screen reference
@@ -168,8 +173,10 @@ private:
     ConfigManager& configManager;   ///< Configuration manager reference
     WiFiInterface& wifiInterface;  ///< WiFi interface reference
     PostHogClient& posthogClient;  ///< PostHog client reference
+    SnapshotStore& snapshotStore;  ///< Insight snapshot store reference
     WeatherClient& weatherClient;  ///< Weather client reference
     EventQueue& eventQueue;        ///< Event queue reference
+    std::vector<EventSubscription> subscriptions; ///< Event subscriptions owned by the controller
     
     // UI Components
     CardNavigationStack* cardStack;     ///< Navigation stack for cards
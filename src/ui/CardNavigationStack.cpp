@@ -8,7 +8,7 @@ extern Bounce2::Button buttons[];
 #define NUM_BUTTONS 3
 
 CardNavigationStack::CardNavigationStack(lv_obj_t* parent, uint16_t width, uint16_t height)
-    : _parent(parent), _width(width), _height(height), _current_card(0), _mutex_ptr(nullptr) {
+    : _parent(parent), _width(width), _height(height), _current_card(0), _mutex_ptr(nullptr), _last_active_card(nullptr) {
     
     // Create main container
     _main_container = lv_obj_create(_parent);
@@ -281,7 +281,13 @@ void CardNavigationStack::_update_scroll_indicator(int active_index) {
     uint32_t pip_count = lv_obj_get_child_cnt(_scroll_indicator);
     
     // Safety check - if we have no cards, don't update anything
-    if (card_count == 0 || pip_count == 0) return;
+    if (card_count == 0 || pip_count == 0) {
+        if (card_count == 0 && _last_active_card && _active_card_callback) {
+            _last_active_card = nullptr;
+            _active_card_callback(nullptr);
+        }
+        return;
+    }
     
     // Ensure active_index is valid
     if (active_index >= card_count) {
@@ -324,6 +330,21 @@ void CardNavigationStack::_update_scroll_indicator(int active_index) {
         // Update previous index for next time
         previous_index = active_index;
     }
+
+    // Notify only when a different card object becomes active; removing a
+    // card can shift another one into the same index
+    lv_obj_t* active_card = lv_obj_get_child(_main_container, active_index);
+    if (active_card != _last_active_card) {
+        _last_active_card = active_card;
+        if (_active_card_callback) {
+            _active_card_callback(active_card);
+        }
+    }
+}
+
+void CardNavigationStack::setActiveCardCallback(std::function<void(lv_obj_t*)> callback) {
+    _active_card_callback = callback;
+    _last_active_card = nullptr;
 }
 
 // Remove a card from the stack
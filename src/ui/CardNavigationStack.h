@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Bounce2.h>
 #include <vector>
+#include <functional>
 #include "ui/InputHandler.h"
 
 // Forward declaration
@@ -121,6 +122,14 @@ public:
      */
     void updateActiveCard();
     
+    /**
+     * @brief Set callback for active card changes
+     * @param callback Called with the newly active card, or nullptr when the stack is empty
+     * 
+     * Runs on the LVGL task whenever a different card becomes active.
+     */
+    void setActiveCardCallback(std::function<void(lv_obj_t*)> callback);
+    
 private:
     /**
      * @brief LVGL scroll event callback
@@ -161,4 +170,8 @@ private:
     
     // Input handling
     std::vector<std::pair<lv_obj_t*, InputHandler*>> _input_handlers;  ///< Card-specific input handlers
+    
+    // Active card notification
+    std::function<void(lv_obj_t*)> _active_card_callback;  ///< Called when the active card changes
+    lv_obj_t* _last_active_card;    ///< Card last passed to the callback
 }; 
\ No newline at end of file
@@ -100,19 +100,15 @@ ClockCard::ClockCard(lv_obj_t* parent, EventQueue& eventQueue, const String& tim
     lv_obj_set_style_pad_all(_progress_bar, 0, 0);
     lv_obj_set_style_radius(_progress_bar, 0, 0);
     
-    // Subscribe to time sync events
-    _event_queue.subscribe([this](const Event& event) {
-        if (event.type == EventType::TIME_SYNC_COMPLETE && event.cardId == "clock") {
-            this->onEvent(event);
-        }
-    });
-    
     // Request initial time sync
     requestTimeSync();
     updateTime();
 }
 
 ClockCard::~ClockCard() {
+    // Make sure an in-flight time sync never calls back into this card
+    _time_sync_request.cancel();
+    
     // LVGL will handle cleanup when parent is deleted
 }
 
@@ -230,16 +226,14 @@ void ClockCard::formatWeekday() {
     strcpy(_weekday_str, weekdays[timeinfo.tm_wday]);
 }
 
-void ClockCard::onEvent(const Event& event) {
-    if (event.type == EventType::TIME_SYNC_COMPLETE) {
-        _ntp_initialized = event.success;
-        if (event.success) {
-            Serial.println("ClockCard: Time sync completed successfully");
-        } else {
-            Serial.println("ClockCard: Time sync failed");
-        }
-        updateTime();
+void ClockCard::onTimeSyncResult(bool success) {
+    _ntp_initialized = success;
+    if (success) {
+        Serial.println("ClockCard: Time sync completed successfully");
+    } else {
+        Serial.println("ClockCard: Time sync failed");
     }
+    updateTime();
 }
 
 void ClockCard::requestTimeSync() {
@@ -267,9 +261,11 @@ void ClockCard::requestTimeSync() {
                   _timezone_config.utc_offset_hours);
     
     // Publish event to request time sync (will be handled by Core 0)
-    Event timeSyncEvent = Event::createCardEvent(EventType::TIME_SYNC_REQUEST, "clock", 
-        _timezone_config.name + "|" + String(_timezone_config.utc_offset_hours));
-    _event_queue.publishEvent(timeSyncEvent);
+    _time_sync_request = _event_queue.request<bool>(EventType::TIME_SYNC_REQUEST, "clock",
+        _timezone_config.name + "|" + String(_timezone_config.utc_offset_hours),
+        [this](bool success, const bool&) {
+            onTimeSyncResult(success);
+        });
 }
 
 bool ClockCard::isWiFiConnected() {
@@ -17,7 +17,7 @@ public:
     void prepareForRemoval() override { _card = nullptr; }
 
 private:
-    void onEvent(const Event& event);
+    void onTimeSyncResult(bool success);
     void requestTimeSync();
     void updateTime();
     void formatTime();
@@ -29,6 +29,7 @@ private:
     void updateProgressBar();
     
     EventQueue& _event_queue;
+    AsyncRequestHandle _time_sync_request;
     
     lv_obj_t* _card;
     lv_obj_t* _time_label;
@@ -9,9 +9,10 @@
 
 
 InsightCard::InsightCard(lv_obj_t* parent, ConfigManager& config, EventQueue& eventQueue,
-                        const String& insightId, uint16_t width, uint16_t height)
+                        SnapshotStore& snapshotStore, const String& insightId, uint16_t width, uint16_t height)
     : _config(config)
     , _event_queue(eventQueue)
+    , _snapshot_store(snapshotStore)
     , _insight_id(insightId)
     , _current_title("")
     , _card(nullptr)
@@ -69,15 +70,23 @@ InsightCard::InsightCard(lv_obj_t* parent, ConfigManager& config, EventQueue& ev
     lv_obj_set_style_border_width(_content_container, 0, 0);
     lv_obj_set_style_pad_all(_content_container, 0, 0);
 
-    _event_queue.subscribe([this](const Event& event) {
-        if (event.type == EventType::INSIGHT_DATA_RECEIVED && event.insightId == _insight_id) {
-            this->onEvent(event);
-        }
+    // Rendering only queues work for the LVGL task, so the handler runs inline;
+    // PostHogClient stores the snapshot in flash after publishing it
+    _subscription = _event_queue.subscribe(EventType::INSIGHT_DATA_RECEIVED, _insight_id, [this](const Event& event) {
+        this->onEvent(event);
     });
+
+    // Show the last data we had until the first fetch lands
+    auto stored = std::make_shared<InsightSnapshot>();
+    if (_snapshot_store.load(_insight_id.c_str(), *stored)) {
+        Serial.printf("[InsightCard-%s] Showing stored snapshot\n", _insight_id.c_str());
+        renderSnapshot(stored);
+    }
 }
 
 InsightCard::~InsightCard() {
     Serial.printf("[InsightCard-%s] DESTRUCTOR called\n", _insight_id.c_str());
+    _subscription.reset();
     std::shared_ptr<InsightRendererBase> renderer_for_lambda = std::move(_active_renderer);
     if (globalUIDispatch) {
         globalUIDispatch([card_obj = _card, renderer = renderer_for_lambda]() mutable {
@@ -92,21 +101,12 @@ InsightCard::~InsightCard() {
 }
 
 void InsightCard::onEvent(const Event& event) {
-    std::shared_ptr<InsightParser> parser = nullptr;
-    if (event.jsonData.length() > 0) {
-        parser = std::make_shared<InsightParser>(event.jsonData.c_str());
-    } else if (event.parser) {
-        parser = event.parser;
-    } else {
-        Serial.printf("[InsightCard-%s] Event received with no JSON data or pre-parsed object.\n", _insight_id.c_str());
-        handleParsedData(nullptr);
-        return;
-    }
-    handleParsedData(parser);
+    // PostHogClient parses on its worker; a null snapshot means the response wasn't an insight
+    handleParsedData(event.snapshot);
 }
 
-void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
-    if (!parser || !parser->isValid()) {
+void InsightCard::handleParsedData(std::shared_ptr<const InsightSnapshot> snapshot) {
+    if (!snapshot) {
         Serial.printf("[InsightCard-%s] Invalid data or parse error.\n", _insight_id.c_str());
         if (globalUIDispatch) {
             globalUIDispatch([this]() {
@@ -121,12 +121,12 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
         return;
     }
 
-    InsightParser::InsightType new_insight_type = parser->getInsightType();
-    char title_buffer[64];
-    if (!parser->getName(title_buffer, sizeof(title_buffer))) {
-        strcpy(title_buffer, "Insight");
-    }
-    String new_title(title_buffer);
+    renderSnapshot(snapshot);
+}
+
+void InsightCard::renderSnapshot(std::shared_ptr<const InsightSnapshot> snapshot) {
+    InsightParser::InsightType new_insight_type = snapshot->type;
+    String new_title(snapshot->title);
 
     // Only dispatch title update event if the title has actually changed
     if (_current_title != new_title) {
@@ -136,7 +136,7 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
     }
 
     if (globalUIDispatch) {
-        globalUIDispatch([this, new_insight_type, new_title, parser, id = _insight_id]() mutable {
+        globalUIDispatch([this, new_insight_type, new_title, snapshot, id = _insight_id]() mutable {
         if (isValidObject(_title_label)) {
             lv_label_set_text(_title_label, new_title.c_str());
         }
@@ -165,6 +165,7 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
                     _active_renderer = std::make_unique<NumericCardRenderer>();
                     break;
                 case InsightParser::InsightType::LINE_GRAPH:
+                case InsightParser::InsightType::AREA_CHART: // Drawn as lines, one per series
                     _active_renderer = std::make_unique<LineGraphRenderer>();
                     break;
                 case InsightParser::InsightType::FUNNEL:
@@ -192,14 +193,7 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
         }
 
         if (_active_renderer) {
-            char prefix_buffer[16] = "";
-            char suffix_buffer[16] = "";
-
-            if (new_insight_type == InsightParser::InsightType::NUMERIC_CARD && parser) {
-                parser->getNumericFormattingPrefix(prefix_buffer, sizeof(prefix_buffer));
-                parser->getNumericFormattingSuffix(suffix_buffer, sizeof(suffix_buffer));
-            }
-            _active_renderer->updateDisplay(*parser, new_title, prefix_buffer, suffix_buffer);
+            _active_renderer->updateDisplay(*snapshot, new_title, snapshot->prefix, snapshot->suffix);
         } else if (!needs_rebuild) {
             Serial.printf("[InsightCard-%s] No active renderer to update and no rebuild was triggered. Type: %d\n",
                 id.c_str(), (int)_current_type);
@@ -226,7 +220,7 @@ bool InsightCard::handleButtonPress(uint8_t button_index) {
         Event refreshEvent;
         refreshEvent.type = EventType::INSIGHT_FORCE_REFRESH;
         refreshEvent.insightId = _insight_id;
-        _event_queue.publishEvent(refreshEvent);
+        _event_queue.publishEvent(std::move(refreshEvent));
         
         // Update UI to show we're refreshing
         if (globalUIDispatch) {
@@ -7,6 +7,7 @@
 #include "ConfigManager.h"
 #include "EventQueue.h"
 #include "posthog/parsers/InsightParser.h"
+#include "posthog/SnapshotStore.h"
 #include "UICallback.h"
 #include "ui/InputHandler.h"
 
@@ -27,6 +28,7 @@ class InsightRendererBase;
  * - Automatic insight type detection and UI adaptation
  * - Memory-safe LVGL object management
  * - Smart number formatting with unit scaling (K, M)
+ * - Shows the insight's stored snapshot at creation, before any fetch
  */
 class InsightCard : public InputHandler {
 public:
@@ -36,6 +38,7 @@ public:
      * @param parent LVGL parent object to attach this card to
      * @param config Configuration manager for persistent storage
      * @param eventQueue Event queue for receiving data updates
+     * @param snapshotStore Flash store for the last data of each insight
      * @param insightId Unique identifier for this insight
      * @param width Card width in pixels
      * @param height Card height in pixels
@@ -46,7 +49,7 @@ public:
      * Subscribes to INSIGHT_DATA_RECEIVED events for the specified insightId.
      */
     InsightCard(lv_obj_t* parent, ConfigManager& config, EventQueue& eventQueue,
-                const String& insightId, uint16_t width, uint16_t height);
+                SnapshotStore& snapshotStore, const String& insightId, uint16_t width, uint16_t height);
     
     /**
      * @brief Destructor - safely cleans up UI resources
@@ -96,22 +99,31 @@ private:
     /**
      * @brief Handle events from the event queue
      * 
-     * @param event Event containing insight data or JSON
+     * @param event Event carrying the insight's snapshot
      * 
-     * Processes INSIGHT_DATA_RECEIVED events, parsing JSON if needed
-     * and updating the visualization accordingly.
+     * Processes INSIGHT_DATA_RECEIVED events, updating the
+     * visualization accordingly.
      */
     void onEvent(const Event& event);
     
     /**
-     * @brief Process parsed insight data
+     * @brief Process newly fetched insight data
      * 
-     * @param parser Shared pointer to parsed insight data
+     * @param snapshot Data extracted from the response, or nullptr if it didn't parse
+     * 
+     * Renders the snapshot, or shows an error if there is none.
+     */
+    void handleParsedData(std::shared_ptr<const InsightSnapshot> snapshot);
+
+    /**
+     * @brief Show a snapshot of insight data
+     * 
+     * @param snapshot Data to show, from a fresh parse or from flash
      * 
      * Updates the card's visualization based on the insight type.
      * Handles type changes by recreating UI elements as needed.
      */
-    void handleParsedData(std::shared_ptr<InsightParser> parser);
+    void renderSnapshot(std::shared_ptr<const InsightSnapshot> snapshot);
     
     /**
      * @brief Clear the content container
@@ -135,6 +147,8 @@ private:
     // Configuration and state
     ConfigManager& _config;              ///< Configuration manager reference
     EventQueue& _event_queue;            ///< Event queue reference
+    SnapshotStore& _snapshot_store;      ///< Stored snapshots, shared by all cards
+    EventSubscription _subscription;     ///< Data subscription for _insight_id
     String _insight_id;                  ///< Unique insight identifier
     String _current_title;               ///< Current card title
     InsightParser::InsightType _current_type; ///< Current visualization type
@@ -6,7 +6,7 @@
 
 NowPlayingCard::NowPlayingCard(lv_obj_t* parent, EventQueue& eventQueue, const String& username_config) 
     : _event_queue(eventQueue), _username_config(username_config), _nowPlayingClient(nullptr), _last_update(0), 
-      _error_shown(false), _has_data(false), _retry_count(0), _pending_update(false), _pending_error_hide(false), _pending_error_show(false) {
+      _error_shown(false), _has_data(false), _retry_count(0) {
     
     _card = lv_obj_create(parent);
     lv_obj_set_size(_card, 240, 135);
@@ -91,13 +91,6 @@ NowPlayingCard::NowPlayingCard(lv_obj_t* parent, EventQueue& eventQueue, const S
     lv_obj_align(_error_label, LV_ALIGN_CENTER, 0, 0);
     lv_obj_add_flag(_error_label, LV_OBJ_FLAG_HIDDEN);
     
-    // Subscribe to now playing events
-    _event_queue.subscribe([this](const Event& event) {
-        if (event.type == EventType::NOW_PLAYING_DATA_RECEIVED && event.cardId == "nowplaying") {
-            this->onEvent(event);
-        }
-    });
-    
     // Create client with username
     _nowPlayingClient = new NowPlayingClient(_username_config);
     
@@ -106,6 +99,9 @@ NowPlayingCard::NowPlayingCard(lv_obj_t* parent, EventQueue& eventQueue, const S
 }
 
 NowPlayingCard::~NowPlayingCard() {
+    // Make sure an in-flight request never calls back into this card
+    _now_playing_request.cancel();
+    
     if (_nowPlayingClient) {
         delete _nowPlayingClient;
     }
@@ -124,22 +120,6 @@ bool NowPlayingCard::handleButtonPress(uint8_t button_index) {
 }
 
 bool NowPlayingCard::update() {
-    // Handle pending UI updates from Core 0 events
-    if (_pending_update) {
-        updateNowPlayingDisplay(_pending_data);
-        _pending_update = false;
-    }
-    
-    if (_pending_error_hide) {
-        hideError();
-        _pending_error_hide = false;
-    }
-    
-    if (_pending_error_show) {
-        showError(_pending_error_message);
-        _pending_error_show = false;
-    }
-    
     uint32_t now = millis();
     
     // Check if it's time to update
@@ -151,49 +131,18 @@ bool NowPlayingCard::update() {
     return false;
 }
 
-void NowPlayingCard::onEvent(const Event& event) {
-    if (event.type == EventType::NOW_PLAYING_DATA_RECEIVED) {
-        if (event.success && !event.data.isEmpty()) {
-            // Parse the data format: "title|artist|album|playedAt|isPlaying"
-            NowPlayingData data;
-            int pipes[4];
-            int pipeCount = 0;
-            
-            // Find all pipe positions
-            for (int i = 0; i < event.data.length() && pipeCount < 4; i++) {
-                if (event.data.charAt(i) == '|') {
-                    pipes[pipeCount++] = i;
-                }
-            }
-            
-            if (pipeCount >= 4) {
-                data.title = event.data.substring(0, pipes[0]);
-                data.artist = event.data.substring(pipes[0] + 1, pipes[1]);
-                data.album = event.data.substring(pipes[1] + 1, pipes[2]);
-                data.playedAt = event.data.substring(pipes[2] + 1, pipes[3]);
-                data.isPlaying = event.data.substring(pipes[3] + 1) == "1";
-                
-                Serial.printf("NowPlayingCard: Data received: %s by %s (Playing: %s)\n", 
-                              data.title.c_str(), data.artist.c_str(), data.isPlaying ? "Yes" : "No");
-                
-                // Store data for UI update on Core 1
-                _pending_data = data;
-                _pending_update = true;
-                _pending_error_hide = true;
-                _has_data = true;
-            } else {
-                Serial.printf("NowPlayingCard: Invalid data format received (expected 5 fields, got %d)\n", pipeCount + 1);
-                if (!_has_data) {
-                    _pending_error_message = "Invalid data";
-                    _pending_error_show = true;
-                }
-            }
-        } else {
-            Serial.println("NowPlayingCard: Failed to receive data");
-            if (!_has_data) {
-                _pending_error_message = "Failed to fetch data";
-                _pending_error_show = true;
-            }
+void NowPlayingCard::onNowPlayingResult(bool success, const NowPlayingData& data) {
+    // Delivered on the LVGL task, so the labels can be updated directly
+    if (success) {
+        Serial.printf("NowPlayingCard: Data received: %s by %s (Playing: %s)\n", 
+                      data.title.c_str(), data.artist.c_str(), data.isPlaying ? "Yes" : "No");
+        updateNowPlayingDisplay(data);
+        hideError();
+        _has_data = true;
+    } else {
+        Serial.println("NowPlayingCard: Failed to receive data");
+        if (!_has_data) {
+            showError("Failed to fetch data");
         }
     }
 }
@@ -246,9 +195,11 @@ void NowPlayingCard::requestNowPlayingUpdate() {
         lv_label_set_text(_status_label, "");
     }
     
-    // Publish event to request now playing data (will be handled by Core 0)
-    Event nowPlayingEvent = Event::createCardEvent(EventType::NOW_PLAYING_REQUEST, "nowplaying", _username_config);
-    _event_queue.publishEvent(nowPlayingEvent);
+    // Request now playing data (fetched on Core 0, answered on the LVGL task)
+    _now_playing_request = _event_queue.request<NowPlayingData>(EventType::NOW_PLAYING_REQUEST, "nowplaying", _username_config,
+        [this](bool success, const NowPlayingData& data) {
+            onNowPlayingResult(success, data);
+        });
     
     _last_update = millis(); // Update timestamp when request is made
 }
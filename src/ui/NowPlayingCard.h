@@ -19,7 +19,7 @@ public:
     void setNowPlayingClient(NowPlayingClient* client) { _nowPlayingClient = client; }
 
 private:
-    void onEvent(const Event& event);
+    void onNowPlayingResult(bool success, const NowPlayingData& data);
     void updateNowPlayingDisplay(const NowPlayingData& data);
     void showError(const String& message);
     void hideError();
@@ -27,6 +27,7 @@ private:
     bool isWiFiConnected();
     
     EventQueue& _event_queue;
+    AsyncRequestHandle _now_playing_request;
     
     lv_obj_t* _card;
     lv_obj_t* _title_container;
@@ -47,13 +48,6 @@ private:
     bool _has_data;
     uint8_t _retry_count;
     
-    // Cross-core UI update handling
-    NowPlayingData _pending_data;
-    bool _pending_update;
-    bool _pending_error_hide;
-    bool _pending_error_show;
-    String _pending_error_message;
-    
     static const uint32_t UPDATE_INTERVAL = 30000; // 30 sec in ms
     static const uint8_t MAX_RETRIES = 5;
 };
\ No newline at end of file
@@ -26,7 +26,8 @@ private:
  * 
  * @param func The function to execute on the UI thread
  * @param to_front Whether to add to front of queue (higher priority)
+ * @return false if the queue was full and the update was discarded
  */
-extern std::function<void(std::function<void()>, bool)> globalUIDispatch;
+extern std::function<bool(std::function<void()>, bool)> globalUIDispatch;
 
 #endif // UI_CALLBACK_H 
\ No newline at end of file
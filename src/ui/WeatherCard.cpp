@@ -88,13 +88,6 @@ WeatherCard::WeatherCard(lv_obj_t* parent, EventQueue& eventQueue, const String&
     lv_obj_align(_error_label, LV_ALIGN_TOP_MID, 0, 5);
     lv_obj_add_flag(_error_label, LV_OBJ_FLAG_HIDDEN);
     
-    // Subscribe to weather events
-    _event_queue.subscribe([this](const Event& event) {
-        if (event.type == EventType::WEATHER_DATA_RECEIVED && event.cardId == "weather") {
-            this->onEvent(event);
-        }
-    });
-    
     // Set initial display
     lv_label_set_text(_temp_label, "--°C");
     lv_label_set_text(_main_label, "---");
@@ -104,6 +97,9 @@ WeatherCard::WeatherCard(lv_obj_t* parent, EventQueue& eventQueue, const String&
 }
 
 WeatherCard::~WeatherCard() {
+    // Make sure an in-flight request never calls back into this card
+    _weather_request.cancel();
+    
     // LVGL will handle cleanup when parent is deleted
 }
 
@@ -193,42 +189,17 @@ void WeatherCard::hideError() {
     }
 }
 
-void WeatherCard::onEvent(const Event& event) {
-    if (event.type == EventType::WEATHER_DATA_RECEIVED) {
-        if (event.success && !event.data.isEmpty()) {
-            // Parse the JSON-like data to WeatherData structure
-            WeatherData weatherData;
-            // Simple parsing - in a real implementation you'd use ArduinoJson
-            // For now, assume the data format is "city|temp|main|feels_like|humidity"
-            int firstPipe = event.data.indexOf('|');
-            int secondPipe = event.data.indexOf('|', firstPipe + 1);
-            int thirdPipe = event.data.indexOf('|', secondPipe + 1);
-            int fourthPipe = event.data.indexOf('|', thirdPipe + 1);
-            
-            if (firstPipe != -1 && secondPipe != -1 && thirdPipe != -1 && fourthPipe != -1) {
-                weatherData.city = event.data.substring(0, firstPipe);
-                weatherData.temperature = event.data.substring(firstPipe + 1, secondPipe).toFloat();
-                weatherData.main = event.data.substring(secondPipe + 1, thirdPipe);
-                weatherData.feels_like = event.data.substring(thirdPipe + 1, fourthPipe).toFloat();
-                weatherData.humidity = event.data.substring(fourthPipe + 1).toInt();
-                weatherData.valid = true;
-                
-                Serial.printf("WeatherCard: Weather data received: %s: %.1f°C, %s\n", 
-                              weatherData.city.c_str(), weatherData.temperature, weatherData.main.c_str());
-                updateWeatherDisplay(weatherData);
-                hideError();
-                _has_data = true;
-            } else {
-                Serial.println("WeatherCard: Invalid weather data format received");
-                if (!_has_data) {
-                    showError("Invalid data");
-                }
-            }
-        } else {
-            Serial.println("WeatherCard: Failed to receive weather data");
-            if (!_has_data) {
-                showError("Failed to fetch weather");
-            }
+void WeatherCard::onWeatherResult(bool success, const WeatherData& weatherData) {
+    if (success) {
+        Serial.printf("WeatherCard: Weather data received: %s: %.1f°C, %s\n", 
+                      weatherData.city.c_str(), weatherData.temperature, weatherData.main.c_str());
+        updateWeatherDisplay(weatherData);
+        hideError();
+        _has_data = true;
+    } else {
+        Serial.println("WeatherCard: Failed to receive weather data");
+        if (!_has_data) {
+            showError("Failed to fetch weather");
         }
     }
 }
@@ -274,9 +245,11 @@ void WeatherCard::requestWeatherUpdate() {
         lv_label_set_text(_main_label, "---");
     }
     
-    // Publish event to request weather data (will be handled by Core 0)
-    Event weatherEvent = Event::createCardEvent(EventType::WEATHER_REQUEST, "weather", _city_config);
-    _event_queue.publishEvent(weatherEvent);
+    // Request weather data (fetched on Core 0, answered on the LVGL task)
+    _weather_request = _event_queue.request<WeatherData>(EventType::WEATHER_REQUEST, "weather", _city_config,
+        [this](bool success, const WeatherData& weatherData) {
+            onWeatherResult(success, weatherData);
+        });
     
     _last_update = millis(); // Update timestamp when request is made
 }
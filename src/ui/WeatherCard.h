@@ -19,7 +19,7 @@ public:
     void setWeatherClient(WeatherClient* client) { _weatherClient = client; }
 
 private:
-    void onEvent(const Event& event);
+    void onWeatherResult(bool success, const WeatherData& weatherData);
     void updateWeatherDisplay(const WeatherData& weatherData);
     void showError(const String& message);
     void hideError();
@@ -27,6 +27,7 @@ private:
     bool isWiFiConnected();
     
     EventQueue& _event_queue;
+    AsyncRequestHandle _weather_request;
     
     lv_obj_t* _card;
     lv_obj_t* _temp_label;
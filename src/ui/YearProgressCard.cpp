@@ -63,19 +63,15 @@ YearProgressCard::YearProgressCard(lv_obj_t* parent, EventQueue& eventQueue, con
     lv_obj_set_style_pad_all(_progress_bar, 0, 0);
     lv_obj_set_style_radius(_progress_bar, 0, 0);
     
-    // Subscribe to time sync events
-    _event_queue.subscribe([this](const Event& event) {
-        if (event.type == EventType::TIME_SYNC_COMPLETE && event.cardId == "yearprogress") {
-            this->onEvent(event);
-        }
-    });
-    
     // Request initial time sync
     requestTimeSync();
     updateYearProgress();
 }
 
 YearProgressCard::~YearProgressCard() {
+    // Make sure an in-flight time sync never calls back into this card
+    _time_sync_request.cancel();
+    
     // LVGL will handle cleanup when parent is deleted
 }
 
@@ -142,16 +138,14 @@ float YearProgressCard::calculateYearProgress() {
     return total_progress;
 }
 
-void YearProgressCard::onEvent(const Event& event) {
-    if (event.type == EventType::TIME_SYNC_COMPLETE) {
-        _ntp_initialized = event.success;
-        if (event.success) {
-            Serial.println("YearProgressCard: Time sync completed successfully");
-        } else {
-            Serial.println("YearProgressCard: Time sync failed");
-        }
-        updateYearProgress();
+void YearProgressCard::onTimeSyncResult(bool success) {
+    _ntp_initialized = success;
+    if (success) {
+        Serial.println("YearProgressCard: Time sync completed successfully");
+    } else {
+        Serial.println("YearProgressCard: Time sync failed");
     }
+    updateYearProgress();
 }
 
 void YearProgressCard::requestTimeSync() {
@@ -179,9 +173,11 @@ void YearProgressCard::requestTimeSync() {
                   _timezone_config.utc_offset_hours);
     
     // Publish event to request time sync (will be handled by Core 0)
-    Event timeSyncEvent = Event::createCardEvent(EventType::TIME_SYNC_REQUEST, "yearprogress", 
-        _timezone_config.name + "|" + String(_timezone_config.utc_offset_hours));
-    _event_queue.publishEvent(timeSyncEvent);
+    _time_sync_request = _event_queue.request<bool>(EventType::TIME_SYNC_REQUEST, "yearprogress",
+        _timezone_config.name + "|" + String(_timezone_config.utc_offset_hours),
+        [this](bool success, const bool&) {
+            onTimeSyncResult(success);
+        });
 }
 
 bool YearProgressCard::isWiFiConnected() {
@@ -17,13 +17,14 @@ public:
     void prepareForRemoval() override { _card = nullptr; }
 
 private:
-    void onEvent(const Event& event);
+    void onTimeSyncResult(bool success);
     void updateYearProgress();
     float calculateYearProgress();
     void requestTimeSync();
     bool isWiFiConnected();
     
     EventQueue& _event_queue;
+    AsyncRequestHandle _time_sync_request;
     
     lv_obj_t* _card;
     lv_obj_t* _year_label;
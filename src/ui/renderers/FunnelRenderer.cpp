@@ -98,13 +98,13 @@ void FunnelRenderer::createElements(lv_obj_t* parent_container) {
     // Serial.println("[FunnelRenderer] Funnel elements created successfully.");
 }
 
-void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_str, const char* prefix, const char* suffix) {
+void FunnelRenderer::updateDisplay(const InsightSnapshot& snapshot, const String& title_str, const char* prefix, const char* suffix) {
     // prefix and suffix are ignored for FunnelRenderer.
     Serial.printf("[FunnelRenderer] updateDisplay for title: %s\n", title_str.c_str()); // Verify this is called
 
-    size_t raw_step_count = parser.getFunnelStepCount();
-    size_t raw_breakdown_count = parser.getFunnelBreakdownCount();
-    Serial.printf("[FunnelRenderer] Parser reports: step_count = %u, breakdown_count = %u\n",
+    size_t raw_step_count = snapshot.funnel_steps;
+    size_t raw_breakdown_count = snapshot.funnel_breakdowns;
+    Serial.printf("[FunnelRenderer] Snapshot has: step_count = %u, breakdown_count = %u\n",
                   (unsigned int)raw_step_count, (unsigned int)raw_breakdown_count);
 
     size_t step_count = std::min(raw_step_count, static_cast<size_t>(MAX_FUNNEL_STEPS));
@@ -125,12 +125,7 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
         return;
     }
 
-    uint32_t step_counts_total[MAX_FUNNEL_STEPS] = {0};
-    // Conversion rates not directly used for display here, but parser might need it.
-    if (!parser.getFunnelTotalCounts(0, step_counts_total, nullptr)) {
-        Serial.println("[FunnelRenderer-ERROR] Failed to get funnel total counts from parser.");
-        return;
-    }
+    const uint32_t* step_counts_total = snapshot.step_totals;
 
     uint32_t total_first_step = step_counts_total[0];
     Serial.printf("[FunnelRenderer] total_first_step = %u\n", (unsigned int)total_first_step);
@@ -159,8 +154,7 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
         current_ui_step.relative_width_to_first_step = (total_first_step > 0) ? 
             static_cast<float>(step_counts_total[i]) / total_first_step : 0.0f;
 
-        char step_name_buffer[64] = {0};
-        parser.getFunnelStepData(0, i, step_name_buffer, sizeof(step_name_buffer), nullptr, nullptr, nullptr);
+        const char* step_name_buffer = snapshot.step_names[i];
         
         char number_buffer[20];
         NumberFormat::addThousandsSeparators(number_buffer, sizeof(number_buffer), step_counts_total[i]);
@@ -185,8 +179,8 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
         current_ui_step.label_text = new_label_format;
 
         // Calculate breakdown segments for this step
-        uint32_t breakdown_val_counts[MAX_BREAKDOWNS] = {0};
-        if (parser.getFunnelBreakdownComparison(i, breakdown_val_counts, nullptr) && step_counts_total[i] > 0) {
+        const uint32_t* breakdown_val_counts = snapshot.breakdown_counts[i];
+        if (step_counts_total[i] > 0) {
             float total_width_for_this_step_bar = available_width_for_bars * current_ui_step.relative_width_to_first_step;
             float current_offset = 0.0f;
 
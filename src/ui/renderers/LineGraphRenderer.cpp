@@ -3,7 +3,7 @@
 #include <algorithm> // For std::min
 
 LineGraphRenderer::LineGraphRenderer()
-    : _chart(nullptr), _series(nullptr) {
+    : _chart(nullptr), _series{}, _series_count(0) {
     // Serial.println("[LineGraphRenderer] Constructor");
 }
 
@@ -41,13 +41,14 @@ void LineGraphRenderer::createElements(lv_obj_t* parent_container) {
     // Remove padding from the chart itself to use full area
     lv_obj_set_style_pad_all(_chart, 0, LV_PART_MAIN);
 
-    _series = lv_chart_add_series(_chart, lv_color_hex(0x2980b9), LV_CHART_AXIS_PRIMARY_Y);
-    if (!_series) {
+    _series[0] = lv_chart_add_series(_chart, seriesColor(0, 0), LV_CHART_AXIS_PRIMARY_Y);
+    if (!_series[0]) {
         Serial.println("[LineGraphRenderer-ERROR] Failed to create chart series.");
         lv_obj_del(_chart); // Clean up chart if series fails
         _chart = nullptr;
         return;
     }
+    _series_count = 1;
 
     lv_obj_set_style_size(_chart, 0, 0, LV_PART_INDICATOR); // No indicators (dots on points)
     lv_obj_set_style_line_width(_chart, 2, LV_PART_ITEMS); // Line width for the series
@@ -57,15 +58,16 @@ void LineGraphRenderer::createElements(lv_obj_t* parent_container) {
     // InsightCard will do a global refresh after calling createElements if needed.
 }
 
-void LineGraphRenderer::updateDisplay(InsightParser& parser, const String& title, const char* prefix, const char* suffix) {
+void LineGraphRenderer::updateDisplay(const InsightSnapshot& snapshot, const String& title, const char* prefix, const char* suffix) {
     // Title is handled by InsightCard. This renderer updates the chart data.
     // prefix and suffix are ignored for LineGraphRenderer.
-    size_t point_count = parser.getSeriesPointCount();
-    if (point_count == 0) {
+    size_t series_count = std::min(static_cast<size_t>(snapshot.series_count), MAX_SERIES);
+    size_t point_count = snapshot.pointCount();
+    if (series_count == 0 || point_count == 0) {
         // No data points, maybe clear the chart or show a message?
         // For now, clear existing points if any.
         dispatchToUI([this]() {
-            if (isValidLVGLObject(_chart) && _series) {
+            if (areElementsValid()) {
                 lv_chart_set_point_count(_chart, 0);
                 lv_chart_refresh(_chart);
             }
@@ -73,57 +75,59 @@ void LineGraphRenderer::updateDisplay(InsightParser& parser, const String& title
         return;
     }
 
-    // Allocate memory for Y values from the parser
-    // Using unique_ptr for automatic memory management.
-    std::unique_ptr<double[]> y_values_from_parser(new double[point_count]);
-    if (!parser.getSeriesYValues(y_values_from_parser.get())) {
-        Serial.println("[LineGraphRenderer-ERROR] Failed to get Y series values from parser.");
-        return;
-    }
-
-    // Find max value for scaling (logic from original InsightCard)
-    double max_val = 0.0;
-    if (point_count > 0) {
-        max_val = y_values_from_parser[0];
-        for (size_t i = 1; i < point_count; ++i) {
-            if (y_values_from_parser[i] > max_val) max_val = y_values_from_parser[i];
-        }
+    // Find max value for scaling (logic from original InsightCard), over
+    // every series so they share the y axis
+    const float* y_values = snapshot.values.data();
+    size_t value_count = series_count * point_count;
+    double max_val = y_values[0];
+    for (size_t i = 1; i < value_count; ++i) {
+        if (y_values[i] > max_val) max_val = y_values[i];
     }
     // Ensure max_val is not zero to avoid division by zero; if all values are <=0, chart range needs care.
     if (max_val <= 0) max_val = 1.0; // Default to 1 if all data is zero or negative to prevent scaling issues.
 
     double scale_factor = (max_val > 1000.0) ? (1000.0 / max_val) : 1.0;
 
-    // Copy data for the UI thread: Capture y_values_from_parser by moving its contents to a shared_ptr.
-    // This is because the lambda might outlive the current scope.
-    // The parser itself is passed by reference but assumed to be valid during the lambda's queuing/execution
-    // due to the shared_ptr in InsightCard::handleParsedData.
-    
-    // To pass the array safely to the lambda, we copy it into a structure that can be captured.
-    // A std::vector is easier to capture by value for lambdas.
-    std::vector<double> values_for_lambda(point_count);
-    for(size_t i = 0; i < point_count; ++i) {
-        values_for_lambda[i] = y_values_from_parser[i];
+    // LVGL charts hold int32_t points. Scale every series into one buffer
+    // laid out like the snapshot's, which the chart series then point into
+    // instead of each keeping a copy. The lambda owns it until then, as it
+    // may outlive the snapshot.
+    std::vector<int32_t> scaled(value_count);
+    for (size_t i = 0; i < value_count; ++i) {
+        scaled[i] = static_cast<int32_t>(y_values[i] * scale_factor);
     }
-
-    dispatchToUI([this, captured_values = std::move(values_for_lambda), point_count, max_val, scale_factor]() {
+    uint8_t previous_period = snapshot.previous_period;
+    
+    dispatchToUI([this, scaled = std::move(scaled), series_count, point_count, previous_period, max_val, scale_factor]() mutable {
         if (!areElementsValid()) {
             Serial.println("[LineGraphRenderer-WARN] Chart/Series invalid in updateDisplay lambda.");
             return;
         }
 
-        // Limit display points for performance/readability if desired, though original fix was to show all.
-        // const size_t display_points = std::min(point_count, static_cast<size_t>(50)); // Example: Max 50 points
-        const size_t display_points = point_count; // Show all points as per previous fixes
+        // Snapshots arrive downsampled to at most one point per pixel column
+        lv_chart_set_point_count(_chart, point_count);
 
-        lv_chart_set_point_count(_chart, display_points);
-        // lv_chart_set_all_value(_chart, _series, 0); // Zero out before setting new values
+        // Match the chart's series to the snapshot's
+        while (_series_count > series_count) {
+            _series_count--;
+            lv_chart_remove_series(_chart, _series[_series_count]);
+            _series[_series_count] = nullptr;
+        }
+        while (_series_count < series_count) {
+            _series[_series_count] = lv_chart_add_series(_chart, seriesColor(_series_count, previous_period), LV_CHART_AXIS_PRIMARY_Y);
+            if (!_series[_series_count]) {
+                Serial.println("[LineGraphRenderer-ERROR] Failed to create chart series.");
+                break;
+            }
+            _series_count++;
+        }
 
-        for (size_t i = 0; i < display_points; ++i) {
-            int16_t y_val = static_cast<int16_t>(captured_values[i] * scale_factor);
-            // LVGL chart y-values are typically positive. If your data can be negative,
-            // you might need to adjust the range and how y_val is calculated.
-            lv_chart_set_value_by_id(_chart, _series, i, y_val);
+        // Series still point into the old buffer until repointed below,
+        // which happens before the chart next draws
+        _points = std::move(scaled);
+        for (size_t s = 0; s < _series_count; ++s) {
+            lv_chart_set_series_color(_chart, _series[s], seriesColor(s, previous_period));
+            lv_chart_set_ext_y_array(_chart, _series[s], &_points[s * point_count]);
         }
 
         // Set chart range dynamically
@@ -146,10 +150,24 @@ void LineGraphRenderer::clearElements() {
         lv_obj_del(_chart); // This also deletes series associated with the chart
     }
     _chart = nullptr;
-    _series = nullptr; // Series is owned by chart, but good to nullify pointer.
+    // Series are owned by the chart, but good to nullify pointers.
+    for (size_t s = 0; s < MAX_SERIES; ++s) {
+        _series[s] = nullptr;
+    }
+    _series_count = 0;
+    _points.clear(); // Only now that no series reads from it
 }
 
 bool LineGraphRenderer::areElementsValid() const {
     // Can be called from any thread.
-    return isValidLVGLObject(_chart) && _series; // Series validity is tied to chart, but check both for clarity.
-} 
\ No newline at end of file
+    return isValidLVGLObject(_chart) && _series_count > 0; // Series validity is tied to chart, but check both for clarity.
+} 
+
+lv_color_t LineGraphRenderer::seriesColor(size_t index, uint8_t previous_period) {
+    if (previous_period & (1 << index)) {
+        return lv_color_hex(0x7f8c8d); // Gray
+    }
+    // Same order as the funnel's breakdowns
+    static const uint32_t palette[MAX_SERIES] = {0x2980b9, 0x8e44ad, 0xd35400, 0xc0392b};
+    return lv_color_hex(palette[index % MAX_SERIES]);
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "InsightRendererBase.h"
 #include "../Style.h" // For styles, colors, fonts
+#include <vector>
 // NumberFormat might not be directly needed here if data comes pre-formatted or scaling is internal
 
 class LineGraphRenderer : public InsightRendererBase {
@@ -11,13 +12,20 @@ public:
     ~LineGraphRenderer() override;
 
     void createElements(lv_obj_t* parent_container) override;
-    void updateDisplay(InsightParser& parser, const String& title, const char* prefix = nullptr, const char* suffix = nullptr) override;
+    void updateDisplay(const InsightSnapshot& snapshot, const String& title, const char* prefix = nullptr, const char* suffix = nullptr) override;
     void clearElements() override;
     bool areElementsValid() const override;
 
 private:
+    static constexpr size_t MAX_SERIES = InsightSnapshot::MAX_SERIES;
+
     lv_obj_t* _chart;           // LVGL chart object
-    lv_chart_series_t* _series; // LVGL chart series object
+    lv_chart_series_t* _series[MAX_SERIES]; // LVGL chart series, the first _series_count in use
+    size_t _series_count;
+    std::vector<int32_t> _points; // Scaled points of every series, by column; the series read straight from it
+
+    // Line color of a series; previous periods of a comparison are dimmed
+    static lv_color_t seriesColor(size_t index, uint8_t previous_period);
 
     // Constants for chart appearance - can be defined here or moved to Style.h if more global
     // For now, keeping them local to the renderer.
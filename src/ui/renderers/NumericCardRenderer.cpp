@@ -40,9 +40,9 @@ void NumericCardRenderer::createElements(lv_obj_t* parent_container) {
     lv_label_set_text(_value_label, "..."); // Initial placeholder text
 }
 
-void NumericCardRenderer::updateDisplay(InsightParser& parser, const String& title, const char* prefix, const char* suffix) {
+void NumericCardRenderer::updateDisplay(const InsightSnapshot& snapshot, const String& title, const char* prefix, const char* suffix) {
     // Title is handled by InsightCard, we only update the value label here.
-    double value = parser.getNumericCardValue();
+    double value = snapshot.numeric_value;
 
     // Data processing (getting value) is done here.
     // LVGL operations are dispatched to the UI thread.
@@ -4,6 +4,8 @@ const char* WeatherClient::API_KEY = "83e3f95ad3aa6558cf610776e64d18f0";
 const char* WeatherClient::BASE_URL = "https://api.openweathermap.org/data/2.5/weather";
 
 WeatherClient::WeatherClient() {
+    static const char* header_keys[] = {"Transfer-Encoding", "Content-Encoding"};
+    _http.collectHeaders(header_keys, sizeof(header_keys) / sizeof(header_keys[0]));
 }
 
 bool WeatherClient::isReady() const {
@@ -19,8 +21,9 @@ bool WeatherClient::fetchWeatherData(const String& city, WeatherData& data) {
     String url = buildWeatherUrl(city);
     Serial.printf("Fetching weather from: %s\n", url.c_str());
     
-    _http.begin(url);
+    _http.begin(_client, url);
     _http.setTimeout(10000); // 10 second timeout
+    _http.addHeader("Accept-Encoding", "gzip");
     
     int httpCode = _http.GET();
     
@@ -30,12 +33,20 @@ bool WeatherClient::fetchWeatherData(const String& city, WeatherData& data) {
         return false;
     }
     
-    String response = _http.getString();
-    _http.end();
-    
-    // Parse JSON response
+    // Parse JSON response straight off the socket, inflating if compressed
+    String transfer_encoding = _http.header("Transfer-Encoding");
+    transfer_encoding.toLowerCase();
+    HttpBodyStream body(*_http.getStreamPtr(), transfer_encoding.indexOf("chunked") >= 0, _http.getSize());
     DynamicJsonDocument doc(2048);
-    DeserializationError error = deserializeJson(doc, response);
+    DeserializationError error;
+    if (GzipStream::isGzip(_http.header("Content-Encoding"))) {
+        GzipStream inflated(body);
+        error = deserializeJson(doc, inflated);
+    } else {
+        error = deserializeJson(doc, body);
+    }
+    body.finish();
+    _http.end();
     
     if (error) {
         Serial.printf("JSON parsing failed: %s\n", error.c_str());
@@ -4,6 +4,9 @@
 #include <HTTPClient.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "../net/SecureClient.h"
+#include "../net/HttpBodyStream.h"
+#include "../net/GzipStream.h"
 
 struct WeatherData {
     float temperature;
@@ -28,6 +31,7 @@ private:
     static const char* API_KEY;
     static const char* BASE_URL;
     
+    SecureClient _client;
     HTTPClient _http;
     
     String buildWeatherUrl(const String& city) const;
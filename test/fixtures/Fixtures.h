@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+/**
+ * @brief Read a recorded PostHog response from test/fixtures
+ * @param name File name, e.g. "funnel.json"
+ * @return The response body, or "" if the file is missing
+ *
+ * Paths are relative to the project directory, which is where
+ * `pio test` runs the test program.
+ */
+inline std::string loadFixture(const char* name) {
+    std::string path = std::string("test/fixtures/") + name;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        printf("Missing fixture %s\n", path.c_str());
+        return "";
+    }
+
+    std::string body;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        body.append(buffer, read);
+    }
+    fclose(file);
+    return body;
+}
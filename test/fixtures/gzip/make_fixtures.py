@@ -0,0 +1,59 @@
+"""Regenerate the Inflater fixtures with zlib: python3 make_fixtures.py
+
+corpus.txt is insight-shaped JSON, longer than the 32 KB deflate window and
+with a block repeated about 31 KB later, so matches reach across the point
+where the window wraps. Each other file is corpus.txt compressed one way.
+"""
+import gzip
+import os
+import random
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def corpus():
+    rng = random.Random(2024)
+    header = '{"results": [{"short_id": "tR3nd30d", "name": "Daily signups", "filters": {"insight": "TRENDS", "interval": "day"}, '
+    header += '"result": [{"label": "$pageview", "action": {"id": "$pageview", "name": "$pageview", "custom_name": null}, '
+    repeated = ''.join('"breakdown_value_%03d": "%s", ' % (i, rng.choice(['Chrome', 'Safari', 'Firefox', 'Edge'])) for i in range(60))
+    points = []
+    for day in range(1200):
+        points.append('{"day": "2024-%02d-%02d", "value": %d}' % (day // 28 % 12 + 1, day % 28 + 1, rng.randint(0, 99999)))
+    body = header + repeated + '"data": [' + ', '.join(points[:760]) + '], ' + repeated
+    body += '"days": [' + ', '.join(points[760:]) + ']}]}]}\n'
+    return body.encode()
+
+
+def deflate(data, level=6, strategy=zlib.Z_DEFAULT_STRATEGY, wbits=31):
+    compressor = zlib.compressobj(level, zlib.DEFLATED, wbits, 9, strategy)
+    return compressor.compress(data) + compressor.flush()
+
+
+def write(name, content):
+    with open(os.path.join(HERE, name), 'wb') as out:
+        out.write(content)
+
+
+def main():
+    data = corpus()
+    write('corpus.txt', data)
+    write('stored.gz', deflate(data, level=0))
+    write('fast.gz', deflate(data, level=1))
+    write('default.gz', deflate(data))
+    write('best.gz', deflate(data, level=9))
+    write('filtered.gz', deflate(data, strategy=zlib.Z_FILTERED))
+    write('huffman_only.gz', deflate(data, strategy=zlib.Z_HUFFMAN_ONLY))
+    write('rle.gz', deflate(data, strategy=zlib.Z_RLE))
+    write('fixed.gz', deflate(data, strategy=zlib.Z_FIXED))
+    write('small_window.gz', deflate(data, wbits=16 + 9))
+    write('raw.deflate', deflate(data, wbits=-15))
+
+    # File name and modification time in the header, as the gzip tool writes them
+    with open(os.path.join(HERE, 'named.gz'), 'wb') as out:
+        with gzip.GzipFile('corpus.txt', 'wb', fileobj=out, mtime=0) as named:
+            named.write(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,97 @@
+// libFuzzer harness for InsightParser and InsightSnapshot.
+//
+// Feeds arbitrary bytes through both parse paths and every getter a
+// renderer might call, then round-trips the snapshot through its encoding.
+// Built with clang, after `pio test -e native` has fetched ArduinoJson:
+//
+//   clang++ -std=gnu++17 -g -O1 -fsanitize=fuzzer,address,undefined \
+//       -I .pio/libdeps/native/ArduinoJson/src -I src/posthog \
+//       test/fuzz/fuzz_insight_parser.cpp src/posthog/parsers/*.cpp \
+//       src/posthog/InsightSnapshot.cpp -o fuzz_insight_parser
+//   ./fuzz_insight_parser -max_len=65536 test/fixtures
+//
+// The recorded fixtures make a good seed corpus.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "parsers/InsightParser.h"
+#include "InsightSnapshot.h"
+
+using InsightType = InsightParser::InsightType;
+
+static void exercise(const InsightParser& parser) {
+    if (!parser.isValid()) {
+        return;
+    }
+
+    char buffer[64];
+    parser.getName(buffer, sizeof(buffer));
+    parser.getNumericCardValue();
+    parser.getNumericFormattingPrefix(buffer, sizeof(buffer));
+    parser.getNumericFormattingSuffix(buffer, sizeof(buffer));
+    parser.hasEmptyResult();
+    parser.getPendingQuery(buffer, sizeof(buffer));
+    parser.contentHash();
+
+    size_t points = parser.getSeriesPointCount();
+    std::vector<double> values(points);
+    size_t series_count = parser.getSeriesCount();
+    for (size_t series = 0; series <= series_count; series++) {
+        parser.getSeriesYValues(values.data(), series);
+        parser.getSeriesName(series, buffer, sizeof(buffer));
+        parser.isPreviousPeriodSeries(series);
+    }
+    for (size_t i = 0; i <= points; i++) {
+        parser.getSeriesXLabel(i, buffer, sizeof(buffer));
+    }
+    double low, high;
+    parser.getSeriesRange(&low, &high);
+
+    // Buffers sized like the renderers': the getters must stay within them
+    size_t steps = parser.getFunnelStepCount();
+    size_t breakdowns = parser.getFunnelBreakdownCount();
+    std::vector<uint32_t> counts(std::max(steps, InsightSnapshot::MAX_BREAKDOWNS));
+    std::vector<double> rates(counts.size());
+    parser.getFunnelTotalCounts(0, counts.data(), rates.data());
+    for (size_t step = 0; step <= steps; step++) {
+        uint32_t count;
+        double avg, median;
+        parser.getFunnelStepData(0, step, buffer, sizeof(buffer), &count, &avg, &median);
+        parser.getFunnelConversionTimes(0, step, &avg, &median);
+        parser.getFunnelStepMetadata(step, buffer, sizeof(buffer), buffer, sizeof(buffer));
+        parser.getFunnelBreakdownComparison(step, counts.data(), rates.data());
+    }
+    for (size_t breakdown = 0; breakdown <= breakdowns; breakdown++) {
+        parser.getFunnelBreakdownName(breakdown, buffer, sizeof(buffer));
+    }
+    uint32_t window;
+    parser.getFunnelTimeWindow(&window);
+
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    std::vector<uint8_t> encoded(snapshot.encodedSize());
+    snapshot.encode(encoded.data(), encoded.size());
+    InsightSnapshot decoded;
+    if (!decoded.decode(encoded.data(), encoded.size())) {
+        __builtin_trap();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string json(reinterpret_cast<const char*>(data), size);
+
+    // Pre-scan and type-specific filter, as for string bodies
+    InsightParser parser(json.c_str());
+    exercise(parser);
+
+    // General filter, as for the first fetch of a stream
+    InsightParser general(json.c_str(), InsightType::INSIGHT_NOT_SUPPORTED);
+    exercise(general);
+
+    // Snapshots are also read straight from flash
+    InsightSnapshot snapshot;
+    snapshot.decode(data, size);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core EventQueue uses. String
+// counts the bytes its copies duplicate, which the event queue benchmark
+// reports alongside the queue copies; moves are free, as on the device.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace shim {
+inline std::atomic<uint64_t> stringBytesCopied{0};  ///< Characters duplicated by String copies
+}
+
+// Holds a heap buffer and a length like the core's String, so a byte copy
+// carries ownership along with it instead of pointing into the source
+class String {
+public:
+    String() = default;
+    String(const char* text) { assign(text, text ? strlen(text) : 0); }
+    String(const String& other) {
+        assign(other._buffer, other._length);
+        shim::stringBytesCopied += _length;
+    }
+    String(String&& other) noexcept : _buffer(other._buffer), _length(other._length) {
+        other._buffer = nullptr;
+        other._length = 0;
+    }
+    ~String() { free(_buffer); }
+
+    String& operator=(const String& other) {
+        if (this != &other) {
+            assign(other._buffer, other._length);
+            shim::stringBytesCopied += _length;
+        }
+        return *this;
+    }
+
+    String& operator=(String&& other) noexcept {
+        if (this != &other) {
+            free(_buffer);
+            _buffer = other._buffer;
+            _length = other._length;
+            other._buffer = nullptr;
+            other._length = 0;
+        }
+        return *this;
+    }
+
+    String& operator+=(const char* text) {
+        size_t extra = strlen(text);
+        char* buffer = static_cast<char*>(realloc(_buffer, _length + extra + 1));
+        memcpy(buffer + _length, text, extra + 1);
+        _buffer = buffer;
+        _length += extra;
+        return *this;
+    }
+
+    String& operator+=(const String& other) { return *this += other.c_str(); }
+
+    bool operator==(const char* text) const { return strcmp(c_str(), text) == 0; }
+    bool operator==(const String& other) const { return *this == other.c_str(); }
+
+    const char* c_str() const { return _buffer ? _buffer : ""; }
+    unsigned int length() const { return _length; }
+    bool isEmpty() const { return _length == 0; }
+
+private:
+    void assign(const char* text, size_t length) {
+        char* buffer = static_cast<char*>(malloc(length + 1));
+        memcpy(buffer, text ? text : "", length);
+        buffer[length] = '\0';
+        free(_buffer);
+        _buffer = buffer;
+        _length = length;
+    }
+
+    char* _buffer = nullptr;
+    size_t _length = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char* text) {
+        size_t written = 0;
+        while (*text) {
+            written += write(static_cast<uint8_t>(*text++));
+        }
+        return written;
+    }
+
+    size_t print(const char* text) { return write(text); }
+    size_t println(const char* text = "") { return write(text) + write("\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return write(buffer);
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+inline HardwareSerial Serial;
+
+inline uint32_t micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+inline uint32_t millis() {
+    return micros() / 1000;
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
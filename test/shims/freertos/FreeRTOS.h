@@ -0,0 +1,214 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS API used by EventQueue, built on std::thread.
+// Tasks are threads, one tick is a millisecond as on the device, and queues
+// copy items byte for byte like the real ones.
+//
+// Two counters feed the event queue benchmark: the bytes queues copy in and
+// out, and how often a task resumes from a call that blocked it.
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskIDLE_PRIORITY 0
+
+namespace shim {
+
+struct Task {
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+inline thread_local Task* currentTask = nullptr;
+
+inline std::atomic<uint64_t> queueBytesCopied{0};  ///< Item bytes copied into and out of queues
+inline std::atomic<uint32_t> taskWakeups{0};       ///< Times a task resumed after blocking
+
+// Block the calling thread until ready() holds or the ticks run out; a wait
+// that actually blocked a task counts as one wake-up
+template <typename Ready>
+bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Ready ready) {
+    if (ready()) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    bool result;
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        result = true;
+    } else {
+        result = cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+    }
+    if (currentTask) {
+        taskWakeups++;
+    }
+    return result;
+}
+
+struct Queue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+struct Semaphore {
+    std::mutex mutex;
+    std::condition_variable changed;
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+}  // namespace shim
+
+typedef shim::Queue* QueueHandle_t;
+typedef shim::Semaphore* SemaphoreHandle_t;
+typedef shim::Task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    QueueHandle_t queue = new shim::Queue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+inline void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!shim::waitFor(queue->changed, lock, ticks, [&] { return queue->items.size() < queue->length; })) {
+        return pdFAIL;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    shim::queueBytesCopied += queue->itemSize;
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!shim::waitFor(queue->changed, lock, ticks, [&] { return !queue->items.empty(); })) {
+        return pdFAIL;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    shim::queueBytesCopied += queue->itemSize;
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    SemaphoreHandle_t semaphore = new shim::Semaphore();
+    semaphore->count = initial;
+    semaphore->max = max;
+    return semaphore;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if (!shim::waitFor(semaphore->changed, lock, ticks, [&] { return semaphore->count > 0; })) {
+        return pdFAIL;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count >= semaphore->max) {
+        return pdFAIL;
+    }
+    semaphore->count++;
+    semaphore->changed.notify_one();
+    return pdTRUE;
+}
+
+// The thread owns its Task and frees it on return, so vTaskDelete(NULL) as a
+// task's last statement has nothing left to do
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                              void* parameter, UBaseType_t priority, TaskHandle_t* handle) {
+    TaskHandle_t task = new shim::Task();
+    if (handle) {
+        *handle = task;
+    }
+    std::thread([function, parameter, task]() {
+        shim::currentTask = task;
+        function(parameter);
+        delete task;
+    }).detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                          void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+    return xTaskCreate(function, name, stackDepth, parameter, priority, handle);
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    if (shim::currentTask) {
+        shim::taskWakeups++;
+    }
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    shim::Task* task = shim::currentTask;
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if (!shim::waitFor(task->wake, lock, ticks, [&] { return task->notifications > 0; })) {
+        return 0;
+    }
+    uint32_t value = task->notifications;
+    task->notifications = clearOnExit ? 0 : value - 1;
+    return value;
+}
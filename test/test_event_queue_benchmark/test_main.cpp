@@ -0,0 +1,306 @@
+#include <unity.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include "EventQueue.h"
+
+// EventQueue against the queue it replaced, on the FreeRTOS and Arduino
+// shims in test/shims. Tasks are host threads and a tick is a millisecond, as
+// on the device, so rates are host rates: compare the two queues with each
+// other rather than reading them as device numbers. Pointers are 8 bytes
+// here and 4 on the device.
+//
+// Bytes copied counts what queues copy in and out plus what String copies
+// duplicate. A wake-up is a task resuming from a call that blocked it, so
+// the old loop's tick of sleep after each event counts as one. Assertions
+// only check the direction of each comparison.
+
+static constexpr int EVENT_COUNT = 2000;
+static constexpr int IN_FLIGHT = 8;  // Below both queues' capacity, so nothing is dropped
+static constexpr size_t PAYLOAD_SIZE = 4096;
+static constexpr int BURST_SIZE = 8;
+static constexpr int BURST_COUNT = 200;
+static constexpr int IDLE_MS = 1000;
+
+// The queue as it was before pooling: whole Events memcpy'd through a
+// FreeRTOS queue, received with a 100ms timeout, a tick's sleep per event
+struct LegacyEvent {
+    EventType type;
+    String insightId;
+    std::shared_ptr<void> parser;  // Was std::shared_ptr<InsightParser>
+    String jsonData;
+    String title;
+    String cardId;
+    String data;
+    bool success;
+};
+
+class LegacyEventQueue {
+public:
+    explicit LegacyEventQueue(size_t queueSize = 10)
+        : eventQueue(xQueueCreate(queueSize, sizeof(LegacyEvent))),
+          callbackMutex(xSemaphoreCreateMutex()),
+          taskExited(xSemaphoreCreateCounting(1, 0)) {}
+
+    ~LegacyEventQueue() {
+        end();
+        alignas(LegacyEvent) unsigned char storage[sizeof(LegacyEvent)];
+        while (xQueueReceive(eventQueue, storage, 0) == pdPASS) {
+            std::launder(reinterpret_cast<LegacyEvent*>(storage))->~LegacyEvent();
+        }
+        vQueueDelete(eventQueue);
+        vSemaphoreDelete(callbackMutex);
+        vSemaphoreDelete(taskExited);
+    }
+
+    // The original let the stack Event's destructor free the buffers the
+    // queued copy still pointed at. Here the source is never destroyed, so
+    // ownership moves with the bytes; the copies made are the same.
+    bool publishEvent(EventType type, const String& insightId, const String& jsonData) {
+        alignas(LegacyEvent) unsigned char storage[sizeof(LegacyEvent)];
+        LegacyEvent* event = new (storage) LegacyEvent{type, insightId, nullptr, jsonData, "", "", "", false};
+        if (xQueueSend(eventQueue, event, 0) == pdPASS) {
+            return true;
+        }
+        event->~LegacyEvent();
+        return false;
+    }
+
+    void subscribe(std::function<void(const LegacyEvent&)> callback) {
+        xSemaphoreTake(callbackMutex, portMAX_DELAY);
+        callbacks.push_back(std::move(callback));
+        xSemaphoreGive(callbackMutex);
+    }
+
+    void begin() {
+        isRunning = true;
+        xTaskCreate(eventProcessingTask, "EventQueueTask", 16384, this, tskIDLE_PRIORITY + 1, nullptr);
+    }
+
+    // The original deleted the task from outside; the shim can't, so wait for it to leave
+    void end() {
+        if (isRunning) {
+            isRunning = false;
+            xSemaphoreTake(taskExited, portMAX_DELAY);
+        }
+    }
+
+private:
+    static void eventProcessingTask(void* parameter) {
+        LegacyEventQueue* self = static_cast<LegacyEventQueue*>(parameter);
+        alignas(LegacyEvent) unsigned char storage[sizeof(LegacyEvent)];
+        while (self->isRunning) {
+            if (xQueueReceive(self->eventQueue, storage, pdMS_TO_TICKS(100)) == pdPASS) {
+                LegacyEvent* event = std::launder(reinterpret_cast<LegacyEvent*>(storage));
+                if (xSemaphoreTake(self->callbackMutex, portMAX_DELAY) == pdTRUE) {
+                    for (const auto& callback : self->callbacks) {
+                        callback(*event);
+                    }
+                    xSemaphoreGive(self->callbackMutex);
+                }
+                event->~LegacyEvent();
+            }
+            vTaskDelay(1);
+        }
+        xSemaphoreGive(self->taskExited);
+        vTaskDelete(NULL);
+    }
+
+    QueueHandle_t eventQueue;
+    SemaphoreHandle_t callbackMutex;
+    SemaphoreHandle_t taskExited;
+    std::vector<std::function<void(const LegacyEvent&)>> callbacks;
+    std::atomic<bool> isRunning{false};
+};
+
+struct RunResult {
+    double eventsPerSecond;
+    double bytesCopiedPerEvent;
+    int rejected;
+};
+
+struct LoopResult {
+    double idleWakeupsPerSecond;
+    double eventsPerSecond;
+    double wakeupsPerBurst;
+    int rejected;
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void resetCounters() {
+    shim::queueBytesCopied = 0;
+    shim::stringBytesCopied = 0;
+}
+
+// Publish count events through publish(i), keeping at most IN_FLIGHT
+// undelivered, and wait until the subscriber has seen them all
+template <typename Publish>
+static RunResult run(int count, const std::atomic<int>& received, Publish&& publish) {
+    resetCounters();
+    int rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        while (i - received.load() >= IN_FLIGHT) {
+            std::this_thread::yield();
+        }
+        if (!publish(i)) {
+            rejected++;
+        }
+    }
+    while (received.load() < count - rejected) {
+        std::this_thread::yield();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double copied = static_cast<double>(shim::queueBytesCopied + shim::stringBytesCopied);
+    return { count / elapsed.count(), copied / count, rejected };
+}
+
+// Leave a started queue idle, then publish bursts of BURST_SIZE events
+// through publish(i), each one only once the last has been delivered
+template <typename Publish>
+static LoopResult runBursts(const std::atomic<int>& received, Publish&& publish) {
+    LoopResult result = {};
+    shim::taskWakeups = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+    result.idleWakeupsPerSecond = shim::taskWakeups * 1000.0 / IDLE_MS;
+
+    shim::taskWakeups = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int burst = 0; burst < BURST_COUNT; burst++) {
+        for (int i = 0; i < BURST_SIZE; i++) {
+            if (!publish(burst * BURST_SIZE + i)) {
+                result.rejected++;
+            }
+        }
+        while (received.load() < (burst + 1) * BURST_SIZE - result.rejected) {
+            std::this_thread::yield();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.eventsPerSecond = BURST_COUNT * BURST_SIZE / elapsed.count();
+    result.wakeupsPerBurst = static_cast<double>(shim::taskWakeups) / BURST_COUNT;
+    return result;
+}
+
+// Built from a C string each time so making the payload isn't counted as a copy
+static String makePayload() {
+    static const std::string payload(PAYLOAD_SIZE, 'x');
+    return String(payload.c_str());
+}
+
+static String makeInsightId(int i) {
+    char id[16];
+    snprintf(id, sizeof(id), "i%d", i);
+    return String(id);
+}
+
+void test_payload_transport() {
+    std::atomic<int> received{0};
+    size_t lastLength = 0;
+
+    RunResult before;
+    {
+        LegacyEventQueue legacy;
+        legacy.subscribe([&](const LegacyEvent& event) {
+            lastLength = event.jsonData.length();
+            received++;
+        });
+        legacy.begin();
+        before = run(EVENT_COUNT, received, [&](int i) {
+            String json = makePayload();
+            return legacy.publishEvent(EventType::INSIGHT_DATA_RECEIVED, makeInsightId(i), json);
+        });
+        legacy.end();
+    }
+    TEST_ASSERT_EQUAL(PAYLOAD_SIZE, lastLength);
+
+    received = 0;
+    lastLength = 0;
+    RunResult after;
+    {
+        EventQueue queue;
+        EventSubscription subscription = queue.subscribe(EventType::INSIGHT_DATA_RECEIVED, [&](const Event& event) {
+            lastLength = event.jsonData.length();
+            received++;
+        });
+        queue.begin();
+        after = run(EVENT_COUNT, received, [&](int i) {
+            String json = makePayload();
+            return queue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, makeInsightId(i), std::move(json));
+        });
+        queue.end();
+    }
+    TEST_ASSERT_EQUAL(PAYLOAD_SIZE, lastLength);
+
+    TEST_ASSERT_EQUAL(0, before.rejected);
+    TEST_ASSERT_EQUAL(0, after.rejected);
+    printf("\n%d events with a %zu B payload, sizeof(LegacyEvent) %zu B, sizeof(Event) %zu B\n",
+           EVENT_COUNT, PAYLOAD_SIZE, sizeof(LegacyEvent), sizeof(Event));
+    printf("%-8s %14s %14s\n", "queue", "events/s", "B copied/event");
+    printf("%-8s %14.0f %14.1f\n", "before", before.eventsPerSecond, before.bytesCopiedPerEvent);
+    printf("%-8s %14.0f %14.1f\n", "after", after.eventsPerSecond, after.bytesCopiedPerEvent);
+
+    // The payload itself must no longer be duplicated on its way through
+    TEST_ASSERT_GREATER_THAN(PAYLOAD_SIZE, before.bytesCopiedPerEvent);
+    TEST_ASSERT_LESS_THAN(64, after.bytesCopiedPerEvent);
+    TEST_ASSERT_GREATER_THAN(before.eventsPerSecond, after.eventsPerSecond);
+}
+
+void test_idle_and_burst() {
+    std::atomic<int> received{0};
+
+    LoopResult before;
+    {
+        LegacyEventQueue legacy;
+        legacy.subscribe([&](const LegacyEvent& event) {
+            received++;
+        });
+        legacy.begin();
+        before = runBursts(received, [&](int i) {
+            return legacy.publishEvent(EventType::INSIGHT_DATA_RECEIVED, makeInsightId(i), String());
+        });
+        legacy.end();
+    }
+
+    received = 0;
+    LoopResult after;
+    {
+        EventQueue queue;
+        EventSubscription subscription = queue.subscribe(EventType::INSIGHT_DATA_RECEIVED, [&](const Event& event) {
+            received++;
+        });
+        queue.begin();
+        after = runBursts(received, [&](int i) {
+            return queue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, makeInsightId(i));
+        });
+        queue.end();
+    }
+
+    TEST_ASSERT_EQUAL(0, before.rejected);
+    TEST_ASSERT_EQUAL(0, after.rejected);
+    printf("\n%d ms idle, then %d bursts of %d events\n", IDLE_MS, BURST_COUNT, BURST_SIZE);
+    printf("%-8s %14s %14s %14s\n", "loop", "idle wakeups/s", "events/s", "wakeups/burst");
+    printf("%-8s %14.1f %14.0f %14.1f\n", "before", before.idleWakeupsPerSecond, before.eventsPerSecond,
+           before.wakeupsPerBurst);
+    printf("%-8s %14.1f %14.0f %14.1f\n", "after", after.idleWakeupsPerSecond, after.eventsPerSecond,
+           after.wakeupsPerBurst);
+
+    // An idle bus must not wake the event task at all
+    TEST_ASSERT_GREATER_THAN(5, before.idleWakeupsPerSecond);
+    TEST_ASSERT_EQUAL(0, after.idleWakeupsPerSecond);
+    TEST_ASSERT_GREATER_THAN(before.eventsPerSecond, after.eventsPerSecond);
+    TEST_ASSERT_LESS_THAN(before.wakeupsPerBurst, after.wakeupsPerBurst);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_payload_transport);
+    RUN_TEST(test_idle_and_burst);
+    return UNITY_END();
+}
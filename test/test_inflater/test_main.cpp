@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include "net/Inflater.h"
+#include "parsers/ParserArena.h"
+#include "../fixtures/Fixtures.h"
+
+// Inflater against zlib's output for the same corpus at every level and
+// strategy, plus hand-made broken streams. test/fixtures/gzip/make_fixtures.py
+// regenerates the compressed files.
+
+static const char* COMPRESSED[] = {
+    "gzip/stored.gz", "gzip/fast.gz", "gzip/default.gz", "gzip/best.gz", "gzip/filtered.gz",
+    "gzip/huffman_only.gz", "gzip/rle.gz", "gzip/fixed.gz", "gzip/small_window.gz", "gzip/named.gz",
+};
+
+struct Inflated {
+    std::string body;
+    bool finished;
+    bool failed;
+};
+
+// Feed input a few bytes per source call and read it back in chunks of
+// read_size, so block and match boundaries land mid-read
+static Inflated inflate(const std::string& input, bool gzip = true, size_t read_size = 1000) {
+    size_t pos = 0;
+    Inflater inflater([&](uint8_t* buffer, size_t length) {
+        size_t count = std::min({length, input.size() - pos, static_cast<size_t>(7)});
+        memcpy(buffer, input.data() + pos, count);
+        pos += count;
+        return count;
+    }, gzip);
+
+    Inflated result;
+    uint8_t buffer[4096];
+    size_t want = std::min(read_size, sizeof(buffer));
+    size_t read;
+    do {
+        read = inflater.read(buffer, want);
+        result.body.append(reinterpret_cast<char*>(buffer), read);
+    } while (read == want);
+    result.finished = inflater.finished();
+    result.failed = inflater.failed();
+    return result;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_matches_zlib() {
+    std::string corpus = loadFixture("gzip/corpus.txt");
+    TEST_ASSERT_GREATER_THAN(Inflater::WINDOW_SIZE, corpus.size());
+
+    for (const char* name : COMPRESSED) {
+        std::string compressed = loadFixture(name);
+        TEST_ASSERT_FALSE_MESSAGE(compressed.empty(), name);
+        for (size_t read_size : {1, 1000, 4096}) {
+            Inflated result = inflate(compressed, true, read_size);
+            TEST_ASSERT_TRUE_MESSAGE(result.finished, name);
+            TEST_ASSERT_FALSE_MESSAGE(result.failed, name);
+            TEST_ASSERT_TRUE_MESSAGE(result.body == corpus, name);
+        }
+    }
+}
+
+void test_raw_deflate() {
+    std::string corpus = loadFixture("gzip/corpus.txt");
+    Inflated result = inflate(loadFixture("gzip/raw.deflate"), false);
+    TEST_ASSERT_TRUE(result.finished);
+    TEST_ASSERT_TRUE(result.body == corpus);
+}
+
+void test_rejects_corrupt_gzip() {
+    std::string good = loadFixture("gzip/default.gz");
+    TEST_ASSERT_FALSE(good.empty());
+
+    std::string bad_magic = good;
+    bad_magic[0] = 0x1e;
+    TEST_ASSERT_TRUE(inflate(bad_magic).failed);
+
+    // The trailer is the CRC-32, then the length
+    std::string bad_crc = good;
+    bad_crc[good.size() - 8] ^= 0x01;
+    TEST_ASSERT_TRUE(inflate(bad_crc).failed);
+
+    std::string bad_length = good;
+    bad_length[good.size() - 4] ^= 0x01;
+    TEST_ASSERT_TRUE(inflate(bad_length).failed);
+
+    for (size_t cut : {good.size() / 2, good.size() - 1}) {
+        Inflated truncated = inflate(good.substr(0, cut));
+        TEST_ASSERT_TRUE(truncated.failed);
+        TEST_ASSERT_FALSE(truncated.finished);
+    }
+}
+
+void test_rejects_malformed_deflate() {
+    // Block type 3 is reserved
+    TEST_ASSERT_TRUE(inflate(std::string("\x07", 1), false).failed);
+    // Stored block whose length and its complement disagree
+    TEST_ASSERT_TRUE(inflate(std::string("\x01\x05\x00\x00\x00", 5), false).failed);
+    // Fixed-code block opening with a match, which has nothing to copy from
+    TEST_ASSERT_TRUE(inflate(std::string("\x03\x02\x00", 3), false).failed);
+}
+
+void test_window_from_arena() {
+    std::string compressed = loadFixture("gzip/fast.gz");
+    size_t pos = 0;
+    auto source = [&](uint8_t* buffer, size_t length) {
+        size_t count = std::min(length, compressed.size() - pos);
+        memcpy(buffer, compressed.data() + pos, count);
+        pos += count;
+        return count;
+    };
+
+    // With one idle window in the arena, an inflater takes that one
+    ParserArena& arena = ParserArena::instance();
+    void* idle = arena.acquire(Inflater::WINDOW_SIZE);
+    arena.release(idle);
+    {
+        Inflater inflater(source);
+        void* other = arena.acquire(Inflater::WINDOW_SIZE);
+        TEST_ASSERT_TRUE(other != idle);
+        arena.release(other);
+    }
+
+    // and gives it back when it's done
+    void* reused = arena.acquire(Inflater::WINDOW_SIZE);
+    TEST_ASSERT_EQUAL_PTR(idle, reused);
+    arena.release(reused);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_zlib);
+    RUN_TEST(test_raw_deflate);
+    RUN_TEST(test_rejects_corrupt_gzip);
+    RUN_TEST(test_rejects_malformed_deflate);
+    RUN_TEST(test_window_from_arena);
+    return UNITY_END();
+}
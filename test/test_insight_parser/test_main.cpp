@@ -0,0 +1,542 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "parsers/InsightParser.h"
+#include "InsightSnapshot.h"
+#include "SnapshotStore.h"
+#include "../fixtures/Fixtures.h"
+
+using InsightType = InsightParser::InsightType;
+
+void setUp() {}
+void tearDown() {}
+
+// --- Type detection ---
+
+void test_detects_types() {
+    struct { const char* fixture; InsightType type; } cases[] = {
+        {"numeric_legacy.json", InsightType::NUMERIC_CARD},
+        {"numeric_hogql.json", InsightType::NUMERIC_CARD},
+        {"trend_line.json", InsightType::LINE_GRAPH},
+        {"trend_line_year.json", InsightType::LINE_GRAPH},
+        {"area_hogql.json", InsightType::AREA_CHART},
+        {"trend_multi.json", InsightType::LINE_GRAPH},
+        {"trend_compare.json", InsightType::AREA_CHART},
+        {"funnel.json", InsightType::FUNNEL},
+        {"funnel_breakdown.json", InsightType::FUNNEL},
+        {"funnel_unpopulated.json", InsightType::FUNNEL},
+    };
+    for (const auto& c : cases) {
+        std::string json = loadFixture(c.fixture);
+        InsightParser parser(json.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(parser.isValid(), c.fixture);
+        TEST_ASSERT_EQUAL_MESSAGE((int)c.type, (int)parser.getInsightType(), c.fixture);
+    }
+}
+
+void test_rejects_non_insights() {
+    InsightParser not_json("{\"results\": [");
+    TEST_ASSERT_FALSE(not_json.isValid());
+
+    InsightParser no_results("{\"count\": 0, \"results\": []}");
+    TEST_ASSERT_FALSE(no_results.isValid());
+
+    InsightParser no_signature("{\"results\": [{\"name\": \"x\"}]}");
+    TEST_ASSERT_FALSE(no_signature.isValid());
+}
+
+// --- Numeric cards ---
+
+void test_numeric_legacy() {
+    std::string json = loadFixture("numeric_legacy.json");
+    InsightParser parser(json.c_str());
+
+    char name[64];
+    TEST_ASSERT_TRUE(parser.getName(name, sizeof(name)));
+    TEST_ASSERT_EQUAL_STRING("Weekly active users", name);
+    TEST_ASSERT_EQUAL_DOUBLE(18342.0, parser.getNumericCardValue());
+
+    char suffix[16];
+    TEST_ASSERT_TRUE(parser.getNumericFormattingSuffix(suffix, sizeof(suffix)));
+    TEST_ASSERT_EQUAL_STRING(" users", suffix);
+}
+
+void test_numeric_hogql() {
+    std::string json = loadFixture("numeric_hogql.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_EQUAL_DOUBLE(48210.75, parser.getNumericCardValue());
+    char prefix[16];
+    TEST_ASSERT_TRUE(parser.getNumericFormattingPrefix(prefix, sizeof(prefix)));
+    TEST_ASSERT_EQUAL_STRING("$", prefix);
+
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL_DOUBLE(48210.75, snapshot.numeric_value);
+    TEST_ASSERT_EQUAL_STRING("$", snapshot.prefix);
+    TEST_ASSERT_EQUAL_STRING("Revenue this month", snapshot.title);
+}
+
+// --- Trends ---
+
+void test_trend_series() {
+    std::string json = loadFixture("trend_line.json");
+    InsightParser parser(json.c_str());
+
+    size_t count = parser.getSeriesPointCount();
+    TEST_ASSERT_EQUAL(30, count);
+    std::vector<double> values(count);
+    TEST_ASSERT_TRUE(parser.getSeriesYValues(values.data()));
+
+    char label[8];
+    TEST_ASSERT_TRUE(parser.getSeriesXLabel(0, label, sizeof(label)));
+    TEST_ASSERT_EQUAL_STRING("2024-06", label);
+
+    // The snapshot holds the same points, and their full dates
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL(1, snapshot.series_count);
+    TEST_ASSERT_EQUAL(count, snapshot.pointCount());
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((float)values[i], snapshot.seriesValues(0)[i]);
+    }
+    TEST_ASSERT_EQUAL_STRING("2024-06-01", snapshot.xLabel(0));
+    TEST_ASSERT_EQUAL_STRING("2024-06-30", snapshot.xLabel(29));
+    TEST_ASSERT_EQUAL_STRING("", snapshot.xLabel(30));
+}
+
+void test_area_series() {
+    std::string json = loadFixture("area_hogql.json");
+    InsightParser parser(json.c_str());
+
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL((int)InsightType::AREA_CHART, (int)snapshot.type);
+    TEST_ASSERT_EQUAL(14, snapshot.pointCount());
+}
+
+void test_multi_series() {
+    std::string json = loadFixture("trend_multi.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_EQUAL(3, parser.getSeriesCount());
+    size_t count = parser.getSeriesPointCount();
+    TEST_ASSERT_EQUAL(30, count);
+    std::vector<double> signups(count);
+    TEST_ASSERT_TRUE(parser.getSeriesYValues(signups.data(), 2));
+    TEST_ASSERT_EQUAL_DOUBLE(37.0, signups[0]);
+    TEST_ASSERT_FALSE(parser.getSeriesYValues(signups.data(), 3));
+
+    char name[24];
+    TEST_ASSERT_TRUE(parser.getSeriesName(1, name, sizeof(name)));
+    TEST_ASSERT_EQUAL_STRING("Clicks", name);
+    char label[8];
+    TEST_ASSERT_TRUE(parser.getSeriesXLabel(29, label, sizeof(label)));
+    TEST_ASSERT_EQUAL_STRING("2024-06", label);
+
+    // The range spans every series: signups are far below pageviews
+    double low, high;
+    parser.getSeriesRange(&low, &high);
+    TEST_ASSERT_TRUE(low < 100.0);
+    TEST_ASSERT_TRUE(high > 1000.0);
+
+    // Columns back to back, against one set of dates
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL(3, snapshot.series_count);
+    TEST_ASSERT_EQUAL(count, snapshot.pointCount());
+    TEST_ASSERT_EQUAL(3 * count, snapshot.values.size());
+    TEST_ASSERT_EQUAL_PTR(snapshot.seriesValues(0) + count, snapshot.seriesValues(1));
+    TEST_ASSERT_NULL(snapshot.seriesValues(3));
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((float)signups[i], snapshot.seriesValues(2)[i]);
+    }
+    TEST_ASSERT_EQUAL_STRING("$pageview", snapshot.series_names[0]);
+    TEST_ASSERT_EQUAL_STRING("user signed up", snapshot.series_names[2]);
+    TEST_ASSERT_EQUAL(0, snapshot.previous_period);
+    TEST_ASSERT_EQUAL_STRING("2024-06-01", snapshot.xLabel(0));
+    TEST_ASSERT_EQUAL_STRING("2024-06-30", snapshot.xLabel(29));
+}
+
+void test_compare_series() {
+    std::string json = loadFixture("trend_compare.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_EQUAL(2, parser.getSeriesCount());
+    TEST_ASSERT_FALSE(parser.isPreviousPeriodSeries(0));
+    TEST_ASSERT_TRUE(parser.isPreviousPeriodSeries(1));
+
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL((int)InsightType::AREA_CHART, (int)snapshot.type);
+    TEST_ASSERT_EQUAL(2, snapshot.series_count);
+    TEST_ASSERT_EQUAL(14, snapshot.pointCount());
+    TEST_ASSERT_EQUAL(0x2, snapshot.previous_period);
+    // The previous period is drawn against the current period's dates
+    TEST_ASSERT_EQUAL_STRING("2024-06-01", snapshot.xLabel(0));
+    TEST_ASSERT_EQUAL_FLOAT(409.0f, snapshot.seriesValues(1)[0]);
+}
+
+// --- Funnels ---
+
+void test_funnel_flat() {
+    std::string json = loadFixture("funnel.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_EQUAL(4, parser.getFunnelStepCount());
+    TEST_ASSERT_EQUAL(1, parser.getFunnelBreakdownCount());
+
+    uint32_t window = 0;
+    TEST_ASSERT_TRUE(parser.getFunnelTimeWindow(&window));
+    TEST_ASSERT_EQUAL(14, window);
+
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL(4, snapshot.funnel_steps);
+    TEST_ASSERT_EQUAL(1, snapshot.funnel_breakdowns);
+    // Custom names win over event names
+    TEST_ASSERT_EQUAL_STRING("Landing", snapshot.step_names[0]);
+    TEST_ASSERT_EQUAL_STRING("signup started", snapshot.step_names[1]);
+    TEST_ASSERT_EQUAL_STRING("Activated", snapshot.step_names[3]);
+    const uint32_t totals[] = {5000, 2100, 1400, 610};
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(totals, snapshot.step_totals, 4);
+    TEST_ASSERT_EQUAL_UINT32(610, snapshot.breakdown_counts[3][0]);
+}
+
+void test_funnel_breakdown() {
+    std::string json = loadFixture("funnel_breakdown.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_EQUAL(3, parser.getFunnelBreakdownCount());
+    char breakdown[32];
+    TEST_ASSERT_TRUE(parser.getFunnelBreakdownName(1, breakdown, sizeof(breakdown)));
+    TEST_ASSERT_EQUAL_STRING("Safari", breakdown);
+
+    uint32_t window = 0;
+    TEST_ASSERT_TRUE(parser.getFunnelTimeWindow(&window));
+    TEST_ASSERT_EQUAL(14, window);
+
+    // The single-walk extraction agrees with the per-step getters
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL(4, snapshot.funnel_steps);
+    TEST_ASSERT_EQUAL(3, snapshot.funnel_breakdowns);
+    uint32_t totals[5] = {};
+    TEST_ASSERT_TRUE(parser.getFunnelTotalCounts(0, totals, nullptr));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(totals, snapshot.step_totals, 4);
+    for (size_t step = 0; step < 4; step++) {
+        uint32_t per_breakdown[5] = {};
+        TEST_ASSERT_TRUE(parser.getFunnelBreakdownComparison(step, per_breakdown, nullptr));
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(per_breakdown, snapshot.breakdown_counts[step], 3);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5000, snapshot.step_totals[0]);
+    TEST_ASSERT_EQUAL_UINT32(150, snapshot.breakdown_counts[3][1]);
+}
+
+void test_funnel_unpopulated() {
+    std::string json = loadFixture("funnel_unpopulated.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_TRUE(parser.hasEmptyResult());
+    // Steps come from the filters: two events, then an action
+    TEST_ASSERT_EQUAL(3, parser.getFunnelStepCount());
+    char name[48];
+    TEST_ASSERT_TRUE(parser.getFunnelStepData(0, 2, name, sizeof(name), nullptr, nullptr, nullptr));
+    TEST_ASSERT_EQUAL_STRING("Checkout paid", name);
+}
+
+// --- Async refreshes ---
+
+void test_pending_query() {
+    std::string json = loadFixture("async_pending.json");
+    InsightParser parser(json.c_str());
+
+    TEST_ASSERT_TRUE(parser.isValid());
+    TEST_ASSERT_TRUE(parser.hasEmptyResult());
+    char query_id[64];
+    TEST_ASSERT_TRUE(parser.getPendingQuery(query_id, sizeof(query_id)));
+    TEST_ASSERT_EQUAL_STRING("0197a3c5-2f1e-7c4b-9d3a-5e6f7a8b9c0d", query_id);
+
+    // The query ID differs on every refresh, so it mustn't change the hash
+    std::string without_status = loadFixture("async_pending.json");
+    size_t status = without_status.find("\"query_status\"");
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, status);
+    without_status.replace(status, strlen("\"query_status\""), "\"unrelated_key\"");
+    InsightParser other(without_status.c_str());
+    TEST_ASSERT_EQUAL_UINT32(other.contentHash(), parser.contentHash());
+}
+
+// --- Filters ---
+
+void test_prescan_picks_filter() {
+    // Rows and breakdowns only keep with the general filter, which the
+    // parse reports for the next one
+    struct { const char* fixture; InsightType prescan; InsightType next; } cases[] = {
+        {"numeric_legacy.json", InsightType::NUMERIC_CARD, InsightType::NUMERIC_CARD},
+        {"numeric_hogql.json", InsightType::NUMERIC_CARD, InsightType::NUMERIC_CARD},
+        {"trend_line.json", InsightType::LINE_GRAPH, InsightType::INSIGHT_NOT_SUPPORTED},
+        {"area_hogql.json", InsightType::LINE_GRAPH, InsightType::INSIGHT_NOT_SUPPORTED},
+        {"trend_multi.json", InsightType::LINE_GRAPH, InsightType::LINE_GRAPH},
+        {"funnel.json", InsightType::FUNNEL, InsightType::FUNNEL},
+        {"funnel_breakdown.json", InsightType::FUNNEL, InsightType::INSIGHT_NOT_SUPPORTED},
+    };
+    for (const auto& c : cases) {
+        std::string json = loadFixture(c.fixture);
+        TEST_ASSERT_EQUAL_MESSAGE((int)c.prescan, (int)InsightParser::prescan(json.c_str()), c.fixture);
+        InsightParser parser(json.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(parser.isValid(), c.fixture);
+        TEST_ASSERT_EQUAL_MESSAGE((int)c.next, (int)parser.filterType(), c.fixture);
+    }
+}
+
+void test_typed_filter_matches_general() {
+    const char* fixtures[] = {"numeric_legacy.json", "numeric_hogql.json", "trend_line.json", "area_hogql.json",
+                              "trend_multi.json", "trend_compare.json", "funnel.json", "funnel_breakdown.json"};
+    for (const char* fixture : fixtures) {
+        std::string json = loadFixture(fixture);
+        InsightParser typed(json.c_str());
+        InsightParser general(json.c_str(), InsightType::INSIGHT_NOT_SUPPORTED);
+
+        // Same snapshot from a smaller document
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(general.memoryUsed(), typed.memoryUsed(), fixture);
+        InsightSnapshot a = InsightSnapshot::fromParser(typed);
+        InsightSnapshot b = InsightSnapshot::fromParser(general);
+        std::vector<uint8_t> encoded_a(a.encodedSize());
+        std::vector<uint8_t> encoded_b(b.encodedSize());
+        a.encode(encoded_a.data(), encoded_a.size());
+        b.encode(encoded_b.data(), encoded_b.size());
+        TEST_ASSERT_TRUE_MESSAGE(encoded_a == encoded_b, fixture);
+    }
+}
+
+void test_filter_mismatch() {
+    // A funnel parsed with the filter its last parse as a trend called for
+    std::string json = loadFixture("funnel.json");
+    InsightParser parser(json.c_str(), InsightType::LINE_GRAPH);
+    TEST_ASSERT_FALSE(parser.isValid());
+    TEST_ASSERT_TRUE(parser.filterMismatch());
+    TEST_ASSERT_FALSE(parser.outOfMemory());
+
+    // Same type, but rows and breakdowns don't survive a typed filter
+    struct { const char* fixture; InsightType filter; } cases[] = {
+        {"trend_line.json", InsightType::LINE_GRAPH},
+        {"funnel_breakdown.json", InsightType::FUNNEL},
+    };
+    for (const auto& c : cases) {
+        std::string rows = loadFixture(c.fixture);
+        InsightParser typed(rows.c_str(), c.filter);
+        TEST_ASSERT_FALSE_MESSAGE(typed.isValid(), c.fixture);
+        TEST_ASSERT_TRUE_MESSAGE(typed.filterMismatch(), c.fixture);
+        TEST_ASSERT_EQUAL_MESSAGE((int)InsightType::INSIGHT_NOT_SUPPORTED, (int)typed.filterType(), c.fixture);
+    }
+}
+
+// --- Downsampling ---
+
+// Where each point of a downsampled snapshot sat in the full one, found
+// by date; fails the test if a point isn't an original one or is out of order
+static std::vector<size_t> keptIndices(const InsightSnapshot& full, const InsightSnapshot& reduced) {
+    std::vector<size_t> indices;
+    size_t index = 0;
+    for (size_t k = 0; k < reduced.pointCount(); k++) {
+        while (index < full.pointCount() && strcmp(full.xLabel(index), reduced.xLabel(k)) != 0) {
+            index++;
+        }
+        TEST_ASSERT_LESS_THAN(full.pointCount(), index);
+        indices.push_back(index++);
+    }
+    return indices;
+}
+
+void test_downsample_keeps_peaks() {
+    std::string json = loadFixture("trend_line_year.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot full = InsightSnapshot::fromParser(parser);
+    TEST_ASSERT_EQUAL(365, full.pointCount());
+
+    size_t widths[] = {InsightSnapshot::MAX_CHART_POINTS, 60, 24};
+    for (size_t width : widths) {
+        InsightSnapshot reduced = full;
+        reduced.downsample(width);
+        TEST_ASSERT_EQUAL(width, reduced.pointCount());
+        TEST_ASSERT_EQUAL_STRING(full.xLabel(0), reduced.xLabel(0));
+        TEST_ASSERT_EQUAL_STRING(full.xLabel(364), reduced.xLabel(width - 1));
+
+        // Every point is an original one, with its own value
+        std::vector<size_t> kept = keptIndices(full, reduced);
+        for (size_t k = 0; k < kept.size(); k++) {
+            TEST_ASSERT_EQUAL_FLOAT(full.seriesValues(0)[kept[k]], reduced.seriesValues(0)[k]);
+        }
+
+        // The launch day spike survives even at 24 points
+        const float* values = reduced.seriesValues(0);
+        size_t peak = std::max_element(values, values + width) - values;
+        TEST_ASSERT_EQUAL_FLOAT(900.0f, values[peak]);
+        TEST_ASSERT_EQUAL_STRING("2023-12-18", reduced.xLabel(peak));
+    }
+}
+
+void test_downsample_tracks_line() {
+    std::string json = loadFixture("trend_line_year.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot full = InsightSnapshot::fromParser(parser);
+    InsightSnapshot reduced = full;
+    reduced.downsample(InsightSnapshot::MAX_CHART_POINTS);
+    std::vector<size_t> kept = keptIndices(full, reduced);
+
+    // The line the chart draws through the kept points stays, on average,
+    // within 1% of the value range of the one through every point
+    const float* original = full.seriesValues(0);
+    const float* values = reduced.seriesValues(0);
+    double low = *std::min_element(original, original + full.pointCount());
+    double high = *std::max_element(original, original + full.pointCount());
+    double error = 0.0;
+    size_t k = 0;
+    for (size_t i = 0; i < full.pointCount(); i++) {
+        while (kept[k + 1] < i) k++;
+        double t = static_cast<double>(i - kept[k]) / (kept[k + 1] - kept[k]);
+        error += fabs(values[k] + t * (values[k + 1] - values[k]) - original[i]);
+    }
+    TEST_ASSERT_TRUE(error / full.pointCount() / (high - low) < 0.01);
+}
+
+void test_downsample_multi_series() {
+    std::string json = loadFixture("trend_multi.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot full = InsightSnapshot::fromParser(parser);
+    InsightSnapshot reduced = full;
+    reduced.downsample(12);
+
+    // One choice of points for every series, so each keeps its shared date
+    TEST_ASSERT_EQUAL(3, reduced.series_count);
+    TEST_ASSERT_EQUAL(12, reduced.pointCount());
+    TEST_ASSERT_EQUAL(3 * 12, reduced.values.size());
+    std::vector<size_t> kept = keptIndices(full, reduced);
+    for (size_t series = 0; series < 3; series++) {
+        for (size_t k = 0; k < kept.size(); k++) {
+            TEST_ASSERT_EQUAL_FLOAT(full.seriesValues(series)[kept[k]], reduced.seriesValues(series)[k]);
+        }
+    }
+}
+
+void test_downsample_leaves_short_series() {
+    std::string json = loadFixture("trend_line.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+
+    snapshot.downsample(InsightSnapshot::MAX_CHART_POINTS);
+    TEST_ASSERT_EQUAL(30, snapshot.pointCount());
+    snapshot.downsample(30);
+    TEST_ASSERT_EQUAL(30, snapshot.pointCount());
+    // Two points can't hold a triangle; asking for them changes nothing
+    snapshot.downsample(2);
+    TEST_ASSERT_EQUAL(30, snapshot.pointCount());
+}
+
+// --- Snapshots ---
+
+void test_snapshot_round_trip() {
+    const char* fixtures[] = {"numeric_hogql.json", "trend_line_year.json", "trend_compare.json", "funnel_breakdown.json"};
+    for (const char* fixture : fixtures) {
+        std::string json = loadFixture(fixture);
+        InsightParser parser(json.c_str());
+        InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+
+        std::vector<uint8_t> encoded(snapshot.encodedSize());
+        TEST_ASSERT_EQUAL_MESSAGE(encoded.size(), snapshot.encode(encoded.data(), encoded.size()), fixture);
+        InsightSnapshot decoded;
+        TEST_ASSERT_TRUE_MESSAGE(decoded.decode(encoded.data(), encoded.size()), fixture);
+        TEST_ASSERT_EQUAL_STRING(snapshot.title, decoded.title);
+        TEST_ASSERT_EQUAL(snapshot.series_count, decoded.series_count);
+        TEST_ASSERT_EQUAL(snapshot.previous_period, decoded.previous_period);
+        TEST_ASSERT_EQUAL(snapshot.pointCount(), decoded.pointCount());
+        for (size_t series = 0; series < snapshot.series_count; series++) {
+            TEST_ASSERT_EQUAL_STRING(snapshot.series_names[series], decoded.series_names[series]);
+            TEST_ASSERT_EQUAL_FLOAT_ARRAY(snapshot.seriesValues(series), decoded.seriesValues(series), snapshot.pointCount());
+        }
+        for (size_t i = 0; i < snapshot.pointCount(); i++) {
+            TEST_ASSERT_EQUAL_STRING(snapshot.xLabel(i), decoded.xLabel(i));
+        }
+        TEST_ASSERT_EQUAL(snapshot.funnel_steps, decoded.funnel_steps);
+
+        // Cut short anywhere, it reads as missing rather than garbage
+        TEST_ASSERT_FALSE(decoded.decode(encoded.data(), encoded.size() - 1));
+    }
+}
+
+static void assertRoundTrip(const InsightSnapshot& snapshot) {
+    std::vector<uint8_t> encoded(snapshot.encodedSize());
+    TEST_ASSERT_EQUAL(encoded.size(), snapshot.encode(encoded.data(), encoded.size()));
+    InsightSnapshot decoded;
+    TEST_ASSERT_TRUE(decoded.decode(encoded.data(), encoded.size()));
+    TEST_ASSERT_EQUAL(snapshot.series_count, decoded.series_count);
+    TEST_ASSERT_EQUAL(snapshot.pointCount(), decoded.pointCount());
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(snapshot.values.data(), decoded.values.data(), snapshot.values.size());
+    for (size_t i = 0; i < snapshot.pointCount(); i++) {
+        TEST_ASSERT_EQUAL_STRING(snapshot.xLabel(i), decoded.xLabel(i));
+    }
+}
+
+void test_snapshot_full_width_fits_store() {
+    // A year of four series with the longest names, reduced to chart width
+    std::string json = loadFixture("trend_line_year.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot year = InsightSnapshot::fromParser(parser);
+    InsightSnapshot snapshot = year;
+    snapshot.series_count = InsightSnapshot::MAX_SERIES;
+    snapshot.values.clear();
+    for (size_t series = 0; series < InsightSnapshot::MAX_SERIES; series++) {
+        for (size_t i = 0; i < year.pointCount(); i++) {
+            snapshot.values.push_back(year.seriesValues(0)[i] * (series + 1));
+        }
+        memset(snapshot.series_names[series], 'n', InsightSnapshot::SERIES_NAME_SIZE - 1);
+        snapshot.series_names[series][InsightSnapshot::SERIES_NAME_SIZE - 1] = '\0';
+    }
+    memset(snapshot.title, 't', sizeof(snapshot.title) - 1);
+    snapshot.title[sizeof(snapshot.title) - 1] = '\0';
+    snapshot.downsample(InsightSnapshot::MAX_CHART_POINTS);
+    TEST_ASSERT_EQUAL(InsightSnapshot::MAX_CHART_POINTS, snapshot.pointCount());
+
+    // A stored record adds a 12-byte header and the insight ID, well under 32 bytes
+    TEST_ASSERT_LESS_OR_EQUAL(SnapshotStore::MAX_RECORD_SIZE, 12 + 32 + snapshot.encodedSize());
+    assertRoundTrip(snapshot);
+}
+
+void test_snapshot_label_fallback() {
+    std::string json = loadFixture("trend_line.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot snapshot = InsightSnapshot::fromParser(parser);
+    size_t compact_size = snapshot.encodedSize();
+
+    // A label that isn't a date, or dates out of order, are kept as strings
+    strcpy(&snapshot.x_labels[3 * InsightSnapshot::LABEL_SIZE], "Week 23");
+    TEST_ASSERT_GREATER_THAN(compact_size, snapshot.encodedSize());
+    assertRoundTrip(snapshot);
+
+    snapshot = InsightSnapshot::fromParser(parser);
+    strcpy(&snapshot.x_labels[3 * InsightSnapshot::LABEL_SIZE], "2024-05-01");
+    assertRoundTrip(snapshot);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_detects_types);
+    RUN_TEST(test_rejects_non_insights);
+    RUN_TEST(test_numeric_legacy);
+    RUN_TEST(test_numeric_hogql);
+    RUN_TEST(test_trend_series);
+    RUN_TEST(test_area_series);
+    RUN_TEST(test_multi_series);
+    RUN_TEST(test_compare_series);
+    RUN_TEST(test_funnel_flat);
+    RUN_TEST(test_funnel_breakdown);
+    RUN_TEST(test_funnel_unpopulated);
+    RUN_TEST(test_pending_query);
+    RUN_TEST(test_prescan_picks_filter);
+    RUN_TEST(test_typed_filter_matches_general);
+    RUN_TEST(test_filter_mismatch);
+    RUN_TEST(test_downsample_keeps_peaks);
+    RUN_TEST(test_downsample_tracks_line);
+    RUN_TEST(test_downsample_multi_series);
+    RUN_TEST(test_downsample_leaves_short_series);
+    RUN_TEST(test_snapshot_round_trip);
+    RUN_TEST(test_snapshot_full_width_fits_store);
+    RUN_TEST(test_snapshot_label_fallback);
+    return UNITY_END();
+}
@@ -0,0 +1,200 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "parsers/InsightParser.h"
+#include "InsightSnapshot.h"
+#include "../fixtures/Fixtures.h"
+
+// Microbenchmarks for the parsing hot path. Timings are host timings, so
+// compare runs on the same machine rather than reading them as device
+// numbers. Document sizes run about twice the device's on a 64-bit host,
+// since ArduinoJson slots hold pointers.
+//
+// Assertions only catch regressions in direction, e.g. a type-specific
+// filter keeping more than the general one, or saving nothing on results
+// it trims. The figures are printed.
+
+using InsightType = InsightParser::InsightType;
+
+static const char* FIXTURES[] = {
+    "numeric_legacy.json", "numeric_hogql.json", "trend_line.json", "trend_line_year.json",
+    "area_hogql.json", "trend_multi.json", "trend_compare.json", "funnel.json", "funnel_breakdown.json",
+};
+
+// Results of series or step objects, which the typed filter trims field by
+// field; rows and breakdowns fall back to the general filter
+static const char* TRIMMED[] = {"numeric_legacy.json", "trend_multi.json", "trend_compare.json", "funnel.json"};
+
+static constexpr int PARSE_RUNS = 200;
+static constexpr int ACCESS_RUNS = 2000;
+
+// Average microseconds per call of run()
+template <typename Run>
+static double microsPerRun(int runs, Run&& run) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        run();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+// Heap a snapshot keeps for as long as a card shows it
+static size_t retainedBytes(const InsightSnapshot& snapshot) {
+    return sizeof(snapshot) + snapshot.values.capacity() * sizeof(float) + snapshot.x_labels.capacity();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_parse_time_and_document_size() {
+    printf("\n%-24s %8s %12s %12s %10s %10s %10s\n", "fixture", "body", "general us", "typed us", "general B", "typed B",
+           "saved");
+    for (const char* fixture : FIXTURES) {
+        std::string json = loadFixture(fixture);
+        TEST_ASSERT_FALSE_MESSAGE(json.empty(), fixture);
+
+        size_t general_used = 0;
+        size_t typed_used = 0;
+        double general_us = microsPerRun(PARSE_RUNS, [&] {
+            InsightParser parser(json.c_str(), InsightType::INSIGHT_NOT_SUPPORTED);
+            general_used = parser.memoryUsed();
+        });
+        // Includes the pre-scan, as on the device for string bodies
+        double typed_us = microsPerRun(PARSE_RUNS, [&] {
+            InsightParser parser(json.c_str());
+            typed_used = parser.memoryUsed();
+        });
+
+        double saved = 100.0 * (static_cast<double>(general_used) - typed_used) / general_used;
+        printf("%-24s %8zu %12.1f %12.1f %10zu %10zu %9.0f%%\n", fixture, json.size(), general_us, typed_us,
+               general_used, typed_used, saved);
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(general_used, typed_used, fixture);
+        for (const char* trimmed : TRIMMED) {
+            if (strcmp(trimmed, fixture) == 0) {
+                TEST_ASSERT_LESS_THAN_MESSAGE(general_used, typed_used, fixture);
+            }
+        }
+    }
+}
+
+void test_prescan_cost() {
+    std::string json = loadFixture("trend_line_year.json");
+    double prescan_us = microsPerRun(PARSE_RUNS, [&] {
+        InsightParser::prescan(json.c_str());
+    });
+    // What a stream parse saves by taking the type from the last parse
+    InsightType last = InsightParser(json.c_str()).filterType();
+    double typed_us = microsPerRun(PARSE_RUNS, [&] {
+        InsightParser parser(json.c_str(), last);
+    });
+    printf("\nprescan of trend_line_year.json: %.1f us, typed parse without it: %.1f us\n", prescan_us, typed_us);
+}
+
+void test_accessor_cost_series() {
+    std::string json = loadFixture("trend_line_year.json");
+    InsightParser parser(json.c_str());
+    size_t count = parser.getSeriesPointCount();
+    TEST_ASSERT_GREATER_THAN(0, count);
+
+    std::vector<double> values(count);
+    char label[8];
+    // What a renderer reading the parser directly would do
+    double getters_us = microsPerRun(ACCESS_RUNS / 10, [&] {
+        parser.getInsightType();
+        parser.getSeriesYValues(values.data());
+        for (size_t i = 0; i < count; i++) {
+            parser.getSeriesXLabel(i, label, sizeof(label));
+        }
+    });
+    InsightSnapshot snapshot;
+    double snapshot_us = microsPerRun(ACCESS_RUNS / 10, [&] {
+        snapshot = InsightSnapshot::fromParser(parser);
+    });
+
+    printf("\n%zu points: getters %.1f us, one-pass snapshot %.1f us, document %zu B, snapshot %zu B\n",
+           count, getters_us, snapshot_us, parser.memoryUsed(), retainedBytes(snapshot));
+    TEST_ASSERT_LESS_THAN(parser.memoryUsed(), retainedBytes(snapshot));
+}
+
+void test_accessor_cost_funnel() {
+    std::string json = loadFixture("funnel_breakdown.json");
+    InsightParser parser(json.c_str());
+    size_t steps = parser.getFunnelStepCount();
+    TEST_ASSERT_GREATER_THAN(0, steps);
+
+    char name[48];
+    uint32_t totals[InsightSnapshot::MAX_FUNNEL_STEPS] = {};
+    uint32_t per_breakdown[InsightSnapshot::MAX_BREAKDOWNS] = {};
+    double getters_us = microsPerRun(ACCESS_RUNS, [&] {
+        parser.getInsightType();
+        parser.getFunnelTotalCounts(0, totals, nullptr);
+        for (size_t step = 0; step < steps; step++) {
+            parser.getFunnelStepData(0, step, name, sizeof(name), nullptr, nullptr, nullptr);
+            parser.getFunnelBreakdownComparison(step, per_breakdown, nullptr);
+        }
+    });
+    InsightSnapshot snapshot;
+    double snapshot_us = microsPerRun(ACCESS_RUNS, [&] {
+        snapshot = InsightSnapshot::fromParser(parser);
+    });
+
+    printf("\n%zu steps x %u breakdowns: getters %.1f us, one-pass snapshot %.1f us, document %zu B, snapshot %zu B\n",
+           steps, snapshot.funnel_breakdowns, getters_us, snapshot_us, parser.memoryUsed(), retainedBytes(snapshot));
+    TEST_ASSERT_LESS_THAN(parser.memoryUsed(), retainedBytes(snapshot));
+}
+
+void test_downsample_cost() {
+    std::string json = loadFixture("trend_line_year.json");
+    InsightParser parser(json.c_str());
+    InsightSnapshot year = InsightSnapshot::fromParser(parser);
+
+    // A month of hours in every series the renderer can show
+    InsightSnapshot hourly;
+    hourly.series_count = InsightSnapshot::MAX_SERIES;
+    size_t hours = 30 * 24;
+    hourly.values.resize(hourly.series_count * hours);
+    for (size_t i = 0; i < hourly.values.size(); i++) {
+        hourly.values[i] = 100.0f + 50.0f * sinf(i / 12.0f) + (i * 7919 % 13);
+    }
+    hourly.x_labels.assign(hours * InsightSnapshot::LABEL_SIZE, '\0');
+
+    struct { const char* name; const InsightSnapshot* full; size_t width; } cases[] = {
+        {"365 days", &year, InsightSnapshot::MAX_CHART_POINTS},
+        {"365 days", &year, 60},
+        {"720 hours x 4 series", &hourly, InsightSnapshot::MAX_CHART_POINTS},
+    };
+    printf("\n%-22s %6s %6s %10s %10s %10s %10s %10s\n", "series", "points", "width", "us", "heap B", "reduced B", "flash B", "reduced B");
+    for (const auto& c : cases) {
+        InsightSnapshot reduced;
+        double downsample_us = microsPerRun(ACCESS_RUNS / 10, [&] {
+            reduced = *c.full;
+            reduced.downsample(c.width);
+        });
+        // Copying in is part of each run; time it alone to set it apart
+        double copy_us = microsPerRun(ACCESS_RUNS / 10, [&] {
+            reduced = *c.full;
+        });
+        reduced.downsample(c.width);
+
+        printf("%-22s %6zu %6zu %10.1f %10zu %10zu %10zu %10zu\n", c.name, c.full->pointCount(), c.width,
+               downsample_us - copy_us, retainedBytes(*c.full), retainedBytes(reduced), c.full->encodedSize(), reduced.encodedSize());
+        TEST_ASSERT_EQUAL(c.width, reduced.pointCount());
+        TEST_ASSERT_LESS_THAN(c.full->encodedSize(), reduced.encodedSize());
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_time_and_document_size);
+    RUN_TEST(test_prescan_cost);
+    RUN_TEST(test_accessor_cost_series);
+    RUN_TEST(test_accessor_cost_funnel);
+    RUN_TEST(test_downsample_cost);
+    return UNITY_END();
+}
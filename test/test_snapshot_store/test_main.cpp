@@ -0,0 +1,161 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "InsightSnapshot.h"
+#include "SnapshotStore.h"
+
+// A file in the project directory stands in for the partition
+static const char* FLASH_PATH = "test_snapshot_store.bin";
+static constexpr size_t FLASH_SIZE = 2 * SnapshotFlash::SECTOR_SIZE;  // One sector per bank
+static constexpr unsigned long LATER = SnapshotStore::MIN_REWRITE_INTERVAL;
+
+void setUp() {
+    remove(FLASH_PATH);
+}
+
+void tearDown() {
+    remove(FLASH_PATH);
+}
+
+static InsightSnapshot numericSnapshot(const char* title, double value) {
+    InsightSnapshot snapshot;
+    snapshot.type = InsightParser::InsightType::NUMERIC_CARD;
+    snprintf(snapshot.title, sizeof(snapshot.title), "%s", title);
+    snapshot.numeric_value = value;
+    return snapshot;
+}
+
+static double loadedValue(const SnapshotStore& store, const char* insight_id) {
+    InsightSnapshot snapshot;
+    return store.load(insight_id, snapshot) ? snapshot.numeric_value : -1.0;
+}
+
+// Flip one byte of the file, as a torn write or a worn cell would
+static void corruptByte(size_t offset) {
+    FILE* file = fopen(FLASH_PATH, "r+b");
+    TEST_ASSERT_TRUE(file != nullptr);
+    fseek(file, static_cast<long>(offset), SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, static_cast<long>(offset), SEEK_SET);
+    fputc(byte ^ 0x5A, file);
+    fclose(file);
+}
+
+void test_save_and_load() {
+    {
+        SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+        SnapshotStore store(flash);
+        TEST_ASSERT_TRUE(store.begin());
+        TEST_ASSERT_EQUAL(0, store.size());
+
+        TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", 12), 0));
+        TEST_ASSERT_TRUE(store.save("def", numericSnapshot("Revenue", 34), 0));
+        TEST_ASSERT_EQUAL(2, store.size());
+        TEST_ASSERT_EQUAL_DOUBLE(12, loadedValue(store, "abc"));
+        TEST_ASSERT_EQUAL_DOUBLE(34, loadedValue(store, "def"));
+        TEST_ASSERT_EQUAL_DOUBLE(-1, loadedValue(store, "missing"));
+
+        // Throttled, then skipped as unchanged, then appended
+        TEST_ASSERT_FALSE(store.save("abc", numericSnapshot("Signups", 13), 1));
+        TEST_ASSERT_FALSE(store.save("abc", numericSnapshot("Signups", 12), LATER));
+        TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", 13), LATER));
+        TEST_ASSERT_EQUAL_DOUBLE(13, loadedValue(store, "abc"));
+    }
+
+    // After a reboot the newest record of each insight wins
+    SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore store(flash);
+    TEST_ASSERT_TRUE(store.begin());
+    TEST_ASSERT_EQUAL(2, store.size());
+    TEST_ASSERT_EQUAL_DOUBLE(13, loadedValue(store, "abc"));
+    TEST_ASSERT_EQUAL_DOUBLE(34, loadedValue(store, "def"));
+}
+
+void test_bank_swap() {
+    SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore store(flash);
+    TEST_ASSERT_TRUE(store.begin());
+    uint32_t erases_at_start = flash.eraseCount();
+
+    // Enough rewrites to fill a bank several times over
+    const int rounds = 300;
+    for (int i = 1; i <= rounds; i++) {
+        TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", i), i * LATER));
+        TEST_ASSERT_TRUE(store.save("def", numericSnapshot("Revenue", -i), i * LATER));
+    }
+    TEST_ASSERT_GREATER_THAN(erases_at_start + 1, flash.eraseCount());
+    TEST_ASSERT_EQUAL(2, store.size());
+    TEST_ASSERT_EQUAL_DOUBLE(rounds, loadedValue(store, "abc"));
+    TEST_ASSERT_EQUAL_DOUBLE(-rounds, loadedValue(store, "def"));
+
+    // Whichever bank ended up active is found again after a reboot
+    SnapshotFlash reopened_flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore reopened(reopened_flash);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL(2, reopened.size());
+    TEST_ASSERT_EQUAL_DOUBLE(rounds, loadedValue(reopened, "abc"));
+    TEST_ASSERT_EQUAL_DOUBLE(-rounds, loadedValue(reopened, "def"));
+}
+
+void test_rejects_bad_crc() {
+    {
+        SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+        SnapshotStore store(flash);
+        TEST_ASSERT_TRUE(store.begin());
+        TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", 12), 0));
+        TEST_ASSERT_TRUE(store.save("def", numericSnapshot("Revenue", 34), 0));
+    }
+
+    // The first record follows the 16-byte bank header; hit its payload,
+    // past the 12-byte record header and the 3-byte ID
+    corruptByte(16 + 12 + 3 + 4);
+
+    SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore store(flash);
+    TEST_ASSERT_TRUE(store.begin());
+    TEST_ASSERT_EQUAL(1, store.size());
+    TEST_ASSERT_EQUAL_DOUBLE(-1, loadedValue(store, "abc"));
+    TEST_ASSERT_EQUAL_DOUBLE(34, loadedValue(store, "def"));
+
+    // The log goes on after the bad record
+    TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", 15), 0));
+    TEST_ASSERT_EQUAL_DOUBLE(15, loadedValue(store, "abc"));
+}
+
+void test_retain() {
+    SnapshotFlash flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore store(flash);
+    TEST_ASSERT_TRUE(store.begin());
+    TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", 12), 0));
+    TEST_ASSERT_TRUE(store.save("def", numericSnapshot("Revenue", 34), 0));
+    TEST_ASSERT_TRUE(store.save("ghi", numericSnapshot("Churn", 56), 0));
+
+    store.retain({"abc", "ghi"});
+    TEST_ASSERT_EQUAL(2, store.size());
+    TEST_ASSERT_EQUAL_DOUBLE(-1, loadedValue(store, "def"));
+    TEST_ASSERT_EQUAL_DOUBLE(56, loadedValue(store, "ghi"));
+
+    // Rewrite until the bank compacts; the dropped insight isn't copied over
+    uint32_t erases = flash.eraseCount();
+    for (int i = 1; flash.eraseCount() == erases; i++) {
+        TEST_ASSERT_TRUE(i < 1000);
+        TEST_ASSERT_TRUE(store.save("abc", numericSnapshot("Signups", i), i * LATER));
+    }
+
+    SnapshotFlash reopened_flash(FLASH_PATH, FLASH_SIZE);
+    SnapshotStore reopened(reopened_flash);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL(2, reopened.size());
+    TEST_ASSERT_EQUAL_DOUBLE(-1, loadedValue(reopened, "def"));
+    TEST_ASSERT_EQUAL_DOUBLE(56, loadedValue(reopened, "ghi"));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_save_and_load);
+    RUN_TEST(test_bank_swap);
+    RUN_TEST(test_rejects_bad_crc);
+    RUN_TEST(test_retain);
+    return UNITY_END();
+}